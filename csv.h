@@ -0,0 +1,309 @@
+#ifndef TAM_CSV_H
+#define TAM_CSV_H
+
+// TAM CSV reader
+//
+// Zero-copy parsing of CSV and TSV data held in a slice into rows of field slices.
+
+#include <limits.h>
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## CSV declarations *** {{{
+/*
+ * The reader follows RFC 4180: fields are separated by a delimiter and rows by `\n` or `\r\n`, and a field
+ * may be enclosed in double quotes, in which case it can contain delimiters, newlines and quotes doubled as `""`.
+ *
+ * Parsing happens in two stages. Stage 1 looks at 64 bytes at a time, building bitmasks of the quotes,
+ * delimiters and newlines with vector compares. The quoted regions are found with a prefix XOR of the quote
+ * mask (a single carry-less multiply with PCLMUL), and the positions of the delimiters and newlines outside
+ * of them are written to an index. Stage 2 walks the index and emits a slice for each field.
+ * Fields point into the input, except for quoted fields containing `""`, which are unescaped into the arena.
+ * The input must outlive the result.
+ */
+typedef struct tam_csv_t {
+    // all fields, row by row
+    tam_slice_t *fields;
+    // rows[i] is the index in `fields` of the first field of row i, and rows[num_rows] == num_fields
+    int *rows;
+    int num_rows;
+    int num_fields;
+} tam_csv_t;
+
+// Longest input that can be parsed. Field positions are stored as u32 and counts as int, and a row
+// can have one more field than it has delimiters.
+#define TAM_CSV_MAX_LEN (INT_MAX - 1)
+
+/*
+ * Parse CSV (or, with `delimiter` '\t', TSV) data. The fields and row index are allocated in `arena`,
+ * which needs room for about 20 bytes per field plus the length of any quoted field that needs unescaping.
+ * A trailing newline does not start a new row, and an empty line is a row with a single empty field.
+ * Returns false, leaving `csv` empty, if the input ends inside a quoted field, if it is longer than
+ * TAM_CSV_MAX_LEN bytes, or if `delimiter` is one of `"`, `\n` and `\r`, which would make the splits ambiguous.
+ */
+bool tam_csv_parse(tam_csv_t *csv, tam_slice_t input, char delimiter, tam_arena_t *arena);
+
+/*
+ * Number of fields in a row of a parsed CSV
+ */
+int tam_csv_num_cols(const tam_csv_t *csv, int row);
+
+/*
+ * Get the field in column `col` of row `row` of a parsed CSV.
+ */
+tam_slice_t tam_csv_get(const tam_csv_t *csv, int row, int col);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_CSV) ///{{{
+typedef tam_csv_t csv_t;
+#define csv_parse tam_csv_parse
+#define CSV_MAX_LEN TAM_CSV_MAX_LEN
+#define csv_num_cols tam_csv_num_cols
+#define csv_get tam_csv_get
+#endif // end CSV namespace }}}
+
+// end CSV declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_CSV_IMPLEMENTATION)
+
+#include <assert.h>
+#include <string.h>
+
+// ### CSV implementation {{{
+
+// Stage 1: write the position of every delimiter and newline outside of quotes to `*index`, which is grown
+// as needed. Returns the number of positions, and sets `*newlines` to how many of them are newlines and
+// `*open_quote` to whether the input ends inside quotes.
+static usize tam_csv_index(const char *s, usize n, char delimiter, u32 **index, usize *cap, usize *newlines,
+                           bool *open_quote) {
+    usize count = 0;
+    usize lines = 0;
+    // all ones while the current position is inside quotes
+    u64 inside_carry = 0;
+    for (usize i = 0; i < n; i += 64) {
+        tam_block64_t block;
+        u64 valid = ~0ull;
+        if (i + 64 <= n) {
+            block = tam_block64_load(s + i);
+        } else {
+            char tail[64] = {0};
+            memcpy(tail, s + i, n - i);
+            block = tam_block64_load(tail);
+            valid = (1ull << (n - i)) - 1;
+        }
+
+        u64 quotes = tam_block64_eq(&block, '"') & valid;
+        u64 inside = tam_prefix_xor64(quotes) ^ inside_carry;
+        inside_carry = (u64)((i64)inside >> 63);
+
+        u64 nl = tam_block64_eq(&block, '\n') & ~inside & valid;
+        u64 structural = (tam_block64_eq(&block, delimiter) & ~inside & valid) | nl;
+        lines += tam_popcount64(nl);
+
+        int bits = tam_popcount64(structural);
+        if (count + bits > *cap) {
+            usize newcap = tam_grow_capacity(*cap * sizeof(u32), (count + bits) * sizeof(u32)) / sizeof(u32);
+            *index = tam_reallocate_sized(*index, u32, *cap, newcap);
+            *cap = newcap;
+        }
+        u32 *out = *index + count;
+        for (; structural != 0; structural &= structural - 1)
+            *out++ = (u32)(i + tam_ctz64(structural));
+        count += bits;
+    }
+    *newlines = lines;
+    *open_quote = inside_carry != 0;
+    return count;
+}
+
+// Turn the raw text of a field into its value, unescaping it into the arena if needed
+static tam_slice_t tam_csv_field_value(tam_slice_t raw, tam_arena_t *arena) {
+    if (raw.len == 0 || raw.buf[0] != '"')
+        return raw;
+    // drop the quotes. anything between the closing quote and the delimiter is kept, as most readers do.
+    tam_slice_t content = tam_slice_n(raw.buf + 1, raw.len - 1);
+    const char *close = (const char *)memchr(content.buf, '"', content.len);
+    if (close == NULL)
+        return content;
+    if (close + 1 == content.buf + content.len)
+        return tam_slice_n(content.buf, content.len - 1);
+
+    // the field contains escaped quotes, so it has to be copied
+    char *buf = tam_arena_alloc(arena, char, content.len);
+    int len = 0;
+    for (int i = 0; i < content.len; i++) {
+        char c = content.buf[i];
+        if (c == '"') {
+            // a doubled quote stands for one quote, and a single one closes the quoted part
+            if (i + 1 < content.len && content.buf[i + 1] == '"')
+                i++;
+            else
+                continue;
+        }
+        buf[len++] = c;
+    }
+    tam_arena_release(arena, buf + len, content.len - len);
+    return tam_slice_n(buf, len);
+}
+
+bool tam_csv_parse(tam_csv_t *csv, tam_slice_t input, char delimiter, tam_arena_t *arena) {
+    csv->fields = NULL;
+    csv->rows = NULL;
+    csv->num_rows = 0;
+    csv->num_fields = 0;
+    if (delimiter == '"' || delimiter == '\n' || delimiter == '\r')
+        return false;
+    if (input.len < 0 || input.len > TAM_CSV_MAX_LEN)
+        return false;
+    if (input.len == 0)
+        return true;
+
+    usize cap = 0;
+    u32 *index = NULL;
+    usize newlines;
+    bool open_quote;
+    usize count = tam_csv_index(input.buf, input.len, delimiter, &index, &cap, &newlines, &open_quote);
+    if (open_quote) {
+        tam_deallocate_sized(index, u32, cap);
+        return false;
+    }
+
+    // the last row needs no newline, and ends at the end of the input
+    bool unterminated = input.buf[input.len - 1] != '\n';
+    int num_fields = count + unterminated;
+    int num_rows = newlines + unterminated;
+    tam_slice_t *fields = tam_arena_alloc(arena, tam_slice_t, num_fields);
+    int *rows = tam_arena_alloc(arena, int, num_rows + 1);
+
+    // Stage 2: cut the input at the positions in the index
+    int start = 0;
+    int row = 0;
+    rows[0] = 0;
+    for (int f = 0; f < num_fields; f++) {
+        int end = f < (int)count ? (int)index[f] : input.len;
+        bool row_end = end == input.len || input.buf[end] == '\n';
+        tam_slice_t raw = tam_slice_n(input.buf + start, end - start);
+        if (row_end && raw.len > 0 && raw.buf[raw.len - 1] == '\r')
+            raw.len--;
+        fields[f] = tam_csv_field_value(raw, arena);
+        if (row_end)
+            rows[++row] = f + 1;
+        start = end + 1;
+    }
+    tam_deallocate_sized(index, u32, cap);
+
+    csv->fields = fields;
+    csv->rows = rows;
+    csv->num_rows = num_rows;
+    csv->num_fields = num_fields;
+    return true;
+}
+
+int tam_csv_num_cols(const tam_csv_t *csv, int row) {
+    assert(0 <= row && row < csv->num_rows);
+    return csv->rows[row + 1] - csv->rows[row];
+}
+
+tam_slice_t tam_csv_get(const tam_csv_t *csv, int row, int col) {
+    assert(0 <= col && col < tam_csv_num_cols(csv, row));
+    return csv->fields[csv->rows[row] + col];
+}
+
+// end CSV implementation }}}
+
+#if defined(TAM_TEST)
+
+#include <stdio.h>
+
+// ### CSV tests {{{
+int tam_test_csv() {
+    {
+        // quoting rules
+        tam_arena_t arena = tam_arena_new(4096);
+        const char *text = "name,quote,n\r\n"
+                           "alice,\"hello, world\",1\r\n"
+                           "bob,\"she said \"\"hi\"\"\",\r\n"
+                           "\n"
+                           "carol,\"two\nlines\",3";
+        tam_csv_t csv;
+        assert(tam_csv_parse(&csv, tam_slice(text), ',', &arena));
+        assert(csv.num_rows == 5);
+        assert(csv.num_fields == 13);
+        assert(tam_csv_num_cols(&csv, 0) == 3);
+        assert(tam_sl_eqstr(tam_csv_get(&csv, 0, 2), "n"));
+        assert(tam_sl_eqstr(tam_csv_get(&csv, 1, 1), "hello, world"));
+        assert(tam_sl_eqstr(tam_csv_get(&csv, 2, 1), "she said \"hi\""));
+        assert(tam_csv_get(&csv, 2, 2).len == 0);
+        assert(tam_csv_num_cols(&csv, 3) == 1 && tam_csv_get(&csv, 3, 0).len == 0);
+        assert(tam_sl_eqstr(tam_csv_get(&csv, 4, 1), "two\nlines"));
+        assert(tam_sl_eqstr(tam_csv_get(&csv, 4, 2), "3"));
+        // fields without escapes point into the input
+        assert(tam_csv_get(&csv, 1, 0).buf == text + 14);
+
+        assert(!tam_csv_parse(&csv, tam_slice("a,\"unterminated\nb,c\n"), ',', &arena));
+        assert(csv.num_rows == 0);
+        assert(tam_csv_parse(&csv, tam_slice(""), ',', &arena) && csv.num_rows == 0);
+        assert(!tam_csv_parse(&csv, tam_slice("a\"b\n"), '"', &arena));
+        assert(!tam_csv_parse(&csv, tam_slice("a\nb\n"), '\n', &arena));
+        assert(!tam_csv_parse(&csv, tam_slice("a\rb\r\n"), '\r', &arena) && csv.num_rows == 0);
+
+        // TSV
+        assert(tam_csv_parse(&csv, tam_slice("a\tb,c\n1\t2\n"), '\t', &arena));
+        assert(csv.num_rows == 2 && tam_sl_eqstr(tam_csv_get(&csv, 0, 1), "b,c"));
+        tam_arena_dealloc(&arena);
+    }
+    {
+        // round trip a table large enough that quoted fields straddle many 64-byte blocks
+        const char *words[] = {"plain", "with,comma", "with \"quotes\"", "multi\nline", "", "x", "\"", "a\r"};
+        int rows = 300, cols = 7;
+        char *text = tam_allocate(char, rows * cols * 20);
+        int n = 0;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                const char *w = words[(r * 3 + c * 5) % 8];
+                if (strpbrk(w, ",\"\n\r")) {
+                    text[n++] = '"';
+                    for (const char *p = w; *p; p++) {
+                        if (*p == '"')
+                            text[n++] = '"';
+                        text[n++] = *p;
+                    }
+                    text[n++] = '"';
+                } else {
+                    memcpy(text + n, w, strlen(w));
+                    n += strlen(w);
+                }
+                text[n++] = c + 1 < cols ? ',' : '\n';
+            }
+        }
+        tam_arena_t arena = tam_arena_new(1 << 16);
+        tam_csv_t csv;
+        assert(tam_csv_parse(&csv, tam_slice_n(text, n), ',', &arena));
+        assert(csv.num_rows == rows);
+        for (int r = 0; r < rows; r++) {
+            assert(tam_csv_num_cols(&csv, r) == cols);
+            for (int c = 0; c < cols; c++)
+                assert(tam_sl_eqstr(tam_csv_get(&csv, r, c), words[(r * 3 + c * 5) % 8]));
+        }
+        tam_arena_dealloc(&arena);
+        tam_deallocate(text);
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end CSV tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_CSV_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_CSV_H
@@ -0,0 +1,557 @@
+#ifndef TAM_ENCODING_H
+#define TAM_ENCODING_H
+
+// TAM binary-to-text encodings
+//
+// Base64 (standard and URL-safe) and hex codecs between slices, StringBuilders and caller buffers.
+
+#include <tam/simd.h>
+#include <tam/slices.h>
+#include <tam/stringbuilder.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Encoding declarations *** {{{
+/*
+ * Encoders read the bytes of a slice and write text, decoders read text and write bytes.
+ * Each codec can write into a caller-provided buffer (use the `_len` functions to size it) or append to
+ * a StringBuilder. Decoders validate their input and report failure instead of producing garbage.
+ * With SSSE3 or AVX2 enabled, the kernels translate 16 or 32 characters per step using pshufb lookups,
+ * and fall back to portable scalar code otherwise and for the tails of the input.
+ */
+
+typedef enum tam_base64_t {
+    // RFC 4648 base64 (`+` and `/`), padded with `=`
+    TAM_BASE64,
+    // RFC 4648 base64url (`-` and `_`), without padding
+    TAM_BASE64_URL,
+} tam_base64_t;
+
+/*
+ * Number of characters produced by base64-encoding `n` bytes
+ */
+usize tam_base64_encoded_len(usize n, tam_base64_t alphabet);
+
+/*
+ * Upper bound on the number of bytes produced by base64-decoding `n` characters
+ */
+usize tam_base64_decoded_maxlen(usize n);
+
+/*
+ * Base64-encode a slice into `out`, which must have room for `base64_encoded_len(in.len)` chars.
+ * Returns the number of chars written. The output is not null-terminated.
+ */
+usize tam_base64_encode(char *out, tam_slice_t in, tam_base64_t alphabet);
+
+/*
+ * Decode base64 text into `out`, which must have room for `base64_decoded_maxlen(in.len)` bytes.
+ * Padding is optional for both alphabets. Returns the number of bytes written, or -1 if the input is
+ * not valid base64 (invalid characters, bad length or padding, or nonzero trailing bits).
+ */
+isize tam_base64_decode(char *out, tam_slice_t in, tam_base64_t alphabet);
+
+/*
+ * Append the base64 encoding of a slice to a StringBuilder
+ */
+void tam_sb_append_base64_encoded(tam_stringbuilder_t *sb, tam_slice_t in, tam_base64_t alphabet);
+
+/*
+ * Decode base64 text and append the bytes to a StringBuilder.
+ * Returns false if the input is invalid, in which case the builder is unchanged.
+ */
+bool tam_sb_append_base64_decoded(tam_stringbuilder_t *sb, tam_slice_t in, tam_base64_t alphabet);
+
+/*
+ * Hex-encode a slice into `out` using lowercase digits. `out` must have room for 2 * in.len chars.
+ * Returns the number of chars written.
+ */
+usize tam_hex_encode(char *out, tam_slice_t in);
+
+/*
+ * Decode hex text (either case) into `out`, which must have room for in.len / 2 bytes.
+ * Returns the number of bytes written, or -1 if the input has odd length or a non-hex character.
+ */
+isize tam_hex_decode(char *out, tam_slice_t in);
+
+/*
+ * Append the hex encoding of a slice to a StringBuilder
+ */
+void tam_sb_append_hex_encoded(tam_stringbuilder_t *sb, tam_slice_t in);
+
+/*
+ * Decode hex text and append the bytes to a StringBuilder.
+ * Returns false if the input is invalid, in which case the builder is unchanged.
+ */
+bool tam_sb_append_hex_decoded(tam_stringbuilder_t *sb, tam_slice_t in);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_ENCODING) ///{{{
+#define base64_encoded_len tam_base64_encoded_len
+#define base64_decoded_maxlen tam_base64_decoded_maxlen
+#define base64_encode tam_base64_encode
+#define base64_decode tam_base64_decode
+#define sb_append_base64_encoded tam_sb_append_base64_encoded
+#define sb_append_base64_decoded tam_sb_append_base64_decoded
+#define hex_encode tam_hex_encode
+#define hex_decode tam_hex_decode
+#define sb_append_hex_encoded tam_sb_append_hex_encoded
+#define sb_append_hex_decoded tam_sb_append_hex_decoded
+#endif // end encoding namespace }}}
+
+// end encoding declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_ENCODING_IMPLEMENTATION)
+
+// ### Base64 implementation {{{
+
+static const char tam_base64_chars[2][65] = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_",
+};
+
+usize tam_base64_encoded_len(usize n, tam_base64_t alphabet) {
+    if (alphabet == TAM_BASE64)
+        return (n + 2) / 3 * 4;
+    return n / 3 * 4 + (n % 3 == 0 ? 0 : n % 3 + 1);
+}
+
+usize tam_base64_decoded_maxlen(usize n) { return (n + 3) / 4 * 3; }
+
+#if defined(TAM_SSSE3)
+// Spread 12 input bytes over 16 bytes holding one 6-bit index each (Muła's multiply-shift method)
+static inline __m128i tam_base64_enc_reshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// Translate 6-bit indices to characters by adding a per-range offset looked up with pshufb
+static inline __m128i tam_base64_enc_translate(__m128i idx, __m128i lut) {
+    __m128i range = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    range = _mm_sub_epi8(range, _mm_cmpgt_epi8(idx, _mm_set1_epi8(25)));
+    return _mm_add_epi8(idx, _mm_shuffle_epi8(lut, range));
+}
+
+static inline __m128i tam_base64_enc_lut(tam_base64_t alphabet) {
+    if (alphabet == TAM_BASE64)
+        return _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, '+' - 62, '/' - 63, 0, 0);
+    return _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, '-' - 62, '_' - 63, 0, 0);
+}
+#endif
+
+#if defined(TAM_AVX2)
+static inline __m256i tam_base64_enc_reshuffle32(__m256i in) {
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7,
+                                                 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    return _mm256_or_si256(t1, t3);
+}
+
+static inline __m256i tam_base64_enc_translate32(__m256i idx, __m256i lut) {
+    __m256i range = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+    range = _mm256_sub_epi8(range, _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(25)));
+    return _mm256_add_epi8(idx, _mm256_shuffle_epi8(lut, range));
+}
+#endif
+
+usize tam_base64_encode(char *out, tam_slice_t in, tam_base64_t alphabet) {
+    const u8 *src = (const u8 *)in.buf;
+    usize n = in.len;
+    usize i = 0;
+    char *dst = out;
+
+#if defined(TAM_AVX2)
+    {
+        const __m256i lut = _mm256_broadcastsi128_si256(tam_base64_enc_lut(alphabet));
+        // each lane loads 16 bytes and uses 12, so the second load reads up to 28 bytes ahead
+        for (; i + 32 <= n; i += 24, dst += 32) {
+            __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 12));
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            _mm256_storeu_si256((__m256i *)dst, tam_base64_enc_translate32(tam_base64_enc_reshuffle32(v), lut));
+        }
+    }
+#endif
+#if defined(TAM_SSSE3)
+    {
+        const __m128i lut = tam_base64_enc_lut(alphabet);
+        for (; i + 16 <= n; i += 12, dst += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            _mm_storeu_si128((__m128i *)dst, tam_base64_enc_translate(tam_base64_enc_reshuffle(v), lut));
+        }
+    }
+#endif
+
+    const char *chars = tam_base64_chars[alphabet];
+    for (; i + 3 <= n; i += 3) {
+        u32 x = (u32)src[i] << 16 | (u32)src[i + 1] << 8 | src[i + 2];
+        *dst++ = chars[x >> 18];
+        *dst++ = chars[(x >> 12) & 0x3f];
+        *dst++ = chars[(x >> 6) & 0x3f];
+        *dst++ = chars[x & 0x3f];
+    }
+    if (i < n) {
+        u32 x = (u32)src[i] << 16 | (i + 1 < n ? (u32)src[i + 1] << 8 : 0);
+        *dst++ = chars[x >> 18];
+        *dst++ = chars[(x >> 12) & 0x3f];
+        if (i + 1 < n)
+            *dst++ = chars[(x >> 6) & 0x3f];
+        if (alphabet == TAM_BASE64) {
+            if (i + 1 >= n)
+                *dst++ = '=';
+            *dst++ = '=';
+        }
+    }
+    return dst - out;
+}
+
+// Value of a base64 character, or -1 if it is not part of the alphabet
+static inline int tam_base64_value(u8 c, tam_base64_t alphabet) {
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (alphabet == TAM_BASE64)
+        return c == '+' ? 62 : c == '/' ? 63 : -1;
+    return c == '-' ? 62 : c == '_' ? 63 : -1;
+}
+
+#if defined(TAM_SSSE3)
+/*
+ * Validation and translation tables for the vectorized decoder (after Klomp and Muła).
+ * A character is valid iff lut_lo[low nibble] & lut_hi[high nibble] == 0, where each bit of lut_hi
+ * stands for a class of high nibbles and lut_lo marks the low nibbles that are invalid for each class.
+ * Its value is then the character plus lut_roll[high nibble], with the one character that shares a
+ * high nibble with a different range (`/` or `_`) moved to its own roll slot.
+ */
+typedef struct tam_base64_dec_luts_t {
+    __m128i lut_lo;
+    __m128i lut_hi;
+    __m128i lut_roll;
+    // the special character and what to add to its roll index
+    __m128i special;
+    __m128i special_shift;
+} tam_base64_dec_luts_t;
+
+static inline tam_base64_dec_luts_t tam_base64_dec_luts(tam_base64_t alphabet) {
+    tam_base64_dec_luts_t l;
+    if (alphabet == TAM_BASE64) {
+        l.lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b,
+                                 0x1b, 0x1a);
+        l.lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                 0x10, 0x10);
+        l.lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        l.special = _mm_set1_epi8('/');
+        l.special_shift = _mm_set1_epi8(-1);
+    } else {
+        l.lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x3b, 0x3b, 0x3a,
+                                 0x3b, 0x33);
+        l.lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                 0x10, 0x10);
+        l.lut_roll = _mm_setr_epi8(0, 0, 17, 4, -65, -65, -71, -71, -32, 0, 0, 0, 0, 0, 0, 0);
+        l.special = _mm_set1_epi8('_');
+        l.special_shift = _mm_set1_epi8(3);
+    }
+    return l;
+}
+
+// Translate 16 characters to 6-bit values. Returns false if any of them is invalid.
+static inline bool tam_base64_dec_translate(__m128i *v, const tam_base64_dec_luts_t *l) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(*v, 4), nibble);
+    __m128i lo_nibbles = _mm_and_si128(*v, nibble);
+    __m128i lo = _mm_shuffle_epi8(l->lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(l->lut_hi, hi_nibbles);
+    // bytes >= 0x80 have a high nibble >= 8, which is invalid in every alphabet
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff)
+        return false;
+    __m128i shift = _mm_and_si128(_mm_cmpeq_epi8(*v, l->special), l->special_shift);
+    __m128i roll = _mm_shuffle_epi8(l->lut_roll, _mm_add_epi8(shift, hi_nibbles));
+    *v = _mm_add_epi8(*v, roll);
+    return true;
+}
+
+// Pack 16 6-bit values into 12 bytes, at the start of the result
+static inline __m128i tam_base64_dec_reshuffle(__m128i v) {
+    const __m128i ab_bc = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    const __m128i abcd = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(abcd, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+#endif
+
+isize tam_base64_decode(char *out, tam_slice_t in, tam_base64_t alphabet) {
+    const u8 *src = (const u8 *)in.buf;
+    usize n = in.len;
+    // strip padding, which is only allowed to complete a group of four
+    if (n > 0 && n % 4 == 0 && src[n - 1] == '=') {
+        n--;
+        if (src[n - 1] == '=')
+            n--;
+    }
+    if (n % 4 == 1)
+        return -1;
+
+    usize i = 0;
+    u8 *dst = (u8 *)out;
+
+#if defined(TAM_SSSE3)
+    {
+        tam_base64_dec_luts_t luts = tam_base64_dec_luts(alphabet);
+#if defined(TAM_AVX2)
+        // two 16-char blocks per step. Each block stores 16 bytes of which 12 are valid, so we stop while the
+        // remaining input is still guaranteed to produce enough output to cover the overhang.
+        for (; i + 48 <= n; i += 32, dst += 24) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+            if (!tam_base64_dec_translate(&a, &luts) || !tam_base64_dec_translate(&b, &luts))
+                break;
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(tam_base64_dec_reshuffle(a)),
+                                                tam_base64_dec_reshuffle(b), 1);
+            v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+            _mm256_storeu_si256((__m256i *)dst, v);
+        }
+#endif
+        for (; i + 24 <= n; i += 16, dst += 12) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            if (!tam_base64_dec_translate(&v, &luts))
+                break;
+            _mm_storeu_si128((__m128i *)dst, tam_base64_dec_reshuffle(v));
+        }
+        // an invalid block is rejected by the scalar loop below, which also finds where the error is
+    }
+#endif
+
+    for (; i + 4 <= n; i += 4) {
+        int a = tam_base64_value(src[i], alphabet);
+        int b = tam_base64_value(src[i + 1], alphabet);
+        int c = tam_base64_value(src[i + 2], alphabet);
+        int d = tam_base64_value(src[i + 3], alphabet);
+        if ((a | b | c | d) < 0)
+            return -1;
+        u32 x = (u32)a << 18 | (u32)b << 12 | (u32)c << 6 | (u32)d;
+        *dst++ = x >> 16;
+        *dst++ = x >> 8;
+        *dst++ = x;
+    }
+    if (i < n) {
+        // two or three characters left, encoding one or two bytes
+        int a = tam_base64_value(src[i], alphabet);
+        int b = tam_base64_value(src[i + 1], alphabet);
+        int c = i + 2 < n ? tam_base64_value(src[i + 2], alphabet) : 0;
+        if ((a | b | c) < 0)
+            return -1;
+        u32 x = (u32)a << 18 | (u32)b << 12 | (u32)c << 6;
+        // the unused trailing bits must be zero for the encoding to be canonical
+        if (i + 2 < n ? (x & 0xff) != 0 : (x & 0xffff) != 0)
+            return -1;
+        *dst++ = x >> 16;
+        if (i + 2 < n)
+            *dst++ = x >> 8;
+    }
+    return (char *)dst - out;
+}
+
+void tam_sb_append_base64_encoded(tam_stringbuilder_t *sb, tam_slice_t in, tam_base64_t alphabet) {
+    char *out = tam_sb_reserve(sb, tam_base64_encoded_len(in.len, alphabet));
+    tam_sb_commit(sb, tam_base64_encode(out, in, alphabet));
+}
+
+bool tam_sb_append_base64_decoded(tam_stringbuilder_t *sb, tam_slice_t in, tam_base64_t alphabet) {
+    char *out = tam_sb_reserve(sb, tam_base64_decoded_maxlen(in.len));
+    isize n = tam_base64_decode(out, in, alphabet);
+    if (n < 0)
+        return false;
+    tam_sb_commit(sb, n);
+    return true;
+}
+
+// end base64 implementation }}}
+
+// ### Hex implementation {{{
+
+usize tam_hex_encode(char *out, tam_slice_t in) {
+    static const char digits[] = "0123456789abcdef";
+    const u8 *src = (const u8 *)in.buf;
+    usize n = in.len;
+    usize i = 0;
+#if defined(TAM_SSSE3)
+    {
+        const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+            __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, nibble));
+            _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        out[2 * i] = digits[src[i] >> 4];
+        out[2 * i + 1] = digits[src[i] & 0xf];
+    }
+    return 2 * n;
+}
+
+static inline int tam_hex_value(u8 c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+isize tam_hex_decode(char *out, tam_slice_t in) {
+    const u8 *src = (const u8 *)in.buf;
+    usize n = in.len;
+    if (n % 2 != 0)
+        return -1;
+    usize i = 0;
+#if defined(TAM_SSSE3)
+    {
+        const __m128i zero_char = _mm_set1_epi8('0');
+        const __m128i a_char = _mm_set1_epi8('a');
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i five = _mm_set1_epi8(5);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i digit = _mm_sub_epi8(v, zero_char);
+            __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+            __m128i letter = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), a_char);
+            __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, five), letter);
+            if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff)
+                return -1;
+            __m128i value = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                                         _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+            // combine pairs of nibbles: high * 16 + low
+            __m128i bytes = _mm_maddubs_epi16(value, _mm_set1_epi16(0x0110));
+            _mm_storel_epi64((__m128i *)(out + i / 2), _mm_packus_epi16(bytes, bytes));
+        }
+    }
+#endif
+    for (; i < n; i += 2) {
+        int hi = tam_hex_value(src[i]);
+        int lo = tam_hex_value(src[i + 1]);
+        if ((hi | lo) < 0)
+            return -1;
+        out[i / 2] = (char)(hi << 4 | lo);
+    }
+    return n / 2;
+}
+
+void tam_sb_append_hex_encoded(tam_stringbuilder_t *sb, tam_slice_t in) {
+    char *out = tam_sb_reserve(sb, 2 * (usize)in.len);
+    tam_sb_commit(sb, tam_hex_encode(out, in));
+}
+
+bool tam_sb_append_hex_decoded(tam_stringbuilder_t *sb, tam_slice_t in) {
+    char *out = tam_sb_reserve(sb, in.len / 2);
+    isize n = tam_hex_decode(out, in);
+    if (n < 0)
+        return false;
+    tam_sb_commit(sb, n);
+    return true;
+}
+
+// end hex implementation }}}
+
+#if defined(TAM_TEST)
+
+// ### Encoding tests {{{
+int tam_test_encoding() {
+    {
+        // RFC 4648 test vectors
+        const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+        const char *std[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+        const char *url[] = {"", "Zg", "Zm8", "Zm9v", "Zm9vYg", "Zm9vYmE", "Zm9vYmFy"};
+        for (int i = 0; i < 7; i++) {
+            tam_stringbuilder_t sb = tam_sb_new();
+            tam_sb_append_base64_encoded(&sb, tam_slice(plain[i]), TAM_BASE64);
+            assert(tam_sl_eqstr(tam_sb_view(&sb), std[i]));
+            tam_sb_clear(&sb);
+            tam_sb_append_base64_encoded(&sb, tam_slice(plain[i]), TAM_BASE64_URL);
+            assert(tam_sl_eqstr(tam_sb_view(&sb), url[i]));
+
+            tam_sb_clear(&sb);
+            assert(tam_sb_append_base64_decoded(&sb, tam_slice(std[i]), TAM_BASE64));
+            assert(tam_sl_eqstr(tam_sb_view(&sb), plain[i]));
+            tam_sb_clear(&sb);
+            assert(tam_sb_append_base64_decoded(&sb, tam_slice(url[i]), TAM_BASE64_URL));
+            assert(tam_sl_eqstr(tam_sb_view(&sb), plain[i]));
+            tam_sb_deallocate(&sb);
+        }
+    }
+    {
+        // long inputs covering every byte value, so that the vector kernels and their tails are exercised
+        char bytes[1000];
+        for (int i = 0; i < 1000; i++)
+            bytes[i] = (char)(i * 7 + i / 256);
+        for (int len = 0; len < 1000; len += 37) {
+            for (int a = 0; a < 2; a++) {
+                tam_base64_t alphabet = a == 0 ? TAM_BASE64 : TAM_BASE64_URL;
+                char enc[1400], dec[1000];
+                usize n = tam_base64_encode(enc, tam_slice_n(bytes, len), alphabet);
+                assert(n == tam_base64_encoded_len(len, alphabet));
+                for (usize j = 0; j < n; j++)
+                    assert(enc[j] == '=' || tam_base64_value(enc[j], alphabet) >= 0);
+                assert(tam_base64_decode(dec, tam_slice_n(enc, n), alphabet) == len);
+                assert(memcmp(dec, bytes, len) == 0);
+
+                // corrupt one character anywhere in the input
+                if (n > 0) {
+                    enc[len % n] = a == 0 ? '-' : '/';
+                    assert(tam_base64_decode(dec, tam_slice_n(enc, n), alphabet) == -1);
+                }
+            }
+
+            tam_stringbuilder_t sb = tam_sb_new(), out = tam_sb_new();
+            tam_sb_append_hex_encoded(&sb, tam_slice_n(bytes, len));
+            assert(sb.len == 2 * len);
+            assert(tam_sb_append_hex_decoded(&out, tam_sb_view(&sb)));
+            assert(out.len == len && (len == 0 || memcmp(out.buf, bytes, len) == 0));
+            if (len > 0) {
+                sb.buf[len] = 'g';
+                tam_sb_clear(&out);
+                assert(!tam_sb_append_hex_decoded(&out, tam_sb_view(&sb)));
+                assert(out.len == 0);
+            }
+            tam_sb_deallocate(&sb);
+            tam_sb_deallocate(&out);
+        }
+    }
+    {
+        // invalid inputs
+        char dec[16];
+        assert(tam_base64_decode(dec, tam_slice("Zm9vY"), TAM_BASE64) == -1);
+        assert(tam_base64_decode(dec, tam_slice("Zh=="), TAM_BASE64) == -1);
+        assert(tam_base64_decode(dec, tam_slice("Zm9=v"), TAM_BASE64) == -1);
+        assert(tam_hex_decode(dec, tam_slice("abc")) == -1);
+        assert(tam_hex_decode(dec, tam_slice("DEADbeef")) == 4);
+        assert(memcmp(dec, "\xde\xad\xbe\xef", 4) == 0);
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end encoding tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_ENCODING_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_ENCODING_H
@@ -0,0 +1,851 @@
+#ifndef TAM_GLOB_H
+#define TAM_GLOB_H
+
+// TAM glob matching
+//
+// Shell-style wildcard patterns for paths, compiled once and matched against slices, singly or as a set.
+
+#include <tam/memory.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Glob declarations *** {{{
+// Glob syntax:
+//   `?`        any byte except `/`
+//   `*`        any run of bytes without a `/`
+//   `[a-z]`    a byte in a class, `[!a-z]` or `[^a-z]` a byte not in it. Classes never match `/`.
+//   `**`       as a whole path component, any run of bytes including `/`: `**` followed by `/` matches zero
+//              or more directories, so `a/**/b` matches `a/b` and `a/x/y/b`, and a final `/**` matches
+//              everything below a directory. Elsewhere, `**` is the same as `*`.
+//   `\c`       the byte `c`
+// A glob must match the whole path.
+//
+// A compiled glob is a list of literal and wildcard tokens. Matching tries to match each wildcard with as
+// little input as possible, and after a mismatch lets the last `*` (or, failing that, the last `**`) consume
+// more. The literal after a wildcard is found with `sl_find`, so a wildcard skips straight to the places the
+// rest of the pattern can start.
+
+typedef enum tam_glob_op_t {
+    // a literal string
+    TAM_GLOB_LITERAL,
+    // `?`
+    TAM_GLOB_ANY,
+    // a byte class
+    TAM_GLOB_CLASS,
+    // `*`
+    TAM_GLOB_STAR,
+    // a `**` that matches anything
+    TAM_GLOB_GLOBSTAR,
+    // a `**/`, which matches nothing or anything ending in `/`
+    TAM_GLOB_DIRS,
+} tam_glob_op_t;
+
+typedef struct tam_glob_token_t {
+    u8 op;
+    // literal bytes, at `literals + index`, or the class index
+    int index;
+    int len;
+} tam_glob_token_t;
+
+typedef struct tam_glob_t {
+    // NULL if the pattern compiled, otherwise a description of the problem at offset `error_pos` of the pattern
+    const char *error;
+    int error_pos;
+
+    tam_glob_token_t *tokens;
+    int len;
+    char *literals;
+    u64 (*classes)[4];
+    int num_classes;
+} tam_glob_t;
+
+/*
+ * Compile a glob pattern.
+ * If the pattern is invalid, `error` is set on the result, which must still be freed with `glob_deallocate`.
+ */
+tam_glob_t tam_glob_compile(const char *pattern);
+
+/*
+ * Free a compiled glob
+ */
+void tam_glob_deallocate(tam_glob_t *glob);
+
+/*
+ * Return true if the glob matches all of `path`
+ */
+bool tam_glob_match(const tam_glob_t *glob, tam_slice_t path);
+
+// A set of globs that are all matched against a path at once.
+//
+// Globs that are plain paths, `**/name` or `**/*.ext` are looked up in a hash table by the whole path,
+// its last component, or the suffixes of the last component starting with a `.`. The other globs are
+// combined into one NFA, which is simulated over the path in a single pass. A glob only joins the
+// simulation once the path has matched the literal it starts with, which is found by looking up each
+// prefix of the path in the same hash table. Matching a path costs about the same whether the set has
+// ten globs or thousands, as long as few of them start with a wildcard.
+typedef struct tam_globset_t {
+    // number of globs added
+    int len;
+
+    // hash table of the literal globs, chained through `next`
+    struct tam_globset_entry_t {
+        u64 hash;
+        u8 kind;
+        // the index of the glob, or for the start of a glob in the NFA, the state to start at
+        int value;
+        int next;
+        int key;
+        int key_len;
+    } *entries;
+    int num_entries;
+    int entries_cap;
+    int *buckets;
+    int num_buckets;
+    char *keys;
+    int keys_len;
+    int keys_cap;
+
+    // the NFA of the other globs
+    struct tam_globset_inst_t {
+        u8 op;
+        u8 c;
+        // class index, jump target or glob index
+        int x;
+    } *prog;
+    int prog_len;
+    int prog_cap;
+    u64 (*classes)[4];
+    int num_classes;
+
+    // length of the longest literal that starts a glob in the NFA
+    int max_prefix;
+    bool dirty;
+
+    // scratch for matching
+    int *lists[2];
+    // states added in the current step are marked with the current generation
+    u32 *mark;
+    u32 gen;
+    int *stack;
+    int *hits;
+} tam_globset_t;
+
+/*
+ * Create an empty glob set
+ */
+tam_globset_t tam_globset_new(void);
+
+/*
+ * Free a glob set
+ */
+void tam_globset_deallocate(tam_globset_t *set);
+
+/*
+ * Add a glob to a set. Returns its index in the set, which is its position in the order globs were added,
+ * or -1 if the pattern is invalid.
+ */
+int tam_globset_add(tam_globset_t *set, const char *pattern);
+
+/*
+ * Return true if any glob in the set matches `path`
+ */
+bool tam_globset_is_match(tam_globset_t *set, tam_slice_t path);
+
+/*
+ * Find the globs in the set that match `path`. Their indices are written to `out` in increasing order,
+ * up to `max` of them, and the total number of matching globs is returned.
+ */
+int tam_globset_matches(tam_globset_t *set, tam_slice_t path, int *out, int max);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_GLOB) ///{{{
+typedef tam_glob_t glob_t;
+typedef tam_globset_t globset_t;
+#define glob_compile tam_glob_compile
+#define glob_deallocate tam_glob_deallocate
+#define glob_match tam_glob_match
+#define globset_new tam_globset_new
+#define globset_deallocate tam_globset_deallocate
+#define globset_add tam_globset_add
+#define globset_is_match tam_globset_is_match
+#define globset_matches tam_globset_matches
+#endif // end glob namespace }}}
+
+// end glob declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_GLOB_IMPLEMENTATION)
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ### Glob compiler {{{
+
+static void tam_glob_push(tam_glob_t *g, int *cap, tam_glob_op_t op, int index, int len) {
+    // adjacent literals are merged, and so are stars
+    if (g->len > 0) {
+        tam_glob_token_t *last = &g->tokens[g->len - 1];
+        if (op == TAM_GLOB_LITERAL && last->op == TAM_GLOB_LITERAL && last->index + last->len == index) {
+            last->len += len;
+            return;
+        }
+        if (op == TAM_GLOB_STAR && last->op == TAM_GLOB_STAR)
+            return;
+    }
+    if (g->len == *cap) {
+        *cap = *cap ? 2 * *cap : 16;
+        g->tokens = tam_reallocate(g->tokens, tam_glob_token_t, *cap);
+    }
+    g->tokens[g->len++] = (tam_glob_token_t){(u8)op, index, len};
+}
+
+tam_glob_t tam_glob_compile(const char *pattern) {
+    tam_glob_t g;
+    memset(&g, 0, sizeof(g));
+    int n = strlen(pattern);
+    // literals are never longer than the pattern
+    g.literals = tam_allocate(char, n + 1);
+    int lit_len = 0;
+    int cap = 0;
+
+    for (int i = 0; i < n;) {
+        char c = pattern[i];
+        if (c == '*') {
+            bool component_start = i == 0 || pattern[i - 1] == '/';
+            if (i + 1 < n && pattern[i + 1] == '*' && component_start && (i + 2 == n || pattern[i + 2] == '/')) {
+                if (i + 2 == n) {
+                    tam_glob_push(&g, &cap, TAM_GLOB_GLOBSTAR, 0, 0);
+                    i += 2;
+                } else {
+                    tam_glob_push(&g, &cap, TAM_GLOB_DIRS, 0, 0);
+                    i += 3;
+                }
+                continue;
+            }
+            tam_glob_push(&g, &cap, TAM_GLOB_STAR, 0, 0);
+            i++;
+        } else if (c == '?') {
+            tam_glob_push(&g, &cap, TAM_GLOB_ANY, 0, 0);
+            i++;
+        } else if (c == '[') {
+            int start = i++;
+            u64 bits[4] = {0};
+            bool negate = i < n && (pattern[i] == '!' || pattern[i] == '^');
+            i += negate;
+            bool first = true;
+            while (i < n && (pattern[i] != ']' || first)) {
+                first = false;
+                int lo = (u8)pattern[i++];
+                if (lo == '\\' && i < n)
+                    lo = (u8)pattern[i++];
+                int hi = lo;
+                if (i + 1 < n && pattern[i] == '-' && pattern[i + 1] != ']') {
+                    hi = (u8)pattern[i + 1];
+                    i += 2;
+                    if (hi == '\\' && i < n)
+                        hi = (u8)pattern[i++];
+                    if (hi < lo) {
+                        g.error = "invalid range in character class";
+                        g.error_pos = i;
+                        return g;
+                    }
+                }
+                for (int b = lo; b <= hi; b++)
+                    bits[b >> 6] |= 1ull << (b & 63);
+            }
+            if (i >= n) {
+                g.error = "missing ]";
+                g.error_pos = start;
+                return g;
+            }
+            i++;
+            if (negate) {
+                for (int k = 0; k < 4; k++)
+                    bits[k] = ~bits[k];
+            }
+            bits['/' >> 6] &= ~(1ull << ('/' & 63));
+            g.classes = (u64(*)[4])tam_reallocate(g.classes, u64[4], g.num_classes + 1);
+            memcpy(g.classes[g.num_classes], bits, sizeof(bits));
+            tam_glob_push(&g, &cap, TAM_GLOB_CLASS, g.num_classes++, 0);
+        } else {
+            if (c == '\\') {
+                if (i + 1 == n) {
+                    g.error = "trailing backslash";
+                    g.error_pos = i;
+                    return g;
+                }
+                c = pattern[++i];
+            }
+            g.literals[lit_len] = c;
+            tam_glob_push(&g, &cap, TAM_GLOB_LITERAL, lit_len++, 1);
+            i++;
+        }
+    }
+    return g;
+}
+
+void tam_glob_deallocate(tam_glob_t *glob) {
+    tam_deallocate(glob->tokens);
+    tam_deallocate(glob->literals);
+    tam_deallocate(glob->classes);
+    glob->len = 0;
+}
+
+// end glob compiler }}}
+
+// ### Glob matching {{{
+
+static inline bool tam_glob_in_class(const u64 bits[4], u8 c) { return (bits[c >> 6] >> (c & 63)) & 1; }
+
+// Find where the text after a wildcard can continue, starting at `i`: the next occurrence of the literal that
+// follows the wildcard, or `i` itself if no literal follows. Returns -1 if the literal does not occur.
+static int tam_glob_skip(const tam_glob_t *g, int next, tam_slice_t s, int i) {
+    if (next >= g->len || g->tokens[next].op != TAM_GLOB_LITERAL)
+        return i;
+    tam_slice_t rest = tam_slice_n(s.buf + i, s.len - i);
+    int j = tam_sl_find(rest, tam_slice_n(g->literals + g->tokens[next].index, g->tokens[next].len));
+    return j == rest.len ? -1 : i + j;
+}
+
+// Like `tam_glob_skip`, for a `*`, which can't skip past a `/`
+static int tam_glob_star_skip(const tam_glob_t *g, int next, tam_slice_t s, int i) {
+    int j = tam_glob_skip(g, next, s, i);
+    if (j < 0 || memchr(s.buf + i, '/', j - i) != NULL)
+        return -1;
+    return j;
+}
+
+bool tam_glob_match(const tam_glob_t *g, tam_slice_t s) {
+    assert(g->error == NULL);
+    int px = 0, nx = 0;
+    // where to resume after a mismatch: the last `*` and the text it has consumed up to,
+    // and the same for the last `**`
+    int star_px = -1, star_nx = 0;
+    int gs_px = -1, gs_nx = 0;
+    for (;;) {
+        if (px < g->len) {
+            const tam_glob_token_t *t = &g->tokens[px];
+            switch (t->op) {
+            case TAM_GLOB_LITERAL:
+                if (nx + t->len <= s.len && memcmp(s.buf + nx, g->literals + t->index, t->len) == 0) {
+                    px++;
+                    nx += t->len;
+                    continue;
+                }
+                break;
+            case TAM_GLOB_ANY:
+                if (nx < s.len && s.buf[nx] != '/') {
+                    px++;
+                    nx++;
+                    continue;
+                }
+                break;
+            case TAM_GLOB_CLASS:
+                if (nx < s.len && tam_glob_in_class(g->classes[t->index], s.buf[nx])) {
+                    px++;
+                    nx++;
+                    continue;
+                }
+                break;
+            case TAM_GLOB_STAR:
+                star_px = px;
+                if ((star_nx = tam_glob_star_skip(g, px + 1, s, nx)) >= 0) {
+                    px++;
+                    nx = star_nx;
+                    continue;
+                }
+                break;
+            case TAM_GLOB_GLOBSTAR:
+            case TAM_GLOB_DIRS:
+                gs_px = px;
+                star_px = -1;
+                gs_nx = t->op == TAM_GLOB_GLOBSTAR ? tam_glob_skip(g, px + 1, s, nx) : nx;
+                if (gs_nx < 0)
+                    return false;
+                px++;
+                nx = gs_nx;
+                continue;
+            }
+        } else if (nx == s.len) {
+            return true;
+        }
+
+        // mismatch: let the last star consume one more byte, as long as it is not a `/`
+        if (star_px >= 0 && star_nx >= 0 && star_nx < s.len && s.buf[star_nx] != '/' &&
+            (star_nx = tam_glob_star_skip(g, star_px + 1, s, star_nx + 1)) >= 0) {
+            px = star_px + 1;
+            nx = star_nx;
+            continue;
+        }
+        // the star is stuck, so let the last `**` consume more
+        star_px = -1;
+        if (gs_px < 0 || gs_nx == s.len)
+            return false;
+        if (g->tokens[gs_px].op == TAM_GLOB_DIRS) {
+            // up to the next `/`
+            const char *slash = (const char *)memchr(s.buf + gs_nx, '/', s.len - gs_nx);
+            if (slash == NULL)
+                return false;
+            gs_nx = slash - s.buf + 1;
+        } else if ((gs_nx = tam_glob_skip(g, gs_px + 1, s, gs_nx + 1)) < 0) {
+            return false;
+        }
+        px = gs_px + 1;
+        nx = gs_nx;
+    }
+}
+
+// end glob matching }}}
+
+// ### Glob sets {{{
+
+// kinds of globs in the hash table of a set
+enum {
+    // the whole path
+    TAM_GLOBSET_EXACT,
+    // `**/name`, the last component
+    TAM_GLOBSET_BASENAME,
+    // `**/*.ext`, a suffix of the last component starting with `.`
+    TAM_GLOBSET_EXTENSION,
+    // the literal at the start of a glob in the NFA
+    TAM_GLOBSET_PREFIX,
+};
+
+// instructions of the NFA of a set. the wildcards loop on themselves.
+enum {
+    TAM_GLOBSET_CHAR,
+    TAM_GLOBSET_ANY,
+    TAM_GLOBSET_CLASS,
+    TAM_GLOBSET_STAR,
+    TAM_GLOBSET_GLOBSTAR,
+    // continue at both the next instruction and `x`
+    TAM_GLOBSET_SPLIT,
+    TAM_GLOBSET_MATCH,
+};
+
+tam_globset_t tam_globset_new(void) {
+    tam_globset_t set;
+    memset(&set, 0, sizeof(set));
+    return set;
+}
+
+void tam_globset_deallocate(tam_globset_t *set) {
+    tam_deallocate(set->entries);
+    tam_deallocate(set->buckets);
+    tam_deallocate(set->keys);
+    tam_deallocate(set->prog);
+    tam_deallocate(set->classes);
+    tam_deallocate(set->lists[0]);
+    tam_deallocate(set->lists[1]);
+    tam_deallocate(set->mark);
+    tam_deallocate(set->stack);
+    tam_deallocate(set->hits);
+    set->len = 0;
+}
+
+// FNV-1a, which can be computed incrementally over the prefixes of a path
+#define TAM_GLOBSET_HASH_BYTE(h, c) (((h) ^ (u8)(c)) * 0x100000001b3ull)
+
+static u64 tam_globset_hash(u8 kind, tam_slice_t key) {
+    u64 h = 0xcbf29ce484222325ull ^ kind;
+    for (int i = 0; i < key.len; i++)
+        h = TAM_GLOBSET_HASH_BYTE(h, key.buf[i]);
+    return h;
+}
+
+static void tam_globset_insert(tam_globset_t *set, u8 kind, tam_slice_t key, int value) {
+    if (set->num_entries == set->entries_cap) {
+        set->entries_cap = set->entries_cap ? 2 * set->entries_cap : 16;
+        set->entries = tam_reallocate(set->entries, struct tam_globset_entry_t, set->entries_cap);
+    }
+    if (set->keys_len + key.len > set->keys_cap) {
+        set->keys_cap = tam_grow_capacity(set->keys_cap, set->keys_len + key.len);
+        set->keys = tam_reallocate(set->keys, char, set->keys_cap);
+    }
+    if (key.len > 0)
+        memcpy(set->keys + set->keys_len, key.buf, key.len);
+    struct tam_globset_entry_t *e = &set->entries[set->num_entries++];
+    e->hash = tam_globset_hash(kind, key);
+    e->kind = kind;
+    e->value = value;
+    e->key = set->keys_len;
+    e->key_len = key.len;
+    set->keys_len += key.len;
+
+    // keep the load factor at most 1/2
+    if (2 * set->num_entries > set->num_buckets) {
+        set->num_buckets = set->num_buckets ? 2 * set->num_buckets : 32;
+        set->buckets = tam_reallocate(set->buckets, int, set->num_buckets);
+        for (int i = 0; i < set->num_buckets; i++)
+            set->buckets[i] = -1;
+        for (int i = 0; i < set->num_entries; i++) {
+            int b = set->entries[i].hash & (set->num_buckets - 1);
+            set->entries[i].next = set->buckets[b];
+            set->buckets[b] = i;
+        }
+    } else {
+        int b = e->hash & (set->num_buckets - 1);
+        e->next = set->buckets[b];
+        set->buckets[b] = set->num_entries - 1;
+    }
+}
+
+static void tam_globset_emit(tam_globset_t *set, int op, int c, int x) {
+    if (set->prog_len == set->prog_cap) {
+        set->prog_cap = set->prog_cap ? 2 * set->prog_cap : 64;
+        set->prog = tam_reallocate(set->prog, struct tam_globset_inst_t, set->prog_cap);
+    }
+    set->prog[set->prog_len++] = (struct tam_globset_inst_t){(u8)op, (u8)c, x};
+}
+
+static bool tam_glob_literal_has(const tam_glob_t *g, const tam_glob_token_t *t, char c) {
+    return memchr(g->literals + t->index, c, t->len) != NULL;
+}
+
+int tam_globset_add(tam_globset_t *set, const char *pattern) {
+    tam_glob_t g = tam_glob_compile(pattern);
+    if (g.error != NULL) {
+        tam_glob_deallocate(&g);
+        return -1;
+    }
+    int index = set->len++;
+    const tam_glob_token_t *t = g.tokens;
+    if (g.len == 0) {
+        tam_globset_insert(set, TAM_GLOBSET_EXACT, tam_slice_n((const char *)NULL, 0), index);
+    } else if (g.len == 1 && t[0].op == TAM_GLOB_LITERAL) {
+        tam_globset_insert(set, TAM_GLOBSET_EXACT, tam_slice_n(g.literals + t[0].index, t[0].len), index);
+    } else if (g.len == 2 && t[0].op == TAM_GLOB_DIRS && t[1].op == TAM_GLOB_LITERAL &&
+               !tam_glob_literal_has(&g, &t[1], '/')) {
+        tam_globset_insert(set, TAM_GLOBSET_BASENAME, tam_slice_n(g.literals + t[1].index, t[1].len), index);
+    } else if (g.len == 3 && t[0].op == TAM_GLOB_DIRS && t[1].op == TAM_GLOB_STAR && t[2].op == TAM_GLOB_LITERAL &&
+               g.literals[t[2].index] == '.' && !tam_glob_literal_has(&g, &t[2], '/')) {
+        tam_globset_insert(set, TAM_GLOBSET_EXTENSION, tam_slice_n(g.literals + t[2].index, t[2].len), index);
+    } else {
+        // add the glob to the NFA
+        int classes = set->num_classes;
+        if (g.num_classes > 0) {
+            set->classes = (u64(*)[4])tam_reallocate(set->classes, u64[4], classes + g.num_classes);
+            memcpy(set->classes + classes, g.classes, g.num_classes * sizeof(u64[4]));
+            set->num_classes += g.num_classes;
+        }
+        // the literal the glob starts with is matched by the hash table
+        tam_slice_t prefix = tam_slice_n((const char *)NULL, 0);
+        if (t[0].op == TAM_GLOB_LITERAL)
+            prefix = tam_slice_n(g.literals + t[0].index, t[0].len);
+        tam_globset_insert(set, TAM_GLOBSET_PREFIX, prefix, set->prog_len);
+        if (prefix.len > set->max_prefix)
+            set->max_prefix = prefix.len;
+        for (int i = prefix.len > 0; i < g.len; i++) {
+            switch (t[i].op) {
+            case TAM_GLOB_LITERAL:
+                for (int k = 0; k < t[i].len; k++)
+                    tam_globset_emit(set, TAM_GLOBSET_CHAR, (u8)g.literals[t[i].index + k], 0);
+                break;
+            case TAM_GLOB_ANY: tam_globset_emit(set, TAM_GLOBSET_ANY, 0, 0); break;
+            case TAM_GLOB_CLASS: tam_globset_emit(set, TAM_GLOBSET_CLASS, 0, classes + t[i].index); break;
+            case TAM_GLOB_STAR: tam_globset_emit(set, TAM_GLOBSET_STAR, 0, 0); break;
+            case TAM_GLOB_GLOBSTAR: tam_globset_emit(set, TAM_GLOBSET_GLOBSTAR, 0, 0); break;
+            case TAM_GLOB_DIRS:
+                // nothing, or anything followed by a `/`
+                tam_globset_emit(set, TAM_GLOBSET_SPLIT, 0, set->prog_len + 3);
+                tam_globset_emit(set, TAM_GLOBSET_GLOBSTAR, 0, 0);
+                tam_globset_emit(set, TAM_GLOBSET_CHAR, '/', 0);
+                break;
+            }
+        }
+        tam_globset_emit(set, TAM_GLOBSET_MATCH, 0, index);
+    }
+    set->dirty = true;
+    tam_glob_deallocate(&g);
+    return index;
+}
+
+// Add the state at `pc` and the states it reaches without consuming input to `list`
+static void tam_globset_add_state(tam_globset_t *set, int *list, int *len, int pc) {
+    int sp = 0;
+    set->stack[sp++] = pc;
+    while (sp > 0) {
+        pc = set->stack[--sp];
+        if (set->mark[pc] == set->gen)
+            continue;
+        set->mark[pc] = set->gen;
+        const struct tam_globset_inst_t *inst = &set->prog[pc];
+        if (inst->op == TAM_GLOBSET_SPLIT) {
+            set->stack[sp++] = inst->x;
+            set->stack[sp++] = pc + 1;
+            continue;
+        }
+        list[(*len)++] = pc;
+        // a wildcard can also match nothing
+        if (inst->op == TAM_GLOBSET_STAR || inst->op == TAM_GLOBSET_GLOBSTAR)
+            set->stack[sp++] = pc + 1;
+    }
+}
+
+// Resize the scratch space for matching after globs were added
+static void tam_globset_prepare(tam_globset_t *set) {
+    // sizes are rounded up so that nothing is reallocated to zero bytes
+    int n = set->prog_len;
+    for (int i = 0; i < 2; i++)
+        set->lists[i] = tam_reallocate(set->lists[i], int, n + 1);
+    set->mark = tam_reallocate(set->mark, u32, n + 1);
+    memset(set->mark, 0, (n + 1) * sizeof(u32));
+    set->gen = 0;
+    // every state is expanded once, and pushes at most two others
+    set->stack = tam_reallocate(set->stack, int, 2 * n + 1);
+    set->hits = tam_reallocate(set->hits, int, set->len + 1);
+
+    set->dirty = false;
+}
+
+// Start a new generation of marks. Once the counter wraps around, a stale mark could equal the new generation
+// and drop a state, so the marks are cleared instead.
+static inline void tam_globset_next_gen(tam_globset_t *set) {
+    if (++set->gen == 0) {
+        memset(set->mark, 0, (set->prog_len + 1) * sizeof(u32));
+        set->gen = 1;
+    }
+}
+
+// Whether NFA state `pc` consumes byte `c`
+static inline bool tam_globset_consumes(const tam_globset_t *set, int pc, u8 c) {
+    const struct tam_globset_inst_t *inst = &set->prog[pc];
+    switch (inst->op) {
+    case TAM_GLOBSET_CHAR: return inst->c == c;
+    case TAM_GLOBSET_CLASS: return tam_glob_in_class(set->classes[inst->x], c);
+    case TAM_GLOBSET_ANY:
+    case TAM_GLOBSET_STAR: return c != '/';
+    case TAM_GLOBSET_GLOBSTAR: return true;
+    default: return false;
+    }
+}
+
+// Collect the globs in the set that match `path` into `set->hits`, stopping at the first one if `first_only`.
+// Returns the number found.
+static int tam_globset_run(tam_globset_t *set, tam_slice_t path, bool first_only) {
+    if (set->dirty)
+        tam_globset_prepare(set);
+    int num_hits = 0;
+
+    // the hash table: the whole path, its last component, and the suffixes of the last component from each `.`
+    if (set->num_entries > 0) {
+        int base = path.len;
+        while (base > 0 && path.buf[base - 1] != '/')
+            base--;
+        for (int k = base - 2; k < path.len; k++) {
+            u8 kind = TAM_GLOBSET_EXTENSION;
+            tam_slice_t key = tam_slice_n(path.buf + k, path.len - k);
+            if (k == base - 2) {
+                kind = TAM_GLOBSET_EXACT;
+                key = path;
+            } else if (k == base - 1) {
+                kind = TAM_GLOBSET_BASENAME;
+                key = tam_slice_n(path.buf + base, path.len - base);
+            } else if (path.buf[k] != '.') {
+                continue;
+            }
+            u64 h = tam_globset_hash(kind, key);
+            for (int e = set->buckets[h & (set->num_buckets - 1)]; e >= 0; e = set->entries[e].next) {
+                const struct tam_globset_entry_t *entry = &set->entries[e];
+                if (entry->hash == h && entry->kind == kind && entry->key_len == key.len &&
+                    (key.len == 0 || memcmp(set->keys + entry->key, key.buf, key.len) == 0)) {
+                    set->hits[num_hits++] = entry->value;
+                    if (first_only)
+                        return num_hits;
+                }
+            }
+        }
+    }
+    if (set->prog_len == 0)
+        return num_hits;
+
+    // the NFA, which globs join at the end of their leading literal
+    int *clist = set->lists[0], *nlist = set->lists[1];
+    int clen = 0;
+    tam_globset_next_gen(set);
+    u64 h = tam_globset_hash(TAM_GLOBSET_PREFIX, tam_slice_n(path.buf, 0));
+    for (int i = 0;; i++) {
+        if (i <= set->max_prefix) {
+            for (int e = set->buckets[h & (set->num_buckets - 1)]; e >= 0; e = set->entries[e].next) {
+                const struct tam_globset_entry_t *entry = &set->entries[e];
+                if (entry->hash == h && entry->kind == TAM_GLOBSET_PREFIX && entry->key_len == i &&
+                    (i == 0 || memcmp(set->keys + entry->key, path.buf, i) == 0))
+                    tam_globset_add_state(set, clist, &clen, entry->value);
+            }
+        }
+        // stop at the end, or when no glob is left or can still join
+        if (i == path.len || (clen == 0 && i >= set->max_prefix))
+            break;
+        u8 c = path.buf[i];
+        int nlen = 0;
+        tam_globset_next_gen(set);
+        for (int k = 0; k < clen; k++) {
+            int pc = clist[k];
+            if (tam_globset_consumes(set, pc, c)) {
+                int op = set->prog[pc].op;
+                tam_globset_add_state(set, nlist, &nlen, op == TAM_GLOBSET_STAR || op == TAM_GLOBSET_GLOBSTAR ? pc : pc + 1);
+            }
+        }
+        int *tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+        clen = nlen;
+        h = TAM_GLOBSET_HASH_BYTE(h, c);
+    }
+    for (int k = 0; k < clen; k++) {
+        const struct tam_globset_inst_t *inst = &set->prog[clist[k]];
+        if (inst->op == TAM_GLOBSET_MATCH) {
+            set->hits[num_hits++] = inst->x;
+            if (first_only)
+                return num_hits;
+        }
+    }
+    return num_hits;
+}
+
+bool tam_globset_is_match(tam_globset_t *set, tam_slice_t path) { return tam_globset_run(set, path, true) > 0; }
+
+static int tam_globset_cmp_int(const void *a, const void *b) { return *(const int *)a - *(const int *)b; }
+
+int tam_globset_matches(tam_globset_t *set, tam_slice_t path, int *out, int max) {
+    int n = tam_globset_run(set, path, false);
+    qsort(set->hits, n, sizeof(int), tam_globset_cmp_int);
+    memcpy(out, set->hits, (n < max ? n : max) * sizeof(int));
+    return n;
+}
+
+// end glob sets }}}
+
+#if defined(TAM_TEST)
+
+#include <stdio.h>
+
+// ### Glob tests {{{
+int tam_test_glob() {
+    struct {
+        const char *pattern;
+        const char *path;
+        bool match;
+    } cases[] = {
+        {"", "", true},
+        {"", "a", false},
+        {"abc", "abc", true},
+        {"abc", "abcd", false},
+        {"a?c", "abc", true},
+        {"a?c", "a/c", false},
+        {"*", "", true},
+        {"*", "file.txt", true},
+        {"*", "dir/file.txt", false},
+        {"*.txt", "notes.txt", true},
+        {"*.txt", "notes.txt.bak", false},
+        {"*.txt", "a/notes.txt", false},
+        {"a*b*c", "axxbyybzzc", true},
+        {"a*b*c", "axxbyybzz", false},
+        {"*a*a*a*a*b", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", false},
+        {"[abc]x", "bx", true},
+        {"[!abc]x", "bx", false},
+        {"[^abc]x", "dx", true},
+        {"[a-c][0-9]", "c7", true},
+        {"[]]", "]", true},
+        {"[!a]", "/", false},
+        {"\\*", "*", true},
+        {"\\*", "a", false},
+        {"**", "a/b/c", true},
+        {"**", "", true},
+        {"**/*.c", "main.c", true},
+        {"**/*.c", "src/lib/main.c", true},
+        {"**/*.c", "src/lib/main.h", false},
+        {"src/**/test_*.c", "src/test_a.c", true},
+        {"src/**/test_*.c", "src/x/y/test_a.c", true},
+        {"src/**/test_*.c", "src/x/y/test_a/b.c", false},
+        {"src/**", "src/a/b", true},
+        {"src/**", "srcs/a", false},
+        {"a/**/b/**/c", "a/b/c", true},
+        {"a/**/b/**/c", "a/x/b/y/z/c", true},
+        {"a/**/b/**/c", "a/x/c", false},
+        {"a**b", "axxb", true},
+        {"a**b", "ax/xb", false},
+        {"*/*/*.h", "include/tam/glob.h", true},
+        {"*/*.h", "include/tam/glob.h", false},
+        {"*x*/b", "axa/b", true},
+        {"**/x*/b", "q/axa/x/b", true},
+    };
+    for (usize k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        tam_glob_t g = tam_glob_compile(cases[k].pattern);
+        assert(g.error == NULL);
+        assert(tam_glob_match(&g, tam_slice(cases[k].path)) == cases[k].match);
+        tam_glob_deallocate(&g);
+
+        // a set with just this glob agrees
+        tam_globset_t set = tam_globset_new();
+        assert(tam_globset_add(&set, cases[k].pattern) == 0);
+        assert(tam_globset_is_match(&set, tam_slice(cases[k].path)) == cases[k].match);
+        tam_globset_deallocate(&set);
+    }
+
+    const char *invalid[] = {"[abc", "a\\", "[z-a]"};
+    for (usize k = 0; k < sizeof(invalid) / sizeof(invalid[0]); k++) {
+        tam_glob_t g = tam_glob_compile(invalid[k]);
+        assert(g.error != NULL);
+        tam_glob_deallocate(&g);
+    }
+
+    {
+        // a set with every kind of glob, and many that don't match
+        tam_globset_t set = tam_globset_new();
+        char pattern[64];
+        for (int i = 0; i < 1000; i++) {
+            sprintf(pattern, "**/*.ext%d", i);
+            assert(tam_globset_add(&set, pattern) == 2 * i);
+            sprintf(pattern, "dir%d/*", i);
+            assert(tam_globset_add(&set, pattern) == 2 * i + 1);
+        }
+        assert(tam_globset_add(&set, "src/main.c") == 2000);
+        assert(tam_globset_add(&set, "**/main.c") == 2001);
+        assert(tam_globset_add(&set, "**/*.c") == 2002);
+        assert(tam_globset_add(&set, "src/*.c") == 2003);
+        assert(tam_globset_add(&set, "*.h") == 2004);
+        assert(tam_globset_add(&set, "[") == -1);
+        assert(tam_globset_add(&set, "**/*.tar.gz") == 2005);
+        assert(tam_globset_add(&set, "src/**") == 2006);
+
+        int out[8];
+        assert(tam_globset_matches(&set, tam_slice("src/main.c"), out, 8) == 5);
+        assert(out[0] == 2000 && out[1] == 2001 && out[2] == 2002 && out[3] == 2003 && out[4] == 2006);
+        assert(tam_globset_matches(&set, tam_slice("lib/main.c"), out, 8) == 2);
+        assert(out[0] == 2001 && out[1] == 2002);
+        assert(tam_globset_matches(&set, tam_slice("a/b.tar.gz"), out, 1) == 1 && out[0] == 2005);
+        assert(tam_globset_matches(&set, tam_slice("x.ext517"), out, 8) == 1 && out[0] == 1034);
+        assert(tam_globset_matches(&set, tam_slice("dir517/x.ext3"), out, 8) == 2);
+        assert(out[0] == 6 && out[1] == 1035);
+        assert(tam_globset_matches(&set, tam_slice("dir517/a/x"), out, 8) == 0);
+        assert(tam_globset_is_match(&set, tam_slice("glob.h")));
+        assert(!tam_globset_is_match(&set, tam_slice("include/glob.h")));
+        assert(!tam_globset_is_match(&set, tam_slice("")));
+
+        // the generation counter of the matcher can wrap around in a long-lived set
+        set.gen = UINT32_MAX - 2;
+        for (int k = 0; k < 2; k++) {
+            assert(tam_globset_matches(&set, tam_slice("src/lib/util.c"), out, 8) == 2);
+            assert(out[0] == 2002 && out[1] == 2006);
+        }
+        assert(set.gen < 100);
+        tam_globset_deallocate(&set);
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end glob tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_GLOB_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_GLOB_H
@@ -0,0 +1,807 @@
+#ifndef TAM_JSON_H
+#define TAM_JSON_H
+
+// TAM JSON utilities
+//
+// Escaping and unescaping of JSON string contents between slices and StringBuilders,
+// and a tokenizer that turns a JSON document into a flat tape of tokens that can be navigated on demand.
+
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+#include <tam/stringbuilder.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## JSON string declarations *** {{{
+/*
+ * Append the contents of a slice to a StringBuilder, escaped so that it can be placed between double
+ * quotes in a JSON document. Quotes, backslashes and control characters are escaped, all other bytes
+ * (including UTF-8 sequences) are copied as-is. The surrounding quotes are not added.
+ * The input is scanned 16 or 32 bytes at a time, and runs of bytes that need no escaping are copied in bulk.
+ */
+void tam_sb_append_json_escaped(tam_stringbuilder_t *sb, tam_slice_t s);
+
+/*
+ * Append the contents of a JSON string (without the surrounding quotes) to a StringBuilder,
+ * replacing escape sequences by the bytes they represent. `\uXXXX` escapes, including surrogate pairs,
+ * are written as UTF-8.
+ * Returns false if the input contains an invalid escape sequence, in which case the builder contains
+ * everything up to the invalid escape.
+ */
+bool tam_sb_append_json_unescaped(tam_stringbuilder_t *sb, tam_slice_t s);
+
+// end JSON string declarations }}}
+
+//*** ## JSON tokenizer declarations *** {{{
+/*
+ * The tokenizer works in two stages, like simdjson. Stage 1 looks at 64 bytes at a time and builds bitmasks
+ * of backslashes, quotes, structural characters and whitespace with vector compares. Escaped quotes are removed,
+ * the insides of strings are found with a prefix XOR of the remaining quotes (a carry-less multiply with PCLMUL),
+ * and the positions of the brackets, colons, commas, quotes and the first byte of every number or literal
+ * outside of strings are written to an index. Stage 2 walks the index, checks the grammar and writes the tape.
+ *
+ * The tape holds one token per value, in document order: a container is followed by its children, and each
+ * member of an object is a string token for the key followed by the value. Tokens reference the input,
+ * which must outlive the tape. Nothing is decoded up front: strings keep their escapes and numbers their text,
+ * and are converted only when asked for, so pulling a few fields out of a large document costs little more
+ * than finding them. Every token knows where its value ends on the tape, so skipping a value is O(1).
+ */
+
+// maximum nesting depth of arrays and objects
+#ifndef TAM_JSON_MAX_DEPTH
+#define TAM_JSON_MAX_DEPTH 1024
+#endif
+
+typedef enum tam_json_type_t {
+    TAM_JSON_NULL,
+    TAM_JSON_FALSE,
+    TAM_JSON_TRUE,
+    TAM_JSON_NUMBER,
+    TAM_JSON_STRING,
+    TAM_JSON_ARRAY,
+    TAM_JSON_OBJECT,
+} tam_json_type_t;
+
+typedef struct tam_json_token_t {
+    tam_json_type_t type;
+    // index of the first token after this value, i.e. after all of its children
+    int end;
+    // the text of the value: strings without their quotes and still escaped, numbers and literals as written,
+    // arrays and objects from the opening to the closing bracket
+    tam_slice_t text;
+} tam_json_token_t;
+
+typedef struct tam_json_t {
+    // tokens[0] is the root value
+    tam_json_token_t *tokens;
+    int len;
+} tam_json_t;
+
+/*
+ * Tokenize a JSON document, allocating the tape in `arena`, which needs room for 24 bytes per value (member names
+ * included). The tape is built in a temporary buffer and only copied to the arena if the document is valid.
+ * The structure of the document is validated, as are numbers and literals. Strings are only checked for
+ * control characters: invalid escapes are reported when the string is unescaped, and UTF-8 can be checked
+ * with `sl_utf8_valid`.
+ * Returns false if the document is invalid or nested deeper than TAM_JSON_MAX_DEPTH, leaving `json` empty.
+ */
+bool tam_json_parse(tam_json_t *json, tam_slice_t input, tam_arena_t *arena);
+
+/*
+ * Find the value of member `key` in the object at token `obj`. The key is compared to the raw (escaped) text of
+ * the member names. Returns the index of the value token, or -1 if there is no such member or `obj` is not an object.
+ */
+int tam_json_find(const tam_json_t *json, int obj, tam_slice_t key);
+
+/*
+ * Find element `i` of the array at token `arr`.
+ * Returns the index of the element's token, or -1 if `i` is out of range or `arr` is not an array.
+ */
+int tam_json_index(const tam_json_t *json, int arr, int i);
+
+/*
+ * Follow a path of object keys and array indices separated by `.`, e.g. "statuses.0.user.id", starting at token `tok`.
+ * Returns the index of the token at the end of the path, or -1 if it does not exist.
+ */
+int tam_json_path(const tam_json_t *json, int tok, const char *path);
+
+/*
+ * Number of elements of an array or members of an object. Returns 0 for other values.
+ */
+int tam_json_count(const tam_json_t *json, int tok);
+
+/*
+ * Convert a number token to an integer. Returns false if the token is not a number or not an integer that fits in an i64.
+ */
+bool tam_json_to_i64(const tam_json_t *json, int tok, i64 *out);
+
+/*
+ * Convert a number token to a double. Returns false if the token is not a number.
+ */
+bool tam_json_to_f64(const tam_json_t *json, int tok, f64 *out);
+
+/*
+ * Convert a string token to its value and append it to a StringBuilder.
+ * Returns false if the token is not a string or contains an invalid escape.
+ */
+bool tam_json_to_string(const tam_json_t *json, int tok, tam_stringbuilder_t *sb);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_JSON) ///{{{
+#define sb_append_json_escaped tam_sb_append_json_escaped
+#define sb_append_json_unescaped tam_sb_append_json_unescaped
+typedef tam_json_type_t json_type_t;
+typedef tam_json_token_t json_token_t;
+typedef tam_json_t json_t;
+#define json_parse tam_json_parse
+#define json_find tam_json_find
+#define json_index tam_json_index
+#define json_path tam_json_path
+#define json_count tam_json_count
+#define json_to_i64 tam_json_to_i64
+#define json_to_f64 tam_json_to_f64
+#define json_to_string tam_json_to_string
+#endif // end JSON namespace }}}
+
+// end JSON tokenizer declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_JSON_IMPLEMENTATION)
+
+// ### JSON string implementation {{{
+
+// Length of the initial run of bytes in `s` that need no escaping
+static usize tam_json_clean_run(const char *s, usize n) {
+    usize i = 0;
+#if defined(TAM_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i ctrl32 = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        // v <= 0x1f (unsigned) iff min(v, 0x1f) == v
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, backslash32)),
+                                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl32), v));
+        u32 mask = _mm256_movemask_epi8(m);
+        if (mask != 0)
+            return i + tam_ctz32(mask);
+    }
+#endif
+#if defined(TAM_SSE2)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i ctrl16 = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, backslash16)),
+                                 _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl16), v));
+        u32 mask = _mm_movemask_epi8(m);
+        if (mask != 0)
+            return i + tam_ctz32(mask);
+    }
+#endif
+    // eight bytes at a time: skip words with no quote, backslash or control byte
+    for (; i + 8 <= n; i += 8) {
+        u64 x = tam_load_u64(s + i);
+        if (TAM_SWAR_HAS_ZERO(x ^ TAM_SWAR_BYTES('"')) | TAM_SWAR_HAS_ZERO(x ^ TAM_SWAR_BYTES('\\')) |
+            TAM_SWAR_HAS_LESS(x, 0x20))
+            break;
+    }
+    for (; i < n; i++) {
+        u8 c = s[i];
+        if (c == '"' || c == '\\' || c < 0x20)
+            return i;
+    }
+    return n;
+}
+
+void tam_sb_append_json_escaped(tam_stringbuilder_t *sb, tam_slice_t s) {
+    static const char hex[] = "0123456789abcdef";
+    usize n = s.len;
+    usize i = 0;
+    while (i < n) {
+        usize run = tam_json_clean_run(s.buf + i, n - i);
+        tam_sb_appendcharsn(sb, s.buf + i, run);
+        i += run;
+        if (i >= n)
+            break;
+
+        u8 c = s.buf[i++];
+        char esc[6] = {'\\', 0};
+        int len = 2;
+        switch (c) {
+        case '"': esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        default:
+            memcpy(esc + 1, "u00", 3);
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xf];
+            len = 6;
+        }
+        tam_sb_appendcharsn(sb, esc, len);
+    }
+}
+
+// Parse four hex digits. Returns -1 if any of them is not a hex digit.
+static int tam_json_hex4(const char *p) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int d;
+        if (c >= '0' && c <= '9')
+            d = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            d = c - 'A' + 10;
+        else
+            return -1;
+        v = (v << 4) | d;
+    }
+    return v;
+}
+
+// Append a codepoint as UTF-8
+static void tam_json_append_utf8(tam_stringbuilder_t *sb, u32 cp) {
+    char buf[4];
+    int len;
+    if (cp < 0x80) {
+        buf[0] = cp;
+        len = 1;
+    } else if (cp < 0x800) {
+        buf[0] = 0xc0 | (cp >> 6);
+        buf[1] = 0x80 | (cp & 0x3f);
+        len = 2;
+    } else if (cp < 0x10000) {
+        buf[0] = 0xe0 | (cp >> 12);
+        buf[1] = 0x80 | ((cp >> 6) & 0x3f);
+        buf[2] = 0x80 | (cp & 0x3f);
+        len = 3;
+    } else {
+        buf[0] = 0xf0 | (cp >> 18);
+        buf[1] = 0x80 | ((cp >> 12) & 0x3f);
+        buf[2] = 0x80 | ((cp >> 6) & 0x3f);
+        buf[3] = 0x80 | (cp & 0x3f);
+        len = 4;
+    }
+    tam_sb_appendcharsn(sb, buf, len);
+}
+
+bool tam_sb_append_json_unescaped(tam_stringbuilder_t *sb, tam_slice_t s) {
+    const char *p = s.buf;
+    const char *end = s.buf + s.len;
+    while (p < end) {
+        // copy everything up to the next backslash in bulk (memchr is vectorized in every libc we care about)
+        const char *bs = (const char *)memchr(p, '\\', end - p);
+        if (bs == NULL) {
+            tam_sb_appendcharsn(sb, p, end - p);
+            return true;
+        }
+        tam_sb_appendcharsn(sb, p, bs - p);
+        p = bs + 1;
+        if (p >= end)
+            return false;
+
+        char c = *p++;
+        switch (c) {
+        case '"': tam_sb_appendchar(sb, '"'); break;
+        case '\\': tam_sb_appendchar(sb, '\\'); break;
+        case '/': tam_sb_appendchar(sb, '/'); break;
+        case 'n': tam_sb_appendchar(sb, '\n'); break;
+        case 'r': tam_sb_appendchar(sb, '\r'); break;
+        case 't': tam_sb_appendchar(sb, '\t'); break;
+        case 'b': tam_sb_appendchar(sb, '\b'); break;
+        case 'f': tam_sb_appendchar(sb, '\f'); break;
+        case 'u': {
+            if (end - p < 4)
+                return false;
+            int cp = tam_json_hex4(p);
+            if (cp < 0)
+                return false;
+            p += 4;
+            if (cp >= 0xd800 && cp <= 0xdbff) {
+                // high surrogate, which must be followed by an escaped low surrogate
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                    return false;
+                int lo = tam_json_hex4(p + 2);
+                if (lo < 0xdc00 || lo > 0xdfff)
+                    return false;
+                p += 6;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+            } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+                return false;
+            }
+            tam_json_append_utf8(sb, cp);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// end JSON string implementation }}}
+
+// ### JSON tokenizer implementation {{{
+
+// Stage 1: write the positions of the structural characters, quotes and starts of numbers and literals outside
+// of strings to `*index`, growing it as needed. Returns the number of positions, or -1 if a string is unterminated
+// or contains a control character.
+static isize tam_json_index_structurals(const char *s, usize n, u32 **index, usize *cap) {
+    usize count = 0;
+    // whether the first byte of the next block is escaped, inside a string, or follows the body of a scalar
+    u64 escape_carry = 0;
+    u64 string_carry = 0;
+    u64 scalar_carry = 0;
+    for (usize i = 0; i < n; i += 64) {
+        tam_block64_t block;
+        u64 valid = ~0ull;
+        if (i + 64 <= n) {
+            block = tam_block64_load(s + i);
+        } else {
+            char tail[64] = {0};
+            memcpy(tail, s + i, n - i);
+            block = tam_block64_load(tail);
+            valid = (1ull << (n - i)) - 1;
+        }
+
+        // a backslash escapes the next byte, unless it is itself escaped. backslashes are rare, so we
+        // go through them one at a time.
+        u64 backslash = tam_block64_eq(&block, '\\') & valid;
+        u64 escaped = escape_carry;
+        escape_carry = 0;
+        backslash &= ~escaped;
+        while (backslash != 0) {
+            int b = tam_ctz64(backslash);
+            backslash &= backslash - 1;
+            if (b == 63) {
+                escape_carry = 1;
+            } else {
+                escaped |= 1ull << (b + 1);
+                backslash &= ~(1ull << (b + 1));
+            }
+        }
+
+        u64 quotes = tam_block64_eq(&block, '"') & ~escaped & valid;
+        // set from an opening quote up to, but not including, the closing quote
+        u64 in_string = tam_prefix_xor64(quotes) ^ string_carry;
+        string_carry = (u64)((i64)in_string >> 63);
+        if (tam_block64_le(&block, 0x1f) & in_string & valid)
+            return -1;
+
+        u64 ops = tam_block64_eq(&block, '{') | tam_block64_eq(&block, '}') | tam_block64_eq(&block, '[') |
+                  tam_block64_eq(&block, ']') | tam_block64_eq(&block, ':') | tam_block64_eq(&block, ',');
+        u64 ws = tam_block64_eq(&block, ' ') | tam_block64_eq(&block, '\n') | tam_block64_eq(&block, '\t') |
+                 tam_block64_eq(&block, '\r');
+        // the body of numbers and literals is everything else outside of strings
+        u64 scalar = ~(ops | ws | quotes | in_string) & valid;
+        u64 scalar_start = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        u64 structural = (ops & ~in_string) | quotes | scalar_start;
+        structural &= valid;
+
+        int bits = tam_popcount64(structural);
+        if (count + bits > *cap) {
+            usize newcap = tam_grow_capacity(*cap * sizeof(u32), (count + bits) * sizeof(u32)) / sizeof(u32);
+            *index = tam_reallocate_sized(*index, u32, *cap, newcap);
+            *cap = newcap;
+        }
+        u32 *out = *index + count;
+        for (; structural != 0; structural &= structural - 1)
+            *out++ = (u32)(i + tam_ctz64(structural));
+        count += bits;
+    }
+    if (string_carry != 0)
+        return -1;
+    return count;
+}
+
+// Length of the JSON number at the start of p, or 0 if there is none
+static int tam_json_number_len(const char *p, const char *end) {
+    const char *q = p;
+    if (q < end && *q == '-')
+        q++;
+    if (q < end && *q == '0') {
+        q++;
+    } else if (q < end && (u8)(*q - '1') < 9) {
+        while (q < end && (u8)(*q - '0') < 10)
+            q++;
+    } else {
+        return 0;
+    }
+    if (q < end && *q == '.') {
+        q++;
+        const char *digits = q;
+        while (q < end && (u8)(*q - '0') < 10)
+            q++;
+        if (q == digits)
+            return 0;
+    }
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        q++;
+        if (q < end && (*q == '+' || *q == '-'))
+            q++;
+        const char *digits = q;
+        while (q < end && (u8)(*q - '0') < 10)
+            q++;
+        if (q == digits)
+            return 0;
+    }
+    return q - p;
+}
+
+// Whether c ends a number or literal: whitespace, a structural character or a quote
+static inline bool tam_json_scalar_end(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '{' || c == '}' || c == '[' || c == ']' ||
+           c == ':' || c == ',' || c == '"';
+}
+
+// Classify and measure the number or literal starting at p. Returns false if it is neither.
+static bool tam_json_scalar(const char *p, const char *end, tam_json_type_t *type, int *len) {
+    const char *q = p;
+    while (q < end && !tam_json_scalar_end(*q))
+        q++;
+    int n = q - p;
+    if (n == 4 && memcmp(p, "null", 4) == 0)
+        *type = TAM_JSON_NULL;
+    else if (n == 4 && memcmp(p, "true", 4) == 0)
+        *type = TAM_JSON_TRUE;
+    else if (n == 5 && memcmp(p, "false", 5) == 0)
+        *type = TAM_JSON_FALSE;
+    else if (n > 0 && tam_json_number_len(p, q) == n)
+        *type = TAM_JSON_NUMBER;
+    else
+        return false;
+    *len = n;
+    return true;
+}
+
+bool tam_json_parse(tam_json_t *json, tam_slice_t input, tam_arena_t *arena) {
+    json->tokens = NULL;
+    json->len = 0;
+
+    usize cap = 0;
+    u32 *index = NULL;
+    isize count = tam_json_index_structurals(input.buf, input.len, &index, &cap);
+    if (count <= 0) {
+        tam_deallocate_sized(index, u32, cap);
+        return false;
+    }
+
+    // every value starts at a distinct position in the index, so this is enough room for the tape. It is built
+    // outside the arena and copied there once the number of values is known, so the arena only needs room for them.
+    tam_json_token_t *tokens = tam_reallocate_sized(NULL, tam_json_token_t, 0, count);
+    int ntok = 0;
+    // tokens of the open containers
+    int stack[TAM_JSON_MAX_DEPTH];
+    int depth = 0;
+
+    // Stage 2: a state machine over the index
+    enum { VALUE, AFTER_VALUE, KEY, COLON, FIRST_ELEMENT, FIRST_KEY } state = VALUE;
+    const char *buf = input.buf;
+    const char *end = input.buf + input.len;
+    bool ok = false;
+    isize i = 0;
+    while (i < count) {
+        const char *p = buf + index[i];
+        char c = *p;
+        switch (state) {
+        case FIRST_ELEMENT:
+        case FIRST_KEY:
+            if (c == (state == FIRST_ELEMENT ? ']' : '}'))
+                goto close;
+            state = state == FIRST_ELEMENT ? VALUE : KEY;
+            continue;
+
+        case KEY:
+            // keys are strings, parsed like any other string value
+            if (c != '"')
+                goto done;
+            // fallthrough
+        case VALUE: {
+            tam_json_token_t *tok = &tokens[ntok];
+            tok->end = ++ntok;
+            if (c == '{' || c == '[') {
+                if (depth == TAM_JSON_MAX_DEPTH)
+                    goto done;
+                tok->type = c == '{' ? TAM_JSON_OBJECT : TAM_JSON_ARRAY;
+                tok->text = tam_slice_n(p, 1);
+                stack[depth++] = ntok - 1;
+                state = c == '{' ? FIRST_KEY : FIRST_ELEMENT;
+                i++;
+                continue;
+            }
+            if (c == '"') {
+                // the closing quote is the next position in the index
+                if (i + 1 >= count || buf[index[i + 1]] != '"')
+                    goto done;
+                tok->type = TAM_JSON_STRING;
+                tok->text = tam_slice_n(p + 1, index[i + 1] - index[i] - 1);
+                state = state == KEY ? COLON : AFTER_VALUE;
+                i += 2;
+                continue;
+            }
+            int len;
+            if (state == KEY || !tam_json_scalar(p, end, &tok->type, &len))
+                goto done;
+            tok->text = tam_slice_n(p, len);
+            state = AFTER_VALUE;
+            i++;
+            continue;
+        }
+
+        case COLON:
+            if (c != ':')
+                goto done;
+            state = VALUE;
+            i++;
+            continue;
+
+        case AFTER_VALUE:
+            if (depth == 0)
+                goto done;
+            if (c == ',') {
+                state = tokens[stack[depth - 1]].type == TAM_JSON_OBJECT ? KEY : VALUE;
+                i++;
+                continue;
+            }
+            if (c != (tokens[stack[depth - 1]].type == TAM_JSON_OBJECT ? '}' : ']'))
+                goto done;
+        close: {
+            tam_json_token_t *tok = &tokens[stack[--depth]];
+            tok->end = ntok;
+            tok->text.len = p + 1 - tok->text.buf;
+            state = AFTER_VALUE;
+            i++;
+            continue;
+        }
+        }
+    }
+    ok = state == AFTER_VALUE && depth == 0;
+
+done:
+    tam_deallocate_sized(index, u32, cap);
+    if (ok) {
+        json->tokens = tam_arena_alloc(arena, tam_json_token_t, ntok);
+        memcpy(json->tokens, tokens, ntok * sizeof(tam_json_token_t));
+        json->len = ntok;
+    }
+    tam_deallocate_sized(tokens, tam_json_token_t, count);
+    return ok;
+}
+
+int tam_json_find(const tam_json_t *json, int obj, tam_slice_t key) {
+    if (obj < 0 || json->tokens[obj].type != TAM_JSON_OBJECT)
+        return -1;
+    // members are key, value pairs, and the next key comes after the value's children
+    for (int k = obj + 1; k < json->tokens[obj].end; k = json->tokens[k + 1].end) {
+        if (tam_sl_eq(json->tokens[k].text, key))
+            return k + 1;
+    }
+    return -1;
+}
+
+int tam_json_index(const tam_json_t *json, int arr, int i) {
+    if (arr < 0 || json->tokens[arr].type != TAM_JSON_ARRAY || i < 0)
+        return -1;
+    int tok = arr + 1;
+    for (; tok < json->tokens[arr].end && i > 0; i--)
+        tok = json->tokens[tok].end;
+    return tok < json->tokens[arr].end ? tok : -1;
+}
+
+int tam_json_path(const tam_json_t *json, int tok, const char *path) {
+    while (tok >= 0 && *path != '\0') {
+        const char *dot = strchr(path, '.');
+        tam_slice_t part = tam_slice_n(path, dot ? dot - path : (int)strlen(path));
+        i64 i;
+        if (json->tokens[tok].type == TAM_JSON_ARRAY && tam_sl_parse_i64(part, &i) && i <= INT32_MAX)
+            tok = tam_json_index(json, tok, (int)i);
+        else
+            tok = tam_json_find(json, tok, part);
+        path += part.len + (dot != NULL);
+    }
+    return tok;
+}
+
+int tam_json_count(const tam_json_t *json, int tok) {
+    if (tok < 0)
+        return 0;
+    tam_json_type_t type = json->tokens[tok].type;
+    if (type != TAM_JSON_ARRAY && type != TAM_JSON_OBJECT)
+        return 0;
+    int n = 0;
+    for (int t = tok + 1; t < json->tokens[tok].end; t = json->tokens[t].end)
+        n++;
+    return type == TAM_JSON_OBJECT ? n / 2 : n;
+}
+
+bool tam_json_to_i64(const tam_json_t *json, int tok, i64 *out) {
+    return tok >= 0 && json->tokens[tok].type == TAM_JSON_NUMBER && tam_sl_parse_i64(json->tokens[tok].text, out);
+}
+
+bool tam_json_to_f64(const tam_json_t *json, int tok, f64 *out) {
+    return tok >= 0 && json->tokens[tok].type == TAM_JSON_NUMBER && tam_sl_parse_f64(json->tokens[tok].text, out);
+}
+
+bool tam_json_to_string(const tam_json_t *json, int tok, tam_stringbuilder_t *sb) {
+    return tok >= 0 && json->tokens[tok].type == TAM_JSON_STRING &&
+           tam_sb_append_json_unescaped(sb, json->tokens[tok].text);
+}
+
+// end JSON tokenizer implementation }}}
+
+#if defined(TAM_TEST)
+
+// ### JSON tests {{{
+int tam_test_json() {
+    {
+        // escaping
+        tam_stringbuilder_t sb = tam_sb_new();
+        tam_sb_append_json_escaped(&sb, tam_slice("plain text that is long enough to take the vector path"));
+        assert(tam_sl_eqstr(tam_sb_view(&sb), "plain text that is long enough to take the vector path"));
+
+        tam_sb_clear(&sb);
+        const char raw[] = "a \"quoted\" \\path\\ with\ttabs,\nnewlines and a bell \a, then some more text after it";
+        tam_sb_append_json_escaped(&sb, tam_slice(raw));
+        const char *escaped = "a \\\"quoted\\\" \\\\path\\\\ with\\ttabs,\\nnewlines and a bell \\u0007, then some "
+                              "more text after it";
+        assert(tam_sl_eqstr(tam_sb_view(&sb), escaped));
+
+        // and back again
+        tam_stringbuilder_t out = tam_sb_new();
+        assert(tam_sb_append_json_unescaped(&out, tam_sb_view(&sb)));
+        assert(tam_sl_eqstr(tam_sb_view(&out), raw));
+
+        // every byte value survives a round trip
+        char bytes[256];
+        for (int i = 0; i < 256; i++)
+            bytes[i] = (char)(i + 1);
+        tam_sb_clear(&sb);
+        tam_sb_clear(&out);
+        tam_sb_append_json_escaped(&sb, tam_slice_n(bytes, 256));
+        assert(tam_sb_append_json_unescaped(&out, tam_sb_view(&sb)));
+        assert(out.len == 256 && memcmp(out.buf, bytes, 256) == 0);
+
+        tam_sb_deallocate(&sb);
+        tam_sb_deallocate(&out);
+    }
+    {
+        // unicode escapes and invalid input
+        tam_stringbuilder_t sb = tam_sb_new();
+        assert(tam_sb_append_json_unescaped(&sb, tam_slice("caf\\u00e9 \\u20ac \\ud83d\\ude00 \\/")));
+        assert(tam_sl_eqstr(tam_sb_view(&sb), "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 /"));
+
+        tam_sb_clear(&sb);
+        assert(!tam_sb_append_json_unescaped(&sb, tam_slice("bad \\x escape")));
+        assert(tam_sl_eqstr(tam_sb_view(&sb), "bad "));
+        assert(!tam_sb_append_json_unescaped(&sb, tam_slice("trailing \\")));
+        assert(!tam_sb_append_json_unescaped(&sb, tam_slice("short \\u12")));
+        assert(!tam_sb_append_json_unescaped(&sb, tam_slice("lone \\udc00 surrogate")));
+        assert(!tam_sb_append_json_unescaped(&sb, tam_slice("unpaired \\ud800 surrogate")));
+        tam_sb_deallocate(&sb);
+    }
+
+    {
+        // tokenizing
+        const char *doc = "{\"id\": 12345, \"name\": \"tam \\\"json\\\"\", \"tags\": [\"a\", \"b\\\\\", []],\n"
+                          " \"nested\": {\"pi\": -3.25e0, \"ok\": true, \"none\": null, \"no\": false, \"e\": {}},\n"
+                          " \"big\": 18446744073709551616}";
+        tam_arena_t arena = tam_arena_new(1 << 16);
+        tam_json_t json;
+        assert(tam_json_parse(&json, tam_slice(doc), &arena));
+        assert(json.tokens[0].type == TAM_JSON_OBJECT && json.tokens[0].end == json.len);
+        assert(json.tokens[0].text.len == (int)strlen(doc));
+        assert(tam_json_count(&json, 0) == 5);
+
+        i64 i;
+        f64 x;
+        assert(tam_json_to_i64(&json, tam_json_path(&json, 0, "id"), &i) && i == 12345);
+        assert(tam_json_to_f64(&json, tam_json_path(&json, 0, "nested.pi"), &x) && x == -3.25);
+        assert(!tam_json_to_i64(&json, tam_json_path(&json, 0, "big"), &i));
+        assert(tam_json_to_f64(&json, tam_json_path(&json, 0, "big"), &x) && x == 18446744073709551616.0);
+        assert(json.tokens[tam_json_path(&json, 0, "nested.ok")].type == TAM_JSON_TRUE);
+        assert(json.tokens[tam_json_path(&json, 0, "nested.none")].type == TAM_JSON_NULL);
+        assert(json.tokens[tam_json_path(&json, 0, "nested.no")].type == TAM_JSON_FALSE);
+        assert(tam_json_count(&json, tam_json_path(&json, 0, "nested.e")) == 0);
+        assert(tam_json_count(&json, tam_json_path(&json, 0, "tags")) == 3);
+        assert(tam_json_path(&json, 0, "tags.3") == -1);
+        assert(tam_json_path(&json, 0, "missing") == -1);
+        assert(tam_json_count(&json, tam_json_path(&json, 0, "missing")) == 0);
+        assert(tam_json_path(&json, 0, "id.x") == -1);
+
+        tam_stringbuilder_t sb = tam_sb_new();
+        assert(tam_json_to_string(&json, tam_json_path(&json, 0, "name"), &sb));
+        assert(tam_sl_eqstr(tam_sb_view(&sb), "tam \"json\""));
+        tam_sb_clear(&sb);
+        assert(tam_json_to_string(&json, tam_json_path(&json, 0, "tags.1"), &sb));
+        assert(tam_sl_eqstr(tam_sb_view(&sb), "b\\"));
+        tam_sb_deallocate(&sb);
+
+        // scalars at the top level
+        assert(tam_json_parse(&json, tam_slice("  -0.5  "), &arena) && json.len == 1);
+        assert(tam_json_parse(&json, tam_slice("\"\\\\\""), &arena) && json.tokens[0].text.len == 2);
+
+        const char *invalid[] = {
+            "",          "  ",         "{",          "[1,]",        "[1 2]",     "{\"a\" 1}",  "{\"a\":}",
+            "{1: 2}",    "[01]",       "[1.]",       "[-]",         "[tru]",     "[nulll]",    "\"open",
+            "[\"a\\\"]", "{\"a\":1]",  "[1]]",       "1 2",         "[\"a\"b]",  "{\"a\":1,}", "[1e]",
+            "[\"a\nb\"]",
+        };
+        for (usize k = 0; k < sizeof(invalid) / sizeof(invalid[0]); k++)
+            assert(!tam_json_parse(&json, tam_slice(invalid[k]), &arena));
+        // a NUL byte is not part of any number or literal
+        assert(!tam_json_parse(&json, tam_slice_n("[true\0]", 7), &arena));
+        assert(!tam_json_parse(&json, tam_slice_n("[1\0, 2]", 8), &arena));
+
+        // nesting limit
+        char deep[2 * TAM_JSON_MAX_DEPTH + 2];
+        memset(deep, '[', TAM_JSON_MAX_DEPTH + 1);
+        memset(deep + TAM_JSON_MAX_DEPTH + 1, ']', TAM_JSON_MAX_DEPTH + 1);
+        assert(!tam_json_parse(&json, tam_slice_n(deep, 2 * TAM_JSON_MAX_DEPTH + 2), &arena));
+        assert(tam_json_parse(&json, tam_slice_n(deep + 1, 2 * TAM_JSON_MAX_DEPTH), &arena));
+        tam_arena_dealloc(&arena);
+    }
+    {
+        // the arena only needs room for the values, not for every bracket, comma and quote
+        tam_arena_t arena = tam_arena_new(10 * sizeof(tam_json_token_t));
+        tam_json_t json;
+        assert(tam_json_parse(&json, tam_slice("{\"a\":1,\"b\":2,\"c\":[1,2,3]}"), &arena) && json.len == 10);
+        assert(tam_json_count(&json, tam_json_path(&json, 0, "c")) == 3);
+        tam_arena_dealloc(&arena);
+    }
+    {
+        // a document long enough for strings and escapes to straddle the 64-byte blocks
+        tam_stringbuilder_t sb = tam_sb_new();
+        tam_sb_appendchar(&sb, '[');
+        for (int k = 0; k < 200; k++) {
+            tam_sb_appendf(&sb, "%s{\"k%d\": \"%.*s\\\\\\\"\", \"v\": [%d, %d.5]}", k ? "," : "", k, k % 70,
+                           "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", k, -k);
+        }
+        tam_sb_appendchar(&sb, ']');
+        tam_arena_t arena = tam_arena_new(1 << 18);
+        tam_json_t json;
+        assert(tam_json_parse(&json, tam_sb_view(&sb), &arena));
+        assert(tam_json_count(&json, 0) == 200);
+        tam_stringbuilder_t key = tam_sb_new();
+        for (int k = 0; k < 200; k++) {
+            tam_sb_clear(&key);
+            tam_sb_appendf(&key, "%d.k%d", k, k);
+            int tok = tam_json_path(&json, 0, key.buf);
+            assert(tok >= 0 && json.tokens[tok].text.len == k % 70 + 4);
+            i64 v;
+            f64 w;
+            tam_sb_clear(&key);
+            tam_sb_appendf(&key, "%d.v.0", k);
+            assert(tam_json_to_i64(&json, tam_json_path(&json, 0, key.buf), &v) && v == k);
+            tam_sb_clear(&key);
+            tam_sb_appendf(&key, "%d.v.1", k);
+            assert(tam_json_to_f64(&json, tam_json_path(&json, 0, key.buf), &w) && w == -k + (k ? -0.5 : 0.5));
+        }
+        tam_sb_deallocate(&key);
+        tam_sb_deallocate(&sb);
+        tam_arena_dealloc(&arena);
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end JSON tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_JSON_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_JSON_H
@@ -18,6 +18,34 @@ void TAM_deallocate(void *ptr);
 #define tam_reallocate_bytes(ptr, count) (TAM_reallocate((ptr), (count), sizeof(char)))
 #define tam_deallocate(ptr) (TAM_deallocate(ptr), (ptr) = NULL)
 
+// growable buffers
+// factor by which growable buffers (string builders, dynamic arrays) grow. 2 and 1.5 are common choices.
+#ifndef TAM_GROWTH_FACTOR
+#define TAM_GROWTH_FACTOR 2
+#endif
+
+// buffers of at least this many bytes are mapped directly from the OS with mmap, and grown with mremap
+// on linux, so that the kernel moves page table entries instead of us copying the contents.
+// MAP_ANONYMOUS is not declared in strict ISO modes (e.g. -std=c11) unless _DEFAULT_SOURCE is defined before any
+// system header is included, and without it all buffers come from malloc. Define TAM_NO_MMAP to always use malloc.
+#ifndef TAM_MMAP_THRESHOLD
+#define TAM_MMAP_THRESHOLD (64 << 20)
+#endif
+
+// capacity in bytes that a buffer from TAM_reallocate_sized of `cap` bytes should grow to in order to hold
+// at least `needed` bytes. grows by TAM_GROWTH_FACTOR, rounded up to the malloc granularity or, for buffers
+// that will be mapped (at least TAM_MMAP_THRESHOLD bytes), the page size.
+usize tam_grow_capacity(usize cap, usize needed);
+// reallocate a buffer whose size is tracked by the caller. buffers at or above TAM_MMAP_THRESHOLD are mmap'd,
+// so memory obtained this way must be freed with TAM_deallocate_sized and the same size.
+// shrinking a mapped buffer that stays above the threshold unmaps its tail pages and never moves it.
+void *TAM_reallocate_sized(void *ptr, usize old_bytes, usize new_bytes);
+void TAM_deallocate_sized(void *ptr, usize bytes);
+
+#define tam_reallocate_sized(ptr, type, old_count, new_count)                                                          \
+  (TAM_reallocate_sized((ptr), (old_count) * sizeof(type), (new_count) * sizeof(type)))
+#define tam_deallocate_sized(ptr, type, count) (TAM_deallocate_sized((ptr), (count) * sizeof(type)), (ptr) = NULL)
+
 // arena
 typedef struct tam_arena_t {
   char *beg;
@@ -34,6 +62,8 @@ void *TAM_arena_allocate(tam_arena_t *a, isize size, isize align, isize count);
 void *TAM_arena_reallocate(tam_arena_t *a, void *ptr, isize size, isize align, isize count, isize new_count);
 void *TAM_arena_grow_arr(tam_arena_t *a, void *arr, isize size, isize align, isize count, isize *new_count);
 void tam_arena_dealloc(tam_arena_t *arena);
+// give back the memory of the arena's most recent allocation. does nothing if `ptr` + `bytes` is not the end of it.
+void tam_arena_release(tam_arena_t *a, void *ptr, isize bytes);
 
 #if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_MEMORY) ///{{{
 #define allocate tam_allocate
@@ -41,12 +71,16 @@ void tam_arena_dealloc(tam_arena_t *arena);
 #define reallocate tam_reallocate
 #define reallocate_bytes tam_reallocate_bytes
 #define deallocate tam_deallocate
+#define grow_capacity tam_grow_capacity
+#define reallocate_sized tam_reallocate_sized
+#define deallocate_sized tam_deallocate_sized
 typedef tam_arena_t arena_t;
 #define arena_new tam_arena_new
 #define arena_alloc tam_arena_alloc
 #define arena_realloc tam_arena_realloc
 #define arena_dealloc tam_arena_dealloc
 #define arena_grow_arr tam_arena_grow_arr
+#define arena_release tam_arena_release
 #endif // namespace }}}
 
 #if defined(TAM_IMPLEMENTATION) || defined(TAM_MEMORY_IMPLEMENTATION) ///{{{
@@ -66,7 +100,7 @@ void *TAM_allocate(usize num_elements, usize elem_size) {
 void *TAM_reallocate(void *ptr, usize num_elements, usize elem_size) {
   ptr = realloc(ptr, num_elements * elem_size);
   if (ptr == NULL)
-    tam_errorf(stderr, "reallocation of %zu elements of size size %zu failed.", num_elements, elem_size);
+    tam_errorf("reallocation of %zu elements of size size %zu failed.", num_elements, elem_size);
   return ptr;
 }
 
@@ -76,6 +110,106 @@ void TAM_deallocate(void *ptr) {
   free(ptr);
 }
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(TAM_NO_MMAP)
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifdef MAP_ANONYMOUS
+#define TAM_HAVE_MMAP
+#else
+#define TAM_NO_MMAP
+#endif
+#endif
+
+#if defined(TAM_HAVE_MMAP) && defined(__linux__) && !defined(MREMAP_MAYMOVE)
+// mremap is only declared when _GNU_SOURCE is defined before the first system header, which we can't rely on
+void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...);
+#define MREMAP_MAYMOVE 1
+#endif
+
+static usize tam_page_size(void) {
+#ifdef TAM_HAVE_MMAP
+  static usize page_size = 0;
+  if (page_size == 0)
+    page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+#else
+  return 4096;
+#endif
+}
+
+usize tam_grow_capacity(usize cap, usize needed) {
+  usize newcap = (usize)(cap * TAM_GROWTH_FACTOR);
+  if (newcap < needed)
+    newcap = needed;
+  usize granularity = newcap >= TAM_MMAP_THRESHOLD ? tam_page_size() : 16;
+  return (newcap + granularity - 1) & ~(granularity - 1);
+}
+
+void *TAM_reallocate_sized(void *ptr, usize old_bytes, usize new_bytes) {
+#ifdef TAM_HAVE_MMAP
+  bool old_mapped = ptr != NULL && old_bytes >= TAM_MMAP_THRESHOLD;
+  bool new_mapped = new_bytes >= TAM_MMAP_THRESHOLD;
+  if (old_mapped && new_mapped && new_bytes <= old_bytes) {
+    // munmap works on whole pages, so keep the page holding the last byte
+    usize page_size = tam_page_size();
+    usize keep = (new_bytes + page_size - 1) & ~(page_size - 1);
+    usize mapped = (old_bytes + page_size - 1) & ~(page_size - 1);
+    if (mapped > keep)
+      munmap((char *)ptr + keep, mapped - keep);
+    return ptr;
+  }
+  if (old_mapped && new_mapped) {
+#ifdef __linux__
+    void *new_ptr = mremap(ptr, old_bytes, new_bytes, MREMAP_MAYMOVE);
+#else
+    void *new_ptr = mmap(NULL, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new_ptr != MAP_FAILED) {
+      memcpy(new_ptr, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+      munmap(ptr, old_bytes);
+    }
+#endif
+    if (new_ptr == MAP_FAILED)
+      tam_errorf("remapping of %zu bytes to %zu bytes failed.", old_bytes, new_bytes);
+    return new_ptr;
+  }
+  if (new_mapped) {
+    void *new_ptr = mmap(NULL, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new_ptr == MAP_FAILED)
+      tam_errorf("mapping of %zu bytes failed.", new_bytes);
+    if (ptr != NULL) {
+      memcpy(new_ptr, ptr, old_bytes);
+      free(ptr);
+    }
+    return new_ptr;
+  }
+  if (old_mapped) {
+    // shrinking below the threshold moves the buffer back to the heap
+    void *new_ptr = TAM_reallocate(NULL, new_bytes, 1);
+    memcpy(new_ptr, ptr, new_bytes);
+    munmap(ptr, old_bytes);
+    return new_ptr;
+  }
+#endif
+  (void)old_bytes;
+  return TAM_reallocate(ptr, new_bytes, 1);
+}
+
+void TAM_deallocate_sized(void *ptr, usize bytes) {
+  if (ptr == NULL)
+    return;
+#ifdef TAM_HAVE_MMAP
+  if (bytes >= TAM_MMAP_THRESHOLD) {
+    munmap(ptr, bytes);
+    return;
+  }
+#endif
+  (void)bytes;
+  free(ptr);
+}
+
 tam_arena_t tam_arena_new(isize cap) {
   tam_arena_t arena = {.beg = NULL, .cap = cap, .ptr = NULL};
   return arena;
@@ -103,8 +237,15 @@ void *TAM_arena_reallocate(tam_arena_t *a, void *ptr, isize size, isize align, i
   if (new_count <= count) {
     return ptr;
   }
+  // if this is the most recent allocation and there is room, extend it in place
+  if (ptr != NULL && (char *)ptr + count * size == a->ptr &&
+      new_count - count <= (a->beg + a->cap - a->ptr) / size) {
+    a->ptr += (new_count - count) * size;
+    return ptr;
+  }
   void *new_ptr = TAM_arena_allocate(a, size, align, new_count);
-  memcpy(new_ptr, ptr, count * size);
+  if (ptr != NULL)
+    memcpy(new_ptr, ptr, count * size);
   return new_ptr;
 }
 
@@ -123,6 +264,12 @@ void *TAM_arena_grow_arr(tam_arena_t *a, void *arr, isize size, isize align, isi
   return new_ptr;
 }
 
+void tam_arena_release(tam_arena_t *a, void *ptr, isize bytes) {
+  if (ptr != NULL && (char *)ptr + bytes == a->ptr) {
+    a->ptr = ptr;
+  }
+}
+
 void tam_arena_dealloc(tam_arena_t *a) {
   tam_deallocate(a->beg);
   a->beg = NULL;
@@ -0,0 +1,1295 @@
+#ifndef TAM_REGEX_H
+#define TAM_REGEX_H
+
+// TAM regular expressions
+//
+// Compiled regular expressions over slices, matched in linear time by a lazy DFA and a Pike VM.
+
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Regex declarations *** {{{
+/*
+ * Patterns are compiled into a program for a Thompson NFA, which is then simulated without backtracking, so
+ * matching takes time linear in the length of the input for every pattern.
+ *
+ * - When the pattern starts with a literal string, candidate match positions are found with `sl_find`,
+ *   which compares 16 or 32 positions at a time.
+ * - A lazy DFA decides whether there is a match. Its states are built on demand and cached in the regex, so
+ *   scanning input that does not match costs one table lookup per byte once the cache is warm.
+ *   If the cache fills up (more than TAM_REGEX_DFA_STATES states), it is flushed and rebuilt. Only when it fills
+ *   up again within the same search, without having scanned much input, does matching fall back to the Pike VM.
+ * - When there is a match, a Pike VM finds its exact position and the submatches, with leftmost-first
+ *   (Perl-like) semantics. As in RE2, a repetition never takes an empty iteration, so when the body of a loop
+ *   can match the empty string, the submatches may differ from those of a backtracking engine.
+ *
+ * The memory used by both engines is allocated when the pattern is compiled, so matching does not allocate,
+ * apart from growing the DFA cache. Because of that cache, a regex may only be used by one thread at a time.
+ *
+ * Supported syntax, which works on bytes:
+ *   literals, `.` (any byte but `\n`), `[abc]`, `[^a-z]`, `\d \w \s \D \W \S`,
+ *   `\n \t \r \f \v \xHH` and escaped punctuation, `^` and `$` (start and end of input),
+ *   `(...)` capturing groups, `(?:...)` non-capturing groups, `|`,
+ *   and the quantifiers `* + ? {n} {n,} {n,m}`, which can be made lazy by appending `?`.
+ */
+
+// maximum number of instructions in a compiled program. counted repetition makes copies of its operand.
+#ifndef TAM_REGEX_MAX_INSTS
+#define TAM_REGEX_MAX_INSTS 65536
+#endif
+
+// maximum number of states in the DFA cache of a regex
+#ifndef TAM_REGEX_DFA_STATES
+#define TAM_REGEX_DFA_STATES 4096
+#endif
+
+typedef enum tam_regex_op_t {
+    // consume byte `c`
+    TAM_RE_CHAR,
+    // consume a byte in class `x`
+    TAM_RE_CLASS,
+    // continue at `x`, then at `y` with lower priority
+    TAM_RE_SPLIT,
+    TAM_RE_JMP,
+    // record the current position in capture slot `x`
+    TAM_RE_SAVE,
+    TAM_RE_BOL,
+    TAM_RE_EOL,
+    TAM_RE_MATCH,
+} tam_regex_op_t;
+
+typedef struct tam_regex_inst_t {
+    u8 op;
+    u8 c;
+    int x;
+    int y;
+} tam_regex_inst_t;
+
+// a thread list of the Pike VM
+typedef struct tam_regex_threads_t {
+    int *pcs;
+    // capture slots of each thread
+    int *caps;
+    int len;
+    // pcs visited in the current step are marked with the current generation
+    u32 *mark;
+    u32 gen;
+} tam_regex_threads_t;
+
+typedef struct tam_regex_dfa_t {
+    int num_states;
+    int state_cap;
+    // next state for each state and byte class. -1 if not computed yet.
+    int *trans;
+    // the NFA states of state i are sets[set_start[i]] up to sets[set_start[i + 1]]
+    int *set_start;
+    int *sets;
+    int sets_len;
+    int sets_cap;
+    // TAM_RE_DFA_* flags of each state
+    u8 *flags;
+    // open-addressed hash table of states
+    int *table;
+    // start states at the beginning of the input and elsewhere, -1 until built
+    int start_bol;
+    int start;
+    // scratch for building states
+    int *stack;
+    int *out;
+    u32 *mark;
+    u32 gen;
+} tam_regex_dfa_t;
+
+typedef struct tam_regex_t {
+    // NULL if the pattern compiled, otherwise a description of the problem at offset `error_pos` of the pattern
+    const char *error;
+    int error_pos;
+
+    tam_regex_inst_t *prog;
+    int len;
+    // 256-bit sets of bytes used by TAM_RE_CLASS
+    u64 (*classes)[4];
+    int num_classes;
+    // number of capturing groups, including group 0, the whole match
+    int num_groups;
+
+    // a literal that every match starts with, and whether matches can only start at the beginning of the input
+    char *prefix;
+    int prefix_len;
+    bool anchored;
+
+    // bytes that no instruction tells apart share a class, which keeps the DFA tables small
+    u8 byte_class[256];
+    u8 class_rep[256];
+    int num_byte_classes;
+
+    // Pike VM thread lists, the capture slots being built and the best match so far
+    tam_regex_threads_t threads[2];
+    int *stack;
+    int *cur;
+    int *best;
+    tam_regex_dfa_t dfa;
+} tam_regex_t;
+
+/*
+ * Compile a regular expression.
+ * If the pattern is invalid, `error` is set on the result, which must still be freed with `regex_deallocate`.
+ */
+tam_regex_t tam_regex_compile(const char *pattern);
+
+/*
+ * Free a compiled regular expression
+ */
+void tam_regex_deallocate(tam_regex_t *re);
+
+/*
+ * Return true if the regex matches anywhere in `s`.
+ * This only runs the DFA (unless its cache is full), so it is cheaper than `regex_match`.
+ */
+bool tam_regex_is_match(tam_regex_t *re, tam_slice_t s);
+
+/*
+ * Find the leftmost match of the regex in `s`. Returns false if there is none.
+ * On a match, the first `ncaps` groups are written to `caps`: caps[0] is the whole match, and caps[i] is the
+ * text matched by the i'th capturing group. Groups that did not take part in the match have a NULL `buf`.
+ * The slices point into `s`. To find all matches, search again in the rest of `s` after caps[0].
+ */
+bool tam_regex_match(tam_regex_t *re, tam_slice_t s, tam_slice_t *caps, int ncaps);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_REGEX) ///{{{
+typedef tam_regex_t regex_t;
+#define regex_compile tam_regex_compile
+#define regex_deallocate tam_regex_deallocate
+#define regex_is_match tam_regex_is_match
+#define regex_match tam_regex_match
+#endif // end regex namespace }}}
+
+// end regex declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_REGEX_IMPLEMENTATION)
+
+#include <assert.h>
+#include <string.h>
+
+// ### Regex parser {{{
+
+typedef enum tam_re_node_type_t {
+    TAM_RE_NODE_EMPTY,
+    TAM_RE_NODE_CHAR,
+    TAM_RE_NODE_CLASS,
+    TAM_RE_NODE_BOL,
+    TAM_RE_NODE_EOL,
+    // children are `child`, then their `next` siblings
+    TAM_RE_NODE_CAT,
+    TAM_RE_NODE_ALT,
+    TAM_RE_NODE_REPEAT,
+    TAM_RE_NODE_GROUP,
+} tam_re_node_type_t;
+
+typedef struct tam_re_node_t {
+    u8 type;
+    u8 c;
+    bool greedy;
+    int child;
+    int next;
+    // repetition bounds, with max -1 for unbounded
+    int min;
+    int max;
+    // class index for CLASS, group index for GROUP (-1 if not capturing)
+    int index;
+} tam_re_node_t;
+
+typedef struct tam_re_parser_t {
+    const char *start;
+    const char *p;
+    const char *end;
+    tam_re_node_t *nodes;
+    int num_nodes;
+    int cap;
+    int depth;
+    tam_regex_t *re;
+} tam_re_parser_t;
+
+// limits that keep the recursive parser and code generator within a reasonable stack depth and size
+#define TAM_RE_MAX_DEPTH 256
+#define TAM_RE_MAX_REPEAT 1000
+
+static int tam_re_error(tam_re_parser_t *ps, const char *msg) {
+    if (ps->re->error == NULL) {
+        ps->re->error = msg;
+        ps->re->error_pos = ps->p - ps->start;
+    }
+    return -1;
+}
+
+static int tam_re_node(tam_re_parser_t *ps, tam_re_node_type_t type) {
+    if (ps->num_nodes == ps->cap) {
+        int newcap = ps->cap ? 2 * ps->cap : 64;
+        ps->nodes = tam_reallocate(ps->nodes, tam_re_node_t, newcap);
+        ps->cap = newcap;
+    }
+    tam_re_node_t *n = &ps->nodes[ps->num_nodes];
+    memset(n, 0, sizeof(*n));
+    n->type = type;
+    n->child = -1;
+    n->next = -1;
+    n->index = -1;
+    return ps->num_nodes++;
+}
+
+static int tam_re_add_class(tam_regex_t *re, const u64 bits[4]) {
+    re->classes = (u64(*)[4])tam_reallocate(re->classes, u64[4], re->num_classes + 1);
+    memcpy(re->classes[re->num_classes], bits, sizeof(u64[4]));
+    return re->num_classes++;
+}
+
+static inline void tam_re_set_range(u64 bits[4], int lo, int hi) {
+    for (int c = lo; c <= hi; c++)
+        bits[c >> 6] |= 1ull << (c & 63);
+}
+
+// Add the class of a `\d`, `\w` or `\s` style escape to `bits`. Returns false if `e` is not such an escape.
+static bool tam_re_perl_class(u64 bits[4], char e) {
+    u64 tmp[4] = {0};
+    switch (e | 0x20) {
+    case 'd': tam_re_set_range(tmp, '0', '9'); break;
+    case 'w':
+        tam_re_set_range(tmp, '0', '9');
+        tam_re_set_range(tmp, 'a', 'z');
+        tam_re_set_range(tmp, 'A', 'Z');
+        tam_re_set_range(tmp, '_', '_');
+        break;
+    case 's':
+        tam_re_set_range(tmp, '\t', '\r');
+        tam_re_set_range(tmp, ' ', ' ');
+        break;
+    default: return false;
+    }
+    // uppercase escapes are the complement
+    bool negate = e >= 'A' && e <= 'Z';
+    for (int i = 0; i < 4; i++)
+        bits[i] |= negate ? ~tmp[i] : tmp[i];
+    return true;
+}
+
+// Parse a single-byte escape after the backslash. Returns the byte, or -1.
+static int tam_re_escape(tam_re_parser_t *ps) {
+    if (ps->p >= ps->end)
+        return tam_re_error(ps, "trailing backslash");
+    char e = *ps->p++;
+    switch (e) {
+    case 'n': return '\n';
+    case 't': return '\t';
+    case 'r': return '\r';
+    case 'f': return '\f';
+    case 'v': return '\v';
+    case 'x': {
+        int v = 0;
+        for (int i = 0; i < 2; i++) {
+            char h = ps->p < ps->end ? *ps->p : 0;
+            int d = (h >= '0' && h <= '9') ? h - '0' : ((h | 0x20) >= 'a' && (h | 0x20) <= 'f') ? (h | 0x20) - 'a' + 10 : -1;
+            if (d < 0)
+                return tam_re_error(ps, "expected two hex digits after \\x");
+            v = v * 16 + d;
+            ps->p++;
+        }
+        return v;
+    }
+    default:
+        // any other escaped punctuation stands for itself. letters and digits are reserved.
+        if ((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') || (e >= '0' && e <= '9')) {
+            ps->p--;
+            return tam_re_error(ps, "unsupported escape sequence");
+        }
+        return (u8)e;
+    }
+}
+
+// Parse a bracket expression, after the `[`
+static int tam_re_parse_class(tam_re_parser_t *ps) {
+    u64 bits[4] = {0};
+    bool negate = ps->p < ps->end && *ps->p == '^';
+    ps->p += negate;
+    bool first = true;
+    while (ps->p < ps->end && (*ps->p != ']' || first)) {
+        first = false;
+        int lo = (u8)*ps->p++;
+        if (lo == '\\') {
+            if (ps->p < ps->end && tam_re_perl_class(bits, *ps->p)) {
+                ps->p++;
+                continue;
+            }
+            if ((lo = tam_re_escape(ps)) < 0)
+                return -1;
+        }
+        int hi = lo;
+        if (ps->p + 1 < ps->end && ps->p[0] == '-' && ps->p[1] != ']') {
+            ps->p++;
+            hi = (u8)*ps->p++;
+            if (hi == '\\' && (hi = tam_re_escape(ps)) < 0)
+                return -1;
+            if (hi < lo)
+                return tam_re_error(ps, "invalid range in character class");
+        }
+        tam_re_set_range(bits, lo, hi);
+    }
+    if (ps->p >= ps->end)
+        return tam_re_error(ps, "missing ]");
+    ps->p++;
+    if (negate) {
+        for (int i = 0; i < 4; i++)
+            bits[i] = ~bits[i];
+    }
+    int n = tam_re_node(ps, TAM_RE_NODE_CLASS);
+    ps->nodes[n].index = tam_re_add_class(ps->re, bits);
+    return n;
+}
+
+static int tam_re_parse_alt(tam_re_parser_t *ps);
+
+static int tam_re_parse_atom(tam_re_parser_t *ps) {
+    char c = *ps->p++;
+    switch (c) {
+    case '(': {
+        int index = -1;
+        if (ps->p + 1 < ps->end && ps->p[0] == '?' && ps->p[1] == ':') {
+            ps->p += 2;
+        } else if (ps->p < ps->end && ps->p[0] == '?') {
+            return tam_re_error(ps, "unsupported group flag");
+        } else {
+            index = ps->re->num_groups++;
+        }
+        if (++ps->depth > TAM_RE_MAX_DEPTH)
+            return tam_re_error(ps, "groups nested too deeply");
+        int child = tam_re_parse_alt(ps);
+        ps->depth--;
+        if (child < 0)
+            return -1;
+        if (ps->p >= ps->end || *ps->p != ')')
+            return tam_re_error(ps, "missing )");
+        ps->p++;
+        int n = tam_re_node(ps, TAM_RE_NODE_GROUP);
+        ps->nodes[n].child = child;
+        ps->nodes[n].index = index;
+        return n;
+    }
+    case '[': return tam_re_parse_class(ps);
+    case '.': {
+        u64 bits[4] = {~0ull, ~0ull, ~0ull, ~0ull};
+        bits['\n' >> 6] &= ~(1ull << ('\n' & 63));
+        int n = tam_re_node(ps, TAM_RE_NODE_CLASS);
+        ps->nodes[n].index = tam_re_add_class(ps->re, bits);
+        return n;
+    }
+    case '^': return tam_re_node(ps, TAM_RE_NODE_BOL);
+    case '$': return tam_re_node(ps, TAM_RE_NODE_EOL);
+    case '*':
+    case '+':
+    case '?': ps->p--; return tam_re_error(ps, "nothing to repeat");
+    case '\\': {
+        u64 bits[4] = {0};
+        if (ps->p < ps->end && tam_re_perl_class(bits, *ps->p)) {
+            ps->p++;
+            int n = tam_re_node(ps, TAM_RE_NODE_CLASS);
+            ps->nodes[n].index = tam_re_add_class(ps->re, bits);
+            return n;
+        }
+        int e = tam_re_escape(ps);
+        if (e < 0)
+            return -1;
+        c = e;
+    }
+    // fallthrough
+    default: {
+        int n = tam_re_node(ps, TAM_RE_NODE_CHAR);
+        ps->nodes[n].c = c;
+        return n;
+    }
+    }
+}
+
+// Parse a decimal repetition count, or return -1
+static int tam_re_count(tam_re_parser_t *ps) {
+    int v = -1;
+    while (ps->p < ps->end && *ps->p >= '0' && *ps->p <= '9') {
+        v = (v < 0 ? 0 : v) * 10 + (*ps->p++ - '0');
+        if (v > TAM_RE_MAX_REPEAT)
+            v = TAM_RE_MAX_REPEAT + 1;
+    }
+    return v;
+}
+
+static int tam_re_parse_repeat(tam_re_parser_t *ps) {
+    int n = tam_re_parse_atom(ps);
+    while (n >= 0 && ps->p < ps->end) {
+        int min, max;
+        const char *q = ps->p;
+        char c = *ps->p++;
+        if (c == '*') {
+            min = 0, max = -1;
+        } else if (c == '+') {
+            min = 1, max = -1;
+        } else if (c == '?') {
+            min = 0, max = 1;
+        } else if (c == '{') {
+            min = tam_re_count(ps);
+            max = min;
+            if (min >= 0 && ps->p < ps->end && *ps->p == ',') {
+                ps->p++;
+                max = tam_re_count(ps);
+            }
+            if (min < 0 || ps->p >= ps->end || *ps->p != '}') {
+                // not a repetition, so the brace is a literal
+                ps->p = q;
+                break;
+            }
+            ps->p++;
+            if (min > TAM_RE_MAX_REPEAT || max > TAM_RE_MAX_REPEAT)
+                return tam_re_error(ps, "repetition count too large");
+            if (max >= 0 && max < min)
+                return tam_re_error(ps, "invalid repetition count");
+        } else {
+            ps->p--;
+            break;
+        }
+        if (ps->nodes[n].type == TAM_RE_NODE_REPEAT) {
+            ps->p = q;
+            return tam_re_error(ps, "multiple repetition");
+        }
+        int r = tam_re_node(ps, TAM_RE_NODE_REPEAT);
+        ps->nodes[r].child = n;
+        ps->nodes[r].min = min;
+        ps->nodes[r].max = max;
+        ps->nodes[r].greedy = !(ps->p < ps->end && *ps->p == '?');
+        ps->p += !ps->nodes[r].greedy;
+        n = r;
+    }
+    return n;
+}
+
+static int tam_re_parse_cat(tam_re_parser_t *ps) {
+    int cat = tam_re_node(ps, TAM_RE_NODE_CAT);
+    int last = -1;
+    while (ps->p < ps->end && *ps->p != '|' && *ps->p != ')') {
+        int n = tam_re_parse_repeat(ps);
+        if (n < 0)
+            return -1;
+        if (last < 0)
+            ps->nodes[cat].child = n;
+        else
+            ps->nodes[last].next = n;
+        last = n;
+    }
+    return cat;
+}
+
+static int tam_re_parse_alt(tam_re_parser_t *ps) {
+    int alt = tam_re_node(ps, TAM_RE_NODE_ALT);
+    int last = tam_re_parse_cat(ps);
+    if (last < 0)
+        return -1;
+    ps->nodes[alt].child = last;
+    while (ps->p < ps->end && *ps->p == '|') {
+        ps->p++;
+        int n = tam_re_parse_cat(ps);
+        if (n < 0)
+            return -1;
+        ps->nodes[last].next = n;
+        last = n;
+    }
+    return alt;
+}
+
+// end regex parser }}}
+
+// ### Regex compiler {{{
+
+static int tam_re_emit(tam_regex_t *re, int *cap, tam_regex_op_t op, int c, int x, int y) {
+    if (re->len == TAM_REGEX_MAX_INSTS) {
+        re->error = "pattern too large";
+        return -1;
+    }
+    if (re->len == *cap) {
+        *cap = *cap ? 2 * *cap : 64;
+        re->prog = tam_reallocate(re->prog, tam_regex_inst_t, *cap);
+    }
+    re->prog[re->len] = (tam_regex_inst_t){(u8)op, (u8)c, x, y};
+    return re->len++;
+}
+
+// Emit the program for a node. Returns false if the program gets too large.
+static bool tam_re_compile_node(tam_regex_t *re, int *cap, const tam_re_node_t *nodes, int n) {
+    const tam_re_node_t *node = &nodes[n];
+    switch (node->type) {
+    case TAM_RE_NODE_EMPTY: return true;
+    case TAM_RE_NODE_CHAR: return tam_re_emit(re, cap, TAM_RE_CHAR, node->c, 0, 0) >= 0;
+    case TAM_RE_NODE_CLASS: return tam_re_emit(re, cap, TAM_RE_CLASS, 0, node->index, 0) >= 0;
+    case TAM_RE_NODE_BOL: return tam_re_emit(re, cap, TAM_RE_BOL, 0, 0, 0) >= 0;
+    case TAM_RE_NODE_EOL: return tam_re_emit(re, cap, TAM_RE_EOL, 0, 0, 0) >= 0;
+    case TAM_RE_NODE_CAT:
+        for (int c = node->child; c >= 0; c = nodes[c].next) {
+            if (!tam_re_compile_node(re, cap, nodes, c))
+                return false;
+        }
+        return true;
+    case TAM_RE_NODE_ALT: {
+        if (nodes[node->child].next < 0)
+            return tam_re_compile_node(re, cap, nodes, node->child);
+        // split to each alternative in turn, and have every alternative jump to the end.
+        // the jumps are chained through their targets until the end is known.
+        int jumps = -1;
+        for (int c = node->child; c >= 0; c = nodes[c].next) {
+            int split = -1;
+            if (nodes[c].next >= 0 && (split = tam_re_emit(re, cap, TAM_RE_SPLIT, 0, 0, 0)) < 0)
+                return false;
+            if (split >= 0)
+                re->prog[split].x = re->len;
+            if (!tam_re_compile_node(re, cap, nodes, c))
+                return false;
+            if (nodes[c].next >= 0) {
+                int jmp = tam_re_emit(re, cap, TAM_RE_JMP, 0, jumps, 0);
+                if (jmp < 0)
+                    return false;
+                jumps = jmp;
+                re->prog[split].y = re->len;
+            }
+        }
+        while (jumps >= 0) {
+            int prev = re->prog[jumps].x;
+            re->prog[jumps].x = re->len;
+            jumps = prev;
+        }
+        return true;
+    }
+    case TAM_RE_NODE_GROUP:
+        if (node->index >= 0 && tam_re_emit(re, cap, TAM_RE_SAVE, 0, 2 * node->index, 0) < 0)
+            return false;
+        if (!tam_re_compile_node(re, cap, nodes, node->child))
+            return false;
+        return node->index < 0 || tam_re_emit(re, cap, TAM_RE_SAVE, 0, 2 * node->index + 1, 0) >= 0;
+    case TAM_RE_NODE_REPEAT: {
+        int min = node->min, max = node->max;
+        // the mandatory copies. x{n,} ends in a copy of x+.
+        int mandatory = max < 0 && min > 0 ? min - 1 : min;
+        for (int i = 0; i < mandatory; i++) {
+            if (!tam_re_compile_node(re, cap, nodes, node->child))
+                return false;
+        }
+        if (max < 0) {
+            if (min > 0) {
+                // L: x; split L, next
+                int loop = re->len;
+                if (!tam_re_compile_node(re, cap, nodes, node->child))
+                    return false;
+                int split = tam_re_emit(re, cap, TAM_RE_SPLIT, 0, 0, 0);
+                if (split < 0)
+                    return false;
+                re->prog[split].x = node->greedy ? loop : re->len;
+                re->prog[split].y = node->greedy ? re->len : loop;
+            } else {
+                // L: split body, next; body: x; jmp L
+                int split = tam_re_emit(re, cap, TAM_RE_SPLIT, 0, 0, 0);
+                if (split < 0 || !tam_re_compile_node(re, cap, nodes, node->child) ||
+                    tam_re_emit(re, cap, TAM_RE_JMP, 0, split, 0) < 0)
+                    return false;
+                re->prog[split].x = node->greedy ? split + 1 : re->len;
+                re->prog[split].y = node->greedy ? re->len : split + 1;
+            }
+            return true;
+        }
+        // the optional copies: split body, end; body: x; split body, end; ...
+        // the splits are chained through their end targets until the end is known
+        int splits = -1;
+        for (int i = min; i < max; i++) {
+            int split = tam_re_emit(re, cap, TAM_RE_SPLIT, 0, splits, 0);
+            if (split < 0 || !tam_re_compile_node(re, cap, nodes, node->child))
+                return false;
+            splits = split;
+        }
+        while (splits >= 0) {
+            int prev = re->prog[splits].x;
+            re->prog[splits].x = node->greedy ? splits + 1 : re->len;
+            re->prog[splits].y = node->greedy ? re->len : splits + 1;
+            splits = prev;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+// The literal that every match starts with: the leading characters of the top-level concatenation
+static void tam_re_find_prefix(tam_regex_t *re, const tam_re_node_t *nodes, int root) {
+    if (nodes[nodes[root].child].next >= 0)
+        return;
+    int cat = nodes[root].child;
+    int c = nodes[cat].child;
+    if (c >= 0 && nodes[c].type == TAM_RE_NODE_BOL) {
+        re->anchored = true;
+        return;
+    }
+    int len = 0;
+    for (int i = c; i >= 0 && nodes[i].type == TAM_RE_NODE_CHAR; i = nodes[i].next)
+        len++;
+    if (len == 0)
+        return;
+    re->prefix = tam_allocate(char, len);
+    for (int i = c; re->prefix_len < len; i = nodes[i].next)
+        re->prefix[re->prefix_len++] = nodes[i].c;
+}
+
+// Split the bytes into classes that no instruction tells apart
+static void tam_re_byte_classes(tam_regex_t *re) {
+    bool boundary[257] = {false};
+    for (int pc = 0; pc < re->len; pc++) {
+        const tam_regex_inst_t *inst = &re->prog[pc];
+        if (inst->op == TAM_RE_CHAR) {
+            boundary[inst->c] = true;
+            boundary[inst->c + 1] = true;
+        } else if (inst->op == TAM_RE_CLASS) {
+            const u64 *bits = re->classes[inst->x];
+            for (int c = 1; c < 256; c++) {
+                if (((bits[c >> 6] >> (c & 63)) & 1) != ((bits[(c - 1) >> 6] >> ((c - 1) & 63)) & 1))
+                    boundary[c] = true;
+            }
+        }
+    }
+    int k = 0;
+    re->class_rep[0] = 0;
+    for (int c = 0; c < 256; c++) {
+        if (c > 0 && boundary[c])
+            re->class_rep[++k] = c;
+        re->byte_class[c] = k;
+    }
+    re->num_byte_classes = k + 1;
+}
+
+tam_regex_t tam_regex_compile(const char *pattern) {
+    tam_regex_t re;
+    memset(&re, 0, sizeof(re));
+    re.num_groups = 1;
+    re.dfa.start = -1;
+    re.dfa.start_bol = -1;
+
+    tam_re_parser_t ps = {pattern, pattern, pattern + strlen(pattern), NULL, 0, 0, 0, &re};
+    int root = tam_re_parse_alt(&ps);
+    if (root >= 0 && ps.p < ps.end)
+        tam_re_error(&ps, "unmatched )");
+    if (re.error != NULL) {
+        tam_deallocate(ps.nodes);
+        return re;
+    }
+
+    // save 0; <pattern>; save 1; match
+    int cap = 0;
+    tam_re_emit(&re, &cap, TAM_RE_SAVE, 0, 0, 0);
+    if (!tam_re_compile_node(&re, &cap, ps.nodes, root)) {
+        re.error_pos = 0;
+        tam_deallocate(ps.nodes);
+        return re;
+    }
+    tam_re_emit(&re, &cap, TAM_RE_SAVE, 0, 1, 0);
+    if (tam_re_emit(&re, &cap, TAM_RE_MATCH, 0, 0, 0) < 0) {
+        tam_deallocate(ps.nodes);
+        return re;
+    }
+    tam_re_find_prefix(&re, ps.nodes, root);
+    tam_deallocate(ps.nodes);
+    tam_re_byte_classes(&re);
+
+    // everything the matchers need, so that matching does not allocate
+    int nslots = 2 * re.num_groups;
+    for (int i = 0; i < 2; i++) {
+        re.threads[i].pcs = tam_allocate(int, re.len);
+        re.threads[i].caps = tam_allocate(int, re.len * nslots);
+        re.threads[i].mark = tam_allocate(u32, re.len);
+        memset(re.threads[i].mark, 0, re.len * sizeof(u32));
+    }
+    re.stack = tam_allocate(int, 3 * (re.len + 1));
+    re.cur = tam_allocate(int, nslots);
+    re.best = tam_allocate(int, nslots);
+    re.dfa.stack = tam_allocate(int, re.len + 1);
+    re.dfa.out = tam_allocate(int, re.len);
+    re.dfa.mark = tam_allocate(u32, re.len);
+    memset(re.dfa.mark, 0, re.len * sizeof(u32));
+    return re;
+}
+
+void tam_regex_deallocate(tam_regex_t *re) {
+    tam_deallocate(re->prog);
+    tam_deallocate(re->classes);
+    tam_deallocate(re->prefix);
+    for (int i = 0; i < 2; i++) {
+        tam_deallocate(re->threads[i].pcs);
+        tam_deallocate(re->threads[i].caps);
+        tam_deallocate(re->threads[i].mark);
+    }
+    tam_deallocate(re->stack);
+    tam_deallocate(re->cur);
+    tam_deallocate(re->best);
+    tam_regex_dfa_t *d = &re->dfa;
+    tam_deallocate(d->trans);
+    tam_deallocate(d->set_start);
+    tam_deallocate(d->sets);
+    tam_deallocate(d->flags);
+    tam_deallocate(d->table);
+    tam_deallocate(d->stack);
+    tam_deallocate(d->out);
+    tam_deallocate(d->mark);
+    re->len = 0;
+}
+
+// end regex compiler }}}
+
+// ### Regex matching {{{
+
+static inline bool tam_re_consumes(const tam_regex_t *re, const tam_regex_inst_t *inst, u8 c) {
+    if (inst->op == TAM_RE_CHAR)
+        return inst->c == c;
+    if (inst->op == TAM_RE_CLASS)
+        return (re->classes[inst->x][c >> 6] >> (c & 63)) & 1;
+    return false;
+}
+
+// Position of the first possible match start at or after `pos`, or -1 if there is none
+static int tam_re_next_start(const tam_regex_t *re, tam_slice_t s, int pos) {
+    if (re->anchored)
+        return pos == 0 ? 0 : -1;
+    if (re->prefix_len == 0)
+        return pos <= s.len ? pos : -1;
+    if (pos > s.len)
+        return -1;
+    tam_slice_t rest = tam_slice_n(s.buf + pos, s.len - pos);
+    int i = tam_sl_find(rest, tam_slice_n(re->prefix, re->prefix_len));
+    return i == rest.len ? -1 : pos + i;
+}
+
+// Start a new generation of marks. Once the counter wraps around, a stale mark could equal the new generation
+// and hide a state, so the marks are cleared instead.
+static inline void tam_re_next_gen(u32 *mark, int len, u32 *gen) {
+    if (++*gen == 0) {
+        memset(mark, 0, len * sizeof(u32));
+        *gen = 1;
+    }
+}
+
+// Add a thread at `pc` to a list, following jumps, splits and assertions at position `pos` of `s`.
+// `cur` holds the capture slots of the thread.
+static void tam_re_add_thread(tam_regex_t *re, tam_regex_threads_t *list, int pc, int pos, tam_slice_t s) {
+    int nslots = 2 * re->num_groups;
+    // entries are (pc, -1, 0) for threads still to add, and (-1, slot, value) to restore a capture slot
+    int *stack = re->stack;
+    int sp = 0;
+    stack[sp++] = pc;
+    stack[sp++] = -1;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        sp -= 3;
+        pc = stack[sp];
+        if (pc < 0) {
+            re->cur[stack[sp + 1]] = stack[sp + 2];
+            continue;
+        }
+        while (list->mark[pc] != list->gen) {
+            list->mark[pc] = list->gen;
+            const tam_regex_inst_t *inst = &re->prog[pc];
+            switch (inst->op) {
+            case TAM_RE_JMP: pc = inst->x; continue;
+            case TAM_RE_SPLIT:
+                stack[sp++] = inst->y;
+                stack[sp++] = -1;
+                stack[sp++] = 0;
+                pc = inst->x;
+                continue;
+            case TAM_RE_SAVE:
+                stack[sp++] = -1;
+                stack[sp++] = inst->x;
+                stack[sp++] = re->cur[inst->x];
+                re->cur[inst->x] = pos;
+                pc++;
+                continue;
+            case TAM_RE_BOL:
+                if (pos == 0)
+                    pc++;
+                continue;
+            case TAM_RE_EOL:
+                if (pos == s.len)
+                    pc++;
+                continue;
+            default:
+                // a thread that consumes a byte or matches
+                list->pcs[list->len] = pc;
+                memcpy(list->caps + list->len * nslots, re->cur, nslots * sizeof(int));
+                list->len++;
+                break;
+            }
+            break;
+        }
+    }
+}
+
+// Find the leftmost-first match starting at or after `pos` with a Pike VM, leaving its captures in `re->best`
+static bool tam_re_pike(tam_regex_t *re, tam_slice_t s, int pos) {
+    int nslots = 2 * re->num_groups;
+    tam_regex_threads_t *clist = &re->threads[0];
+    tam_regex_threads_t *nlist = &re->threads[1];
+    clist->len = 0;
+    bool matched = false;
+    for (;; pos++) {
+        if (!matched) {
+            // nothing in progress, so skip ahead to the next place a match can start
+            if (clist->len == 0 && (pos = tam_re_next_start(re, s, pos)) < 0)
+                break;
+            // the marks of a list built by the previous step are valid at this position, so the start thread
+            // does not duplicate its threads. an empty list may have been skipped ahead, so it starts afresh.
+            if (clist->len == 0)
+                tam_re_next_gen(clist->mark, re->len, &clist->gen);
+            if (!re->anchored || pos == 0) {
+                for (int i = 0; i < nslots; i++)
+                    re->cur[i] = -1;
+                tam_re_add_thread(re, clist, 0, pos, s);
+            }
+        }
+        if (clist->len == 0 && matched)
+            break;
+
+        nlist->len = 0;
+        tam_re_next_gen(nlist->mark, re->len, &nlist->gen);
+        for (int i = 0; i < clist->len; i++) {
+            const tam_regex_inst_t *inst = &re->prog[clist->pcs[i]];
+            int *caps = clist->caps + i * nslots;
+            if (inst->op == TAM_RE_MATCH) {
+                // lower-priority threads can only produce worse matches
+                memcpy(re->best, caps, nslots * sizeof(int));
+                matched = true;
+                break;
+            }
+            if (pos < s.len && tam_re_consumes(re, inst, s.buf[pos])) {
+                memcpy(re->cur, caps, nslots * sizeof(int));
+                tam_re_add_thread(re, nlist, clist->pcs[i] + 1, pos + 1, s);
+            }
+        }
+        tam_regex_threads_t *tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+        if (pos >= s.len)
+            break;
+    }
+    return matched;
+}
+
+// flags of DFA states
+#define TAM_RE_DFA_MATCH 1
+#define TAM_RE_DFA_MATCH_AT_END 2
+// no NFA states are left, so nothing can match
+#define TAM_RE_DFA_DEAD 4
+// the unanchored start state, at which the prefilter can skip ahead
+#define TAM_RE_DFA_START 8
+
+// Add the NFA states reachable from `pc` without consuming input to `d->out`. Only states that consume a byte,
+// match, or assert the end of the input (which is not known while building the DFA) are kept.
+static void tam_re_dfa_closure(const tam_regex_t *re, tam_regex_dfa_t *d, int pc, bool bol, bool eol, int *n) {
+    int sp = 0;
+    d->stack[sp++] = pc;
+    while (sp > 0) {
+        pc = d->stack[--sp];
+        while (d->mark[pc] != d->gen) {
+            d->mark[pc] = d->gen;
+            const tam_regex_inst_t *inst = &re->prog[pc];
+            if (inst->op == TAM_RE_JMP) {
+                pc = inst->x;
+            } else if (inst->op == TAM_RE_SPLIT) {
+                d->stack[sp++] = inst->y;
+                pc = inst->x;
+            } else if (inst->op == TAM_RE_SAVE || (inst->op == TAM_RE_BOL && bol) || (inst->op == TAM_RE_EOL && eol)) {
+                pc++;
+            } else {
+                if (inst->op != TAM_RE_BOL)
+                    d->out[(*n)++] = pc;
+                break;
+            }
+        }
+    }
+}
+
+static u64 tam_re_hash_set(const int *set, int n) {
+    u64 h = 0x100;
+    for (int i = 0; i < n; i++) {
+        h ^= (u32)set[i];
+        h *= 1111111111111111111u;
+    }
+    return h ^ (h >> 29);
+}
+
+// Find or create the DFA state for the set of NFA states in `d->out`. Returns -1 if the cache is full.
+static int tam_re_dfa_state(tam_regex_t *re, int n) {
+    tam_regex_dfa_t *d = &re->dfa;
+    int *set = d->out;
+    // sort the set, so that equal sets look the same
+    for (int i = 1; i < n; i++) {
+        int v = set[i], j = i;
+        for (; j > 0 && set[j - 1] > v; j--)
+            set[j] = set[j - 1];
+        set[j] = v;
+    }
+    if (d->table == NULL) {
+        d->table = tam_allocate(int, 2 * TAM_REGEX_DFA_STATES);
+        for (int i = 0; i < 2 * TAM_REGEX_DFA_STATES; i++)
+            d->table[i] = -1;
+        d->set_start = tam_allocate(int, 1);
+    }
+    usize mask = 2 * TAM_REGEX_DFA_STATES - 1;
+    usize slot = tam_re_hash_set(set, n) & mask;
+    for (; d->table[slot] >= 0; slot = (slot + 1) & mask) {
+        int st = d->table[slot];
+        int len = d->set_start[st + 1] - d->set_start[st];
+        if (len == n && memcmp(d->sets + d->set_start[st], set, n * sizeof(int)) == 0)
+            return st;
+    }
+    if (d->num_states == TAM_REGEX_DFA_STATES)
+        return -1;
+
+    // a new state
+    int st = d->num_states++;
+    if (st == d->state_cap) {
+        int newcap = d->state_cap ? 2 * d->state_cap : 16;
+        d->trans = tam_reallocate(d->trans, int, newcap * re->num_byte_classes);
+        d->set_start = tam_reallocate(d->set_start, int, newcap + 1);
+        d->flags = tam_reallocate(d->flags, u8, newcap);
+        d->state_cap = newcap;
+    }
+    if (d->sets_len + n > d->sets_cap) {
+        d->sets_cap = tam_grow_capacity(d->sets_cap, d->sets_len + n);
+        d->sets = tam_reallocate(d->sets, int, d->sets_cap);
+    }
+    d->set_start[st] = d->sets_len;
+    memcpy(d->sets + d->sets_len, set, n * sizeof(int));
+    d->sets_len += n;
+    d->set_start[st + 1] = d->sets_len;
+    for (int k = 0; k < re->num_byte_classes; k++)
+        d->trans[st * re->num_byte_classes + k] = -1;
+    d->table[slot] = st;
+
+    // whether the state matches now, or would if the input ended here
+    u8 flags = n == 0 ? TAM_RE_DFA_DEAD : 0;
+    int m = 0;
+    tam_re_next_gen(d->mark, re->len, &d->gen);
+    for (int i = 0; i < n; i++) {
+        int pc = d->sets[d->set_start[st] + i];
+        if (re->prog[pc].op == TAM_RE_MATCH)
+            flags |= TAM_RE_DFA_MATCH;
+        else if (re->prog[pc].op == TAM_RE_EOL)
+            tam_re_dfa_closure(re, d, pc, false, true, &m);
+    }
+    for (int i = 0; i < m; i++) {
+        if (re->prog[d->out[i]].op == TAM_RE_MATCH)
+            flags |= TAM_RE_DFA_MATCH_AT_END;
+    }
+    d->flags[st] = flags;
+    return st;
+}
+
+// Compute the transition of state `st` on byte class `k`. Returns -1 if the cache is full.
+static int tam_re_dfa_step(tam_regex_t *re, int st, int k) {
+    tam_regex_dfa_t *d = &re->dfa;
+    u8 c = re->class_rep[k];
+    int n = 0;
+    tam_re_next_gen(d->mark, re->len, &d->gen);
+    for (int i = d->set_start[st]; i < d->set_start[st + 1]; i++) {
+        int pc = d->sets[i];
+        if (tam_re_consumes(re, &re->prog[pc], c))
+            tam_re_dfa_closure(re, d, pc + 1, false, false, &n);
+    }
+    // a new match can start at every position
+    if (!re->anchored)
+        tam_re_dfa_closure(re, d, 0, false, false, &n);
+    int next = tam_re_dfa_state(re, n);
+    if (next >= 0)
+        d->trans[st * re->num_byte_classes + k] = next;
+    return next;
+}
+
+// Empty the DFA cache, keeping only state `st`. Returns the new number of `st`.
+static int tam_re_dfa_flush(tam_regex_t *re, int st) {
+    tam_regex_dfa_t *d = &re->dfa;
+    int n = d->set_start[st + 1] - d->set_start[st];
+    memcpy(d->out, d->sets + d->set_start[st], n * sizeof(int));
+    u8 start_flag = d->flags[st] & TAM_RE_DFA_START;
+    d->num_states = 0;
+    d->sets_len = 0;
+    for (int i = 0; i < 2 * TAM_REGEX_DFA_STATES; i++)
+        d->table[i] = -1;
+    d->start = -1;
+    d->start_bol = -1;
+    st = tam_re_dfa_state(re, n);
+    d->flags[st] |= start_flag;
+    return st;
+}
+
+// after the DFA cache fills up twice within this many bytes per state, a search gives up on the DFA
+#define TAM_RE_DFA_MIN_BYTES_PER_STATE 10
+
+// Decide whether there is a match starting at or after `pos` with the lazy DFA.
+// Returns 1 or 0, or -1 if the DFA cache keeps filling up.
+static int tam_re_dfa_search(tam_regex_t *re, tam_slice_t s, int pos) {
+    // at the end of empty input both assertions hold, which the states don't record, so leave it to the Pike VM
+    if (s.len == 0)
+        return -1;
+    tam_regex_dfa_t *d = &re->dfa;
+    int *start = pos == 0 ? &d->start_bol : &d->start;
+    if (*start < 0) {
+        int n = 0;
+        tam_re_next_gen(d->mark, re->len, &d->gen);
+        tam_re_dfa_closure(re, d, 0, pos == 0, false, &n);
+        if ((*start = tam_re_dfa_state(re, n)) < 0)
+            return -1;
+        if (start == &d->start && re->prefix_len > 0)
+            d->flags[*start] |= TAM_RE_DFA_START;
+    }
+    int st = *start;
+    int nc = re->num_byte_classes;
+    // where the cache was last flushed during this search, if it was
+    int flushed_at = -1;
+    for (int i = pos; i < s.len; i++) {
+        u8 flags = d->flags[st];
+        if (flags & (TAM_RE_DFA_MATCH | TAM_RE_DFA_DEAD | TAM_RE_DFA_START)) {
+            if (flags & TAM_RE_DFA_MATCH)
+                return 1;
+            if (flags & TAM_RE_DFA_DEAD)
+                return 0;
+            // back at the start, so the prefilter can skip ahead to the next candidate
+            if ((i = tam_re_next_start(re, s, i)) < 0)
+                return 0;
+        }
+        int k = re->byte_class[(u8)s.buf[i]];
+        int next = d->trans[st * nc + k];
+        if (next < 0 && (next = tam_re_dfa_step(re, st, k)) < 0) {
+            // the cache is full. if that keeps happening, building states costs more than the Pike VM would
+            if (flushed_at >= 0 && i - flushed_at < TAM_RE_DFA_MIN_BYTES_PER_STATE * TAM_REGEX_DFA_STATES)
+                return -1;
+            flushed_at = i;
+            st = tam_re_dfa_flush(re, st);
+            next = tam_re_dfa_step(re, st, k);
+        }
+        st = next;
+    }
+    return (d->flags[st] & (TAM_RE_DFA_MATCH | TAM_RE_DFA_MATCH_AT_END)) != 0;
+}
+
+bool tam_regex_is_match(tam_regex_t *re, tam_slice_t s) {
+    assert(re->error == NULL);
+    int pos = tam_re_next_start(re, s, 0);
+    if (pos < 0)
+        return false;
+    int found = tam_re_dfa_search(re, s, pos);
+    if (found >= 0)
+        return found;
+    return tam_re_pike(re, s, pos);
+}
+
+bool tam_regex_match(tam_regex_t *re, tam_slice_t s, tam_slice_t *caps, int ncaps) {
+    assert(re->error == NULL);
+    int pos = tam_re_next_start(re, s, 0);
+    if (pos < 0)
+        return false;
+    // most inputs don't match, and the DFA finds that out much faster than the Pike VM
+    if (tam_re_dfa_search(re, s, pos) == 0)
+        return false;
+    if (!tam_re_pike(re, s, pos))
+        return false;
+    for (int i = 0; i < ncaps; i++) {
+        int lo = i < re->num_groups ? re->best[2 * i] : -1;
+        int hi = i < re->num_groups ? re->best[2 * i + 1] : -1;
+        caps[i] = lo >= 0 && hi >= 0 ? tam_slice_n(s.buf + lo, hi - lo) : tam_slice_n((const char *)NULL, 0);
+    }
+    return true;
+}
+
+// end regex matching }}}
+
+#if defined(TAM_TEST)
+
+#include <stdio.h>
+
+// ### Regex tests {{{
+int tam_test_regex() {
+    {
+        // matching and captures
+        tam_regex_t re = tam_regex_compile("(\\w+)@(\\w+)\\.com");
+        assert(re.error == NULL && re.num_groups == 3);
+        tam_slice_t caps[3];
+        const char *text = "contact: alice@example.com, bob@test.org";
+        assert(tam_regex_is_match(&re, tam_slice(text)));
+        assert(tam_regex_match(&re, tam_slice(text), caps, 3));
+        assert(tam_sl_eqstr(caps[0], "alice@example.com") && caps[0].buf == text + 9);
+        assert(tam_sl_eqstr(caps[1], "alice") && tam_sl_eqstr(caps[2], "example"));
+        assert(!tam_regex_is_match(&re, tam_slice("bob@test.org")));
+        assert(!tam_regex_match(&re, tam_slice("bob@test.org"), caps, 3));
+        tam_regex_deallocate(&re);
+    }
+    {
+        // leftmost-first semantics, as in Perl: alternatives and greedy or lazy quantifiers are tried in order
+        struct {
+            const char *pattern;
+            const char *text;
+            const char *match; // NULL if there is no match
+            const char *group; // group 1, NULL if it does not participate
+        } cases[] = {
+            {"a|ab", "ab", "a", NULL},
+            {"ab|a", "ab", "ab", NULL},
+            {"a(b*)", "abbbc", "abbb", "bbb"},
+            {"a(b*?)", "abbbc", "a", ""},
+            {"a(b+?)", "abbbc", "ab", "b"},
+            {"<(.+)>", "<a><b>", "<a><b>", "a><b"},
+            {"<(.+?)>", "<a><b>", "<a>", "a"},
+            {"(a|b)*c", "xxababc", "ababc", "b"},
+            {"(x)?y", "y", "y", NULL},
+            {"^abc", "abcabc", "abc", NULL},
+            {"^abc", "xabc", NULL, NULL},
+            {"abc$", "abcabc", "abc", NULL},
+            {"c$", "abcabc", "c", NULL},
+            {"^$", "", "", NULL},
+            {"x*", "", "", NULL},
+            {"a{2,3}", "aaaa", "aaa", NULL},
+            {"a{2,3}?", "aaaa", "aa", NULL},
+            {"a{3}", "aa", NULL, NULL},
+            {"a{2,}", "aaaaa", "aaaaa", NULL},
+            {"(ab){2}", "abababab", "abab", "ab"},
+            {"a{,2}", "a{,2}", "a{,2}", NULL},
+            {"[a-c]+", "xxabcbad", "abcba", NULL},
+            {"[^a-c]+", "abxyzc", "xyz", NULL},
+            {"[]a]+", "]a]b", "]a]", NULL},
+            {"[a\\-z]+", "-az", "-az", NULL},
+            {"\\d+\\.\\d+", "pi is 3.14159", "3.14159", NULL},
+            {"\\s+(\\S+)", "one  two", "  two", "two"},
+            {"a.c", "a\nc abc", "abc", NULL},
+            {"\\x41\\t", "xA\t", "A\t", NULL},
+            {"(?:ab)+(c)", "ababc", "ababc", "c"},
+            {"(a*)*b", "aaab", "aaab", "aaa"},
+            {"(a*)+$", "b", "", ""},
+            {"(|a)+", "aaa", "", ""},
+            {"error: (.*)$", "log error: disk full", "error: disk full", "disk full"},
+        };
+        for (usize k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+            tam_regex_t re = tam_regex_compile(cases[k].pattern);
+            assert(re.error == NULL);
+            tam_slice_t caps[2];
+            bool matched = tam_regex_match(&re, tam_slice(cases[k].text), caps, 2);
+            assert(matched == (cases[k].match != NULL));
+            assert(tam_regex_is_match(&re, tam_slice(cases[k].text)) == matched);
+            if (matched) {
+                assert(tam_sl_eqstr(caps[0], cases[k].match));
+                if (cases[k].group == NULL)
+                    assert(caps[1].buf == NULL);
+                else
+                    assert(caps[1].buf != NULL && tam_sl_eqstr(caps[1], cases[k].group));
+            }
+            tam_regex_deallocate(&re);
+        }
+    }
+    {
+        // syntax errors
+        const char *invalid[] = {"(ab", "ab)", "[ab", "*a", "a**", "a{3,2}", "a{1001}", "\\", "\\q", "(?i)a", "[z-a]"};
+        for (usize k = 0; k < sizeof(invalid) / sizeof(invalid[0]); k++) {
+            tam_regex_t re = tam_regex_compile(invalid[k]);
+            assert(re.error != NULL);
+            tam_regex_deallocate(&re);
+        }
+    }
+    {
+        // pathological patterns take linear time: (a?){n}a{n} against a^n defeats backtracking matchers
+        tam_regex_t re = tam_regex_compile("(a?){30}a{30}");
+        char text[30];
+        memset(text, 'a', sizeof(text));
+        tam_slice_t caps[1];
+        assert(tam_regex_match(&re, tam_slice_n(text, 30), caps, 1) && caps[0].len == 30);
+        tam_regex_deallocate(&re);
+
+        // a DFA with more states than fit in the cache falls back to the Pike VM
+        re = tam_regex_compile("[ab]*a[ab]{13}c");
+        int n = 1 << 16;
+        char *big = tam_allocate(char, n);
+        u32 x = 12345;
+        for (int i = 0; i < n; i++) {
+            x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+            big[i] = x & 1 ? 'a' : 'b';
+        }
+        big[n - 1] = 'c';
+        big[n - 15] = 'b';
+        assert(!tam_regex_is_match(&re, tam_slice_n(big, n)));
+        assert(re.dfa.num_states == TAM_REGEX_DFA_STATES);
+        big[n - 15] = 'a';
+        assert(tam_regex_is_match(&re, tam_slice_n(big, n)));
+        assert(tam_regex_match(&re, tam_slice_n(big, n), caps, 1) && caps[0].len == n);
+
+        // a cache that fills up over many short searches is flushed, rather than given up on for good
+        tam_regex_deallocate(&re);
+        re = tam_regex_compile("[ab]*a[ab]{13}c");
+        bool flushed = false;
+        for (int k = 0; k < 2000; k++) {
+            for (int i = 0; i < 19; i++) {
+                x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+                big[i] = x & 1 ? 'a' : 'b';
+            }
+            big[19] = 'c';
+            int states = re.dfa.num_states;
+            assert(tam_regex_is_match(&re, tam_slice_n(big, 20)) == (big[5] == 'a'));
+            flushed |= re.dfa.num_states < states;
+        }
+        assert(flushed && re.dfa.num_states < TAM_REGEX_DFA_STATES);
+
+        // the generation counters that mark visited states can wrap around
+        for (int i = 0; i < 2; i++)
+            re.threads[i].gen = UINT32_MAX - 1;
+        re.dfa.gen = UINT32_MAX - 1;
+        for (int k = 0; k < 4; k++) {
+            memset(big, 'a', 20);
+            big[19] = 'c';
+            big[k] = 'b';
+            assert(tam_regex_match(&re, tam_slice_n(big, 20), caps, 1) && caps[0].len == 20);
+        }
+        assert(re.threads[0].gen < 100 && re.dfa.gen < 100);
+        tam_deallocate(big);
+        tam_regex_deallocate(&re);
+    }
+    {
+        // finding all matches, with the prefilter skipping through long input
+        tam_regex_t re = tam_regex_compile("key=(\\d+)");
+        char text[2048];
+        int n = 0, expected = 0;
+        for (int i = 0; n < 1900; i++) {
+            n += sprintf(text + n, i % 5 == 0 ? "key=%d " : "other=%d ", i);
+            expected += i % 5 == 0;
+        }
+        tam_slice_t s = tam_slice_n(text, n), caps[2];
+        int found = 0;
+        while (tam_regex_match(&re, s, caps, 2)) {
+            i64 v;
+            assert(tam_sl_parse_i64(caps[1], &v) && v % 5 == 0);
+            found++;
+            int end = caps[0].buf + caps[0].len - s.buf;
+            s = tam_slice_n(s.buf + end, s.len - end);
+        }
+        assert(found == expected);
+        tam_regex_deallocate(&re);
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end regex tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_REGEX_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_REGEX_H
@@ -0,0 +1,380 @@
+#ifndef TAM_SEARCH_H
+#define TAM_SEARCH_H
+
+// TAM static search
+//
+// Search indexes over read-only sorted keys, laid out so that a lookup touches one cache line per level
+// of a B-tree instead of one per halving of a binary search.
+
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Search declarations *** {{{
+
+// keys per node of the search tree: one cache line of u64s
+#define TAM_SEARCH_B 8
+#define TAM_SEARCH_MAX_HEIGHT 32
+
+/*
+ * A static search index over sorted u64 keys, laid out as an S+ tree: a B-tree whose nodes are one
+ * cache line of 8 keys, stored layer by layer in one array without pointers, so the children of a node are
+ * found by arithmetic. The bottom layer is the sorted keys themselves, so a lookup ends at the position of its
+ * result in the sorted order. Each internal key is the smallest key of the subtree to its right.
+ * A lookup reads one node per layer and picks a child by counting the keys less than the one sought, without
+ * branches.
+ */
+typedef struct tam_search_index_t {
+    // the layers of the tree, bottom first, padded with UINT64_MAX to whole nodes
+    const u64 *keys;
+    usize n;
+    int height;
+    // where each layer starts in `keys`
+    usize offsets[TAM_SEARCH_MAX_HEIGHT];
+    void *mem;
+    usize mem_bytes;
+} tam_search_index_t;
+
+/*
+ * Build a search index over `n` keys sorted in ascending order. The keys are copied.
+ * The index takes about 1/8 more memory than the keys.
+ */
+tam_search_index_t tam_search_index_build(const u64 *sorted, usize n);
+
+// Deallocate a search index
+void tam_search_index_deallocate(tam_search_index_t *idx);
+
+/*
+ * The position in the sorted keys of the first key greater than or equal to `x`, or `n` if there is none.
+ * Single lookups do not prefetch, since the node each layer reads depends on the one above it; only
+ * `tam_search_lower_bound_many` overlaps cache misses, across its searches.
+ */
+usize tam_search_lower_bound(const tam_search_index_t *idx, u64 x);
+
+/*
+ * The lower bounds of `count` keys, written to `out`.
+ * The searches are interleaved, prefetching the next node of each while the others are compared, so that
+ * their cache misses overlap. This is several times faster than separate lookups on tables that do not fit in
+ * the cache.
+ */
+void tam_search_lower_bound_many(const tam_search_index_t *idx, const u64 *xs, usize count, usize *out);
+
+/*
+ * A static search index over sorted slices (in the order of `sl_cmp`), which searches a `tam_search_index_t`
+ * of the first 8 bytes of each slice and only compares whole slices among those sharing the 8 bytes sought.
+ * The slices are not copied, and must outlive the index.
+ */
+typedef struct tam_search_slices_t {
+    tam_search_index_t prefixes;
+    const tam_slice_t *slices;
+    usize n;
+} tam_search_slices_t;
+
+tam_search_slices_t tam_search_slices_build(const tam_slice_t *sorted, usize n);
+void tam_search_slices_deallocate(tam_search_slices_t *idx);
+
+/*
+ * The position of the first slice greater than or equal to `x`, or `n` if there is none.
+ */
+usize tam_search_slices_lower_bound(const tam_search_slices_t *idx, tam_slice_t x);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_SEARCH) ///{{{
+typedef tam_search_index_t search_index_t;
+#define search_index_build tam_search_index_build
+#define search_index_deallocate tam_search_index_deallocate
+#define search_lower_bound tam_search_lower_bound
+#define search_lower_bound_many tam_search_lower_bound_many
+typedef tam_search_slices_t search_slices_t;
+#define search_slices_build tam_search_slices_build
+#define search_slices_deallocate tam_search_slices_deallocate
+#define search_slices_lower_bound tam_search_slices_lower_bound
+#endif // end search namespace }}}
+
+// end search declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_SEARCH_IMPLEMENTATION)
+
+#include <assert.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// ### Search index {{{
+
+// how many lookups tam_search_lower_bound_many keeps in flight
+#define TAM_SEARCH_BATCH 16
+
+// the number of keys in the layer above one of `n` keys
+static usize tam_search_parent_keys(usize n) {
+    usize blocks = (n + TAM_SEARCH_B - 1) / TAM_SEARCH_B;
+    return (blocks + TAM_SEARCH_B) / (TAM_SEARCH_B + 1) * TAM_SEARCH_B;
+}
+
+// The number of keys of a node that are less than x, which is the child to descend to
+static inline usize tam_search_rank(const u64 *node, u64 x) {
+#if defined(TAM_AVX2)
+    // flipping the sign bits makes the signed comparison compare as unsigned
+    __m256i sign = _mm256_set1_epi64x((i64)0x8000000000000000ull);
+    __m256i xv = _mm256_xor_si256(_mm256_set1_epi64x((i64)x), sign);
+    __m256i lo = _mm256_xor_si256(_mm256_load_si256((const __m256i *)node), sign);
+    __m256i hi = _mm256_xor_si256(_mm256_load_si256((const __m256i *)(node + 4)), sign);
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(xv, lo))) |
+               _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(xv, hi))) << 4;
+    return tam_popcount64(mask);
+#else
+    usize r = 0;
+    for (int i = 0; i < TAM_SEARCH_B; i++)
+        r += node[i] < x;
+    return r;
+#endif
+}
+
+tam_search_index_t tam_search_index_build(const u64 *sorted, usize n) {
+    tam_search_index_t idx = {0};
+    idx.n = n;
+    // every layer has at least one node, as lookups read a whole node
+    usize leaves = n > TAM_SEARCH_B ? (n + TAM_SEARCH_B - 1) / TAM_SEARCH_B * TAM_SEARCH_B : TAM_SEARCH_B;
+    usize total = leaves;
+    idx.height = 1;
+    for (usize layer_keys = n; layer_keys > TAM_SEARCH_B;) {
+        assert(idx.height < TAM_SEARCH_MAX_HEIGHT);
+        layer_keys = tam_search_parent_keys(layer_keys);
+        idx.offsets[idx.height++] = total;
+        total += layer_keys;
+    }
+
+    // aligned to the cache line, so that each node is one line
+    idx.mem_bytes = total * sizeof(u64) + 64;
+    idx.mem = tam_reallocate_sized(NULL, char, 0, idx.mem_bytes);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // huge pages save a TLB miss per layer on large tables
+    if (idx.mem_bytes >= TAM_MMAP_THRESHOLD)
+        madvise(idx.mem, idx.mem_bytes, MADV_HUGEPAGE);
+#endif
+    u64 *keys = (u64 *)(((uintptr_t)idx.mem + 63) & ~(uintptr_t)63);
+    idx.keys = keys;
+
+    if (n > 0)
+        memcpy(keys, sorted, n * sizeof(u64));
+    for (usize i = n; i < leaves; i++)
+        keys[i] = UINT64_MAX;
+    for (int h = 1; h < idx.height; h++) {
+        usize end = h + 1 < idx.height ? idx.offsets[h + 1] : total;
+        for (usize i = 0; i < end - idx.offsets[h]; i++) {
+            // key j of node m is the first key of its child j + 1, found by then always descending left
+            usize m = i / TAM_SEARCH_B, j = i % TAM_SEARCH_B;
+            usize k = m * (TAM_SEARCH_B + 1) + j + 1;
+            for (int l = 1; l < h; l++)
+                k *= TAM_SEARCH_B + 1;
+            keys[idx.offsets[h] + i] = k * TAM_SEARCH_B < n ? keys[k * TAM_SEARCH_B] : UINT64_MAX;
+        }
+    }
+    return idx;
+}
+
+void tam_search_index_deallocate(tam_search_index_t *idx) {
+    tam_deallocate_sized(idx->mem, char, idx->mem_bytes);
+    idx->keys = NULL;
+    idx->n = 0;
+}
+
+usize tam_search_lower_bound(const tam_search_index_t *idx, u64 x) {
+    // k is the offset of the current node within its layer
+    usize k = 0;
+    for (int h = idx->height - 1; h > 0; h--) {
+        usize i = tam_search_rank(idx->keys + idx->offsets[h] + k, x);
+        k = k * (TAM_SEARCH_B + 1) + i * TAM_SEARCH_B;
+    }
+    // past the last key of a leaf is the first key of the next one, which is where the search continues
+    k += tam_search_rank(idx->keys + k, x);
+    return k < idx->n ? k : idx->n;
+}
+
+void tam_search_lower_bound_many(const tam_search_index_t *idx, const u64 *xs, usize count, usize *out) {
+    for (usize q = 0; q < count; q += TAM_SEARCH_BATCH) {
+        usize m = count - q < TAM_SEARCH_BATCH ? count - q : TAM_SEARCH_BATCH;
+        usize k[TAM_SEARCH_BATCH] = {0};
+        for (int h = idx->height - 1; h > 0; h--) {
+            const u64 *layer = idx->keys + idx->offsets[h];
+            const u64 *below = idx->keys + idx->offsets[h - 1];
+            for (usize j = 0; j < m; j++) {
+                k[j] = k[j] * (TAM_SEARCH_B + 1) + tam_search_rank(layer + k[j], xs[q + j]) * TAM_SEARCH_B;
+                tam_prefetch(below + k[j]);
+            }
+        }
+        for (usize j = 0; j < m; j++) {
+            usize r = k[j] + tam_search_rank(idx->keys + k[j], xs[q + j]);
+            out[q + j] = r < idx->n ? r : idx->n;
+        }
+    }
+}
+
+// end search index }}}
+
+// ### Slice search {{{
+
+// The first 8 bytes of `s`, padded with zeros, as a big-endian integer, which orders like the slices do
+static inline u64 tam_search_slice_prefix(tam_slice_t s) {
+    if (s.len >= 8)
+        return tam_load_be64(s.buf);
+    u8 buf[8] = {0};
+    if (s.len > 0)
+        memcpy(buf, s.buf, s.len);
+    return tam_load_be64(buf);
+}
+
+tam_search_slices_t tam_search_slices_build(const tam_slice_t *sorted, usize n) {
+    u64 *prefixes = tam_allocate(u64, n > 0 ? n : 1);
+    for (usize i = 0; i < n; i++)
+        prefixes[i] = tam_search_slice_prefix(sorted[i]);
+    tam_search_slices_t idx = {.prefixes = tam_search_index_build(prefixes, n), .slices = sorted, .n = n};
+    tam_deallocate(prefixes);
+    return idx;
+}
+
+void tam_search_slices_deallocate(tam_search_slices_t *idx) {
+    tam_search_index_deallocate(&idx->prefixes);
+    idx->slices = NULL;
+    idx->n = 0;
+}
+
+usize tam_search_slices_lower_bound(const tam_search_slices_t *idx, tam_slice_t x) {
+    u64 p = tam_search_slice_prefix(x);
+    usize lo = tam_search_lower_bound(&idx->prefixes, p);
+    // the slices sharing the prefix end where the sorted prefixes in the bottom layer change, found by
+    // doubling steps from `lo`
+    const u64 *prefixes = idx->prefixes.keys;
+    usize hi = lo, step = 1;
+    while (hi < idx->n && prefixes[hi] == p) {
+        hi = lo + step < idx->n ? lo + step : idx->n;
+        step *= 2;
+    }
+    // binary search of the whole slices in [lo, hi)
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        if (tam_sl_cmp(idx->slices[mid], x) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// end slice search }}}
+
+#if defined(TAM_TEST)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ### Search tests {{{
+
+static usize tam_test_search_lower_bound(const u64 *a, usize n, u64 x) {
+    usize lo = 0, hi = n;
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        if (a[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int tam_test_search_cmp_u64(const void *a, const void *b) {
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return (x > y) - (x < y);
+}
+
+static int tam_test_search_cmp_slices(const void *a, const void *b) {
+    return tam_sl_cmp(*(const tam_slice_t *)a, *(const tam_slice_t *)b);
+}
+
+int tam_test_search() {
+    // sizes around whole nodes and layers, with keys from small and full ranges and at the extremes
+    usize sizes[] = {0, 1, 7, 8, 9, 72, 73, 80, 81, 648, 730, 1000, 100000};
+    u64 r = 88172645463325252ull;
+    for (usize s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int mode = 0; mode < 2; mode++) {
+            usize n = sizes[s];
+            u64 *a = tam_allocate(u64, n + 1);
+            for (usize i = 0; i < n; i++) {
+                r ^= r << 13, r ^= r >> 7, r ^= r << 17;
+                a[i] = mode == 0 ? r % (n + 1) * 3 : r % 5 == 0 ? UINT64_MAX : r;
+            }
+            qsort(a, n, sizeof(u64), tam_test_search_cmp_u64);
+            tam_search_index_t idx = tam_search_index_build(a, n);
+
+            usize nq = 3 * n + 4;
+            u64 *xs = tam_allocate(u64, nq);
+            usize *out = tam_allocate(usize, nq);
+            xs[0] = 0, xs[1] = 1, xs[2] = UINT64_MAX, xs[3] = UINT64_MAX - 1;
+            for (usize i = 4; i < nq; i++) {
+                r ^= r << 13, r ^= r >> 7, r ^= r << 17;
+                xs[i] = i % 3 == 0 ? a[r % n] : i % 3 == 1 ? a[r % n] + 1 : mode == 0 ? r % (3 * n + 5) : r;
+            }
+            tam_search_lower_bound_many(&idx, xs, nq, out);
+            for (usize i = 0; i < nq; i++) {
+                usize expected = tam_test_search_lower_bound(a, n, xs[i]);
+                assert(tam_search_lower_bound(&idx, xs[i]) == expected);
+                assert(out[i] == expected);
+            }
+            tam_search_index_deallocate(&idx);
+            tam_deallocate(a);
+            tam_deallocate(xs);
+            tam_deallocate(out);
+        }
+    }
+
+    // slices, many of which share their first 8 bytes
+    usize n = 5000;
+    char *text = tam_allocate(char, n * 16);
+    tam_slice_t *sl = tam_allocate(tam_slice_t, n);
+    for (usize i = 0; i < n; i++) {
+        r ^= r << 13, r ^= r >> 7, r ^= r << 17;
+        int len = r % 14;
+        for (int j = 0; j < len; j++)
+            text[16 * i + j] = j < 6 && (r >> (j + 8)) % 4 != 0 ? 'x' : "\0ab"[(r >> (2 * j + 16)) % 3];
+        sl[i] = tam_slice_n(text + 16 * i, len);
+    }
+    qsort(sl, n, sizeof(tam_slice_t), tam_test_search_cmp_slices);
+    tam_search_slices_t sidx = tam_search_slices_build(sl, n);
+    for (usize i = 0; i < n; i++) {
+        // each slice itself, and slices just before and after it
+        tam_slice_t x = sl[(i * 7919) % n];
+        char buf[17];
+        memcpy(buf, x.buf, x.len);
+        buf[x.len] = '\0';
+        tam_slice_t queries[] = {x, tam_slice_n(buf, x.len + 1), tam_slice_n(x.buf, x.len > 0 ? x.len - 1 : 0)};
+        for (int q = 0; q < 3; q++) {
+            usize expected = 0;
+            while (expected < n && tam_sl_cmp(sl[expected], queries[q]) < 0)
+                expected++;
+            assert(tam_search_slices_lower_bound(&sidx, queries[q]) == expected);
+        }
+    }
+    assert(tam_search_slices_lower_bound(&sidx, tam_slice("")) == 0);
+    assert(tam_search_slices_lower_bound(&sidx, tam_slice("\xff")) == n);
+    tam_search_slices_deallocate(&sidx);
+    tam_deallocate(text);
+    tam_deallocate(sl);
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end search tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_SEARCH_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_SEARCH_H
@@ -0,0 +1,227 @@
+#ifndef TAM_SIMD_H
+#define TAM_SIMD_H
+
+// TAM SIMD helpers
+//
+// Feature detection and small helpers shared by the vectorized kernels in the other headers.
+// Kernels are selected at compile time from the target flags (e.g. -mavx2 or -march=native),
+// and every kernel has a portable scalar fallback. Define TAM_NO_SIMD to force the fallbacks.
+
+#include <string.h>
+#include <tam/types.h>
+
+#if !defined(TAM_NO_SIMD)
+#if defined(__AVX2__)
+#define TAM_AVX2
+#endif
+#if defined(__SSSE3__)
+#define TAM_SSSE3
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define TAM_SSE2
+#endif
+#if defined(__PCLMUL__) && (defined(__x86_64__) || defined(_M_X64))
+#define TAM_PCLMUL
+#endif
+#endif // TAM_NO_SIMD
+
+#if defined(TAM_AVX2) || defined(TAM_SSSE3)
+#include <immintrin.h>
+#elif defined(TAM_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(TAM_PCLMUL)
+#include <wmmintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// broadcast a byte to all bytes of a 64-bit word
+#define TAM_SWAR_ONES 0x0101010101010101ull
+#define TAM_SWAR_HIGHS 0x8080808080808080ull
+#define TAM_SWAR_BYTES(b) (TAM_SWAR_ONES * (u8)(b))
+
+// nonzero if any byte of x is zero
+#define TAM_SWAR_HAS_ZERO(x) (((x) - TAM_SWAR_ONES) & ~(x) & TAM_SWAR_HIGHS)
+// nonzero if any byte of x is less than n (n <= 128)
+#define TAM_SWAR_HAS_LESS(x, n) (((x) - TAM_SWAR_BYTES(n)) & ~(x) & TAM_SWAR_HIGHS)
+
+static inline u64 tam_load_u64(const void *p) {
+    u64 x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+// load 8 bytes as a big-endian integer, so that comparing loaded words compares the bytes in memory order
+static inline u64 tam_load_be64(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+    u64 x = tam_load_u64(p);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+#else
+    const u8 *b = (const u8 *)p;
+    u64 x = 0;
+    for (int i = 0; i < 8; i++)
+        x = (x << 8) | b[i];
+    return x;
+#endif
+}
+
+// hint that the cache line holding p will be read soon
+static inline void tam_prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif defined(TAM_SSE2)
+    _mm_prefetch((const char *)p, _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+static inline int tam_ctz32(u32 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static inline int tam_ctz64(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static inline int tam_clz32(u32 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+    while (!(x & 0x80000000u)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static inline int tam_popcount64(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x; x &= x - 1)
+        n++;
+    return n;
+#endif
+}
+
+/*
+ * Prefix XOR of the bits of x: bit i of the result is the XOR of bits 0 through i of x.
+ * Given a bitmask of quote characters, this marks the bytes between opening and closing quotes
+ * (including the opening quote), which is how the parsers find quoted regions without branching.
+ * A single carry-less multiplication by all ones with PCLMUL, six shifts otherwise.
+ */
+static inline u64 tam_prefix_xor64(u64 x) {
+#if defined(TAM_PCLMUL)
+    __m128i all_ones = _mm_set1_epi8(-1);
+    return (u64)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_cvtsi64_si128((i64)x), all_ones, 0));
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+// 64 bytes of input, loaded once and then compared against several characters to build bitmasks
+typedef struct tam_block64_t {
+#if defined(TAM_AVX2)
+    __m256i v[2];
+#elif defined(TAM_SSE2)
+    __m128i v[4];
+#else
+    u8 v[64];
+#endif
+} tam_block64_t;
+
+static inline tam_block64_t tam_block64_load(const char *p) {
+    tam_block64_t b;
+#if defined(TAM_AVX2)
+    b.v[0] = _mm256_loadu_si256((const __m256i *)p);
+    b.v[1] = _mm256_loadu_si256((const __m256i *)(p + 32));
+#elif defined(TAM_SSE2)
+    for (int i = 0; i < 4; i++)
+        b.v[i] = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+#else
+    memcpy(b.v, p, 64);
+#endif
+    return b;
+}
+
+// Bit i of the result is set if byte i of the block equals c
+static inline u64 tam_block64_eq(const tam_block64_t *b, char c) {
+#if defined(TAM_AVX2)
+    __m256i cv = _mm256_set1_epi8(c);
+    u64 lo = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b->v[0], cv));
+    u64 hi = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b->v[1], cv));
+    return lo | (hi << 32);
+#elif defined(TAM_SSE2)
+    __m128i cv = _mm_set1_epi8(c);
+    u64 mask = 0;
+    for (int i = 0; i < 4; i++)
+        mask |= (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(b->v[i], cv)) << (16 * i);
+    return mask;
+#else
+    u64 mask = 0;
+    for (int i = 0; i < 64; i++)
+        mask |= (u64)(b->v[i] == (u8)c) << i;
+    return mask;
+#endif
+}
+
+// Bit i of the result is set if byte i of the block is at most c (as unsigned bytes)
+static inline u64 tam_block64_le(const tam_block64_t *b, u8 c) {
+#if defined(TAM_AVX2)
+    __m256i cv = _mm256_set1_epi8((char)c);
+    u64 lo = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(b->v[0], cv), b->v[0]));
+    u64 hi = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(b->v[1], cv), b->v[1]));
+    return lo | (hi << 32);
+#elif defined(TAM_SSE2)
+    __m128i cv = _mm_set1_epi8((char)c);
+    u64 mask = 0;
+    for (int i = 0; i < 4; i++)
+        mask |= (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(b->v[i], cv), b->v[i])) << (16 * i);
+    return mask;
+#else
+    u64 mask = 0;
+    for (int i = 0; i < 64; i++)
+        mask |= (u64)(b->v[i] <= c) << i;
+    return mask;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_SIMD_H
@@ -10,6 +10,7 @@
 extern "C" {
 #endif
 
+#include <tam/simd.h>
 #include <tam/types.h>
 
 //*** ## Slice declarations *** {{
@@ -39,25 +40,48 @@ typedef struct tam_slice_t {
  */
 char tam_sl_idx(tam_slice_t s, int i);
 
+// whether `tam_sl_at` checks its index. on by default, and off when NDEBUG is defined unless forced on with
+// -DTAM_BOUNDS_CHECK=1, which checks release builds too.
+#ifndef TAM_BOUNDS_CHECK
+#ifdef NDEBUG
+#define TAM_BOUNDS_CHECK 0
+#else
+#define TAM_BOUNDS_CHECK 1
+#endif
+#endif
+
+/*
+ * Obtain the character at non-negative index i < s.len in a slice.
+ * Unlike `sl_idx` this does not support negative indices, and the index is only checked when
+ * TAM_BOUNDS_CHECK is nonzero, so that in release builds it compiles to a plain load.
+ * An index out of range is reported with `tam_errorf`, which exits.
+ */
+#if TAM_BOUNDS_CHECK
+#define tam_sl_at(s, i) ((s).buf[tam_check_slice_index((i), (s).len)])
+#else
+#define tam_sl_at(s, i) ((s).buf[i])
+#endif
+int tam_check_slice_index(int i, int len);
+
 /*
  * Construct a slice from a raw char* buf.
  * This calls strlen to get the length, so `buf` must be null-terminated.
  * If you have already computed the length or otherwise do want to rely on `strlen`, use `slice_len` below.
  */
 #define tam_slice(buf)                                                                                                 \
-(tam_slice_t) { strlen(buf), buf }
+((tam_slice_t){strlen(buf), buf})
 
 /*
  * Construct a slice from a raw char* buf and a length.
  */
 #define tam_slice_n(buf, len)                                                                                          \
-(tam_slice_t) { len, buf }
+((tam_slice_t){len, buf})
 
 /*
  * Construct a slice from a String.
  */
 #define tam_slstr(str)                                                                                                 \
-(tam_slice_t) { str.len, str.buf }
+((tam_slice_t){str.len, str.buf})
 
 /*
  * Construct a slice from an existing slice and a start and stop index
@@ -98,10 +122,18 @@ bool tam_sl_eq(tam_slice_t s1, tam_slice_t s2);
  */
 bool tam_sl_eqstr(tam_slice_t s, const char *c);
 
+/*
+ * Compare two slices byte by byte, as unsigned chars, like `strcmp`.
+ * A slice comes before any longer slice that it is a prefix of.
+ */
+int tam_sl_cmp(tam_slice_t s1, tam_slice_t s2);
+
 /*
  * NOTE: modifies the input slice!!!
  * Remove leading whitespace from a slice.
  * Return index of first char after leading spaces in original slice.
+ * Whitespace is the ASCII whitespace of the C locale (space, \t, \n, \v, \f and \r) regardless of the
+ * current locale, and is skipped 16 or 32 bytes at a time.
  */
 int tam_sl_lstrip(tam_slice_t *s);
 
@@ -169,6 +201,7 @@ bool tam_sl_startswithstr(tam_slice_t s, const char *str);
 /*
  * Find index of first occurrance of slice `needle` in slice `haystack`
  * Returns length of `haystack` if `needle` not found
+ * Candidate positions are found 16 or 32 at a time by comparing the first and last bytes of `needle`.
  */
 int tam_sl_find(tam_slice_t haystack, tam_slice_t needle);
 
@@ -191,12 +224,115 @@ u64 tam_sl_hash(tam_slice_t s);
 
 // ### end slice utility functions }}}
 
+//*** ### UTF-8 functions *** {{{
+
+/*
+ * Check whether a slice is valid UTF-8, i.e. contains no overlong encodings, surrogates,
+ * codepoints above U+10FFFF, or truncated or stray continuation bytes.
+ * Runs of ASCII are skipped 8 to 32 bytes at a time, and with SSSE3 or AVX2 the rest of the input is
+ * validated using the lookup-table algorithm of Keiser and Lemire.
+ */
+bool tam_sl_utf8_valid(tam_slice_t s);
+
+/*
+ * Count the codepoints in a slice of valid UTF-8.
+ * This counts the bytes that are not continuation bytes, so it does not validate its input.
+ */
+int tam_sl_utf8_count(tam_slice_t s);
+
+// ### end UTF-8 functions }}}
+
+//*** ### ASCII case-insensitive functions *** {{{
+// These only fold the ASCII letters A-Z and a-z, so they are locale-independent and safe to use on UTF-8.
+
+/*
+ * Check if two slices are equal, ignoring ASCII case.
+ */
+bool tam_sl_eq_nocase(tam_slice_t s1, tam_slice_t s2);
+
+/*
+ * Return true if slice `s` starts with slice `x`, ignoring ASCII case, and false otherwise
+ */
+bool tam_sl_startswith_nocase(tam_slice_t s, tam_slice_t x);
+
+/*
+ * Find index of first occurrance of slice `needle` in slice `haystack`, ignoring ASCII case.
+ * Returns length of `haystack` if `needle` not found.
+ * Candidate positions are found 16 or 32 at a time by comparing the first and last bytes of `needle`.
+ */
+int tam_sl_find_nocase(tam_slice_t haystack, tam_slice_t needle);
+
+/*
+ * Write the contents of a slice, converted to lowercase, to `dst`, which must have room for `s.len` bytes.
+ * `dst` may be `s.buf` to convert a mutable buffer in place. Nothing is null-terminated.
+ */
+void tam_sl_tolower(char *dst, tam_slice_t s);
+
+/*
+ * Write the contents of a slice, converted to uppercase, to `dst`, which must have room for `s.len` bytes.
+ * `dst` may be `s.buf` to convert a mutable buffer in place. Nothing is null-terminated.
+ */
+void tam_sl_toupper(char *dst, tam_slice_t s);
+
+// ### end ASCII case-insensitive functions }}}
+
+//*** ### Numeric parsing *** {{{
+// Unlike strtol and friends, these require the whole slice to be the number (no leading whitespace or trailing
+// characters) and don't need the slice to be null-terminated.
+
+/*
+ * Parse a slice holding a decimal integer with an optional leading sign.
+ * Returns false if the slice is not an integer or the value does not fit in an i64.
+ */
+bool tam_sl_parse_i64(tam_slice_t s, i64 *out);
+
+/*
+ * Parse a slice holding a decimal integer with an optional leading `+`.
+ * Returns false if the slice is not an integer or the value does not fit in a u64.
+ */
+bool tam_sl_parse_u64(tam_slice_t s, u64 *out);
+
+/*
+ * Parse a slice holding a decimal floating point number, i.e. an optional sign, digits with an optional
+ * decimal point, and an optional exponent. The result is correctly rounded.
+ * Numbers with at most 15 significant digits and small exponents take a fast path, everything else goes
+ * through strtod (so `.` must be the locale's decimal point). Returns false if the slice is not a number.
+ */
+bool tam_sl_parse_f64(tam_slice_t s, f64 *out);
+
+// ### end numeric parsing }}}
+
+//*** ### Timestamp parsing *** {{{
+// Digits are extracted from fixed positions eight at a time with SWAR arithmetic rather than one by one,
+// and the date part of the most recently parsed timestamp is cached per thread, so that consecutive log lines
+// from the same day only convert the time of day.
+
+/*
+ * Parse an ISO 8601 / RFC 3339 timestamp such as `2026-10-15T12:34:56.789Z` into nanoseconds since the
+ * Unix epoch. The date and time may be separated by `T` or a space, the fraction can have 1 to 9 digits, and the
+ * offset may be `Z`, `+HH:MM`, `+HHMM`, `+HH` or missing, in which case the time is taken to be UTC.
+ * Returns false if the slice is not such a timestamp, names a date or time that does not exist, or is outside
+ * the range of i64 nanoseconds (the years 1678 to 2262).
+ */
+bool tam_sl_parse_iso8601(tam_slice_t s, i64 *ns);
+
+/*
+ * Parse a Common Log Format timestamp such as `10/Oct/2000:13:55:36 -0700` into nanoseconds since the
+ * Unix epoch. The timestamp may be enclosed in the square brackets that web server logs put around it.
+ * Returns false if the slice is not such a timestamp, names a date or time that does not exist, or is outside
+ * the range of i64 nanoseconds.
+ */
+bool tam_sl_parse_clf_time(tam_slice_t s, i64 *ns);
+
+// ### end timestamp parsing }}}
+
 #if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_STRINGS) //{{{
 
 #define Slice tam_slice_t
 
 // indexing
 #define sl_idx tam_sl_idx
+#define sl_at tam_sl_at
 
 // construction
 #define slice tam_slice
@@ -210,6 +346,7 @@ u64 tam_sl_hash(tam_slice_t s);
 #define sl_eqv tam_sl_eqv
 #define sl_eq tam_sl_eq
 #define sl_eqstr tam_sl_eqstr
+#define sl_cmp tam_sl_cmp
 #define sl_lstrip tam_sl_lstrip
 #define slice_lstrip tam_slice_lstrip
 #define sl_rstrip tam_sl_rstrip
@@ -227,6 +364,26 @@ u64 tam_sl_hash(tam_slice_t s);
 #define slice_getline tam_slice_getline
 #define sl_hash tam_sl_hash
 
+// UTF-8
+#define sl_utf8_valid tam_sl_utf8_valid
+#define sl_utf8_count tam_sl_utf8_count
+
+// case-insensitive
+#define sl_eq_nocase tam_sl_eq_nocase
+#define sl_startswith_nocase tam_sl_startswith_nocase
+#define sl_find_nocase tam_sl_find_nocase
+#define sl_tolower tam_sl_tolower
+#define sl_toupper tam_sl_toupper
+
+// numeric parsing
+#define sl_parse_i64 tam_sl_parse_i64
+#define sl_parse_u64 tam_sl_parse_u64
+#define sl_parse_f64 tam_sl_parse_f64
+
+// timestamp parsing
+#define sl_parse_iso8601 tam_sl_parse_iso8601
+#define sl_parse_clf_time tam_sl_parse_clf_time
+
 #endif // end slice namespacing }}}
 
 // end Slice declarations}}}
@@ -238,8 +395,8 @@ u64 tam_sl_hash(tam_slice_t s);
 #if defined(TAM_IMPLEMENTATION)
 
 #include <assert.h>
-#include <ctype.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tam/memory.h>
 
@@ -257,6 +414,12 @@ int tam_get_slice_index(int i, int len) {
 
 char tam_sl_idx(tam_slice_t s, int i) { return s.buf[tam_get_slice_index(i, s.len)]; }
 
+int tam_check_slice_index(int i, int len) {
+    if (i < 0 || i >= len)
+        tam_errorf("slice index %d out of range for length %d", i, len);
+    return i;
+}
+
 tam_slice_t tam_reslice(tam_slice_t s, int i, int j) {
     i = tam_get_slice_index(i, s.len);
     j = tam_get_slice_index(j, s.len);
@@ -285,14 +448,84 @@ bool tam_sl_eqstr(tam_slice_t s, const char *c) {
     size_t len = strlen(c);
     if (len != s.len)
         return false;
-    return strncmp(s.buf, c, s.len) == 0;
+    // empty StringBuilders view a NULL buffer
+    return len == 0 || strncmp(s.buf, c, s.len) == 0;
 }
 
-int tam_sl_lstrip(tam_slice_t *s) {
-    int i;
-    for (i = 0; i < s->len && isspace(tam_sl_idx(*s, i)); i++)
+int tam_sl_cmp(tam_slice_t s1, tam_slice_t s2) {
+    int n = s1.len < s2.len ? s1.len : s2.len;
+    int c = n == 0 ? 0 : memcmp(s1.buf, s2.buf, n);
+    return c != 0 ? c : (s1.len > s2.len) - (s1.len < s2.len);
+}
+
+static inline bool tam_ascii_isspace(char c) { return c == ' ' || (u8)(c - '\t') < 5; }
+
+#if defined(TAM_SSE2)
+// Bitmask of the whitespace bytes in a 16-byte block
+static inline u32 tam_space_mask16(__m128i v) {
+    // \t, \n, \v, \f and \r are 9 through 13, so v - 9 <= 4 (unsigned) picks them out
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+    return _mm_movemask_epi8(_mm_or_si128(ctrl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))));
+}
+#endif
+
+#if defined(TAM_AVX2)
+static inline u32 tam_space_mask32(__m256i v) {
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(4)), t);
+    return _mm256_movemask_epi8(_mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))));
+}
+#endif
+
+// Number of leading whitespace bytes in s
+static int tam_space_run(const char *s, int n) {
+    int i = 0;
+#if defined(TAM_AVX2)
+    for (; i + 32 <= n; i += 32) {
+        u32 mask = ~tam_space_mask32(_mm256_loadu_si256((const __m256i *)(s + i)));
+        if (mask != 0)
+            return i + tam_ctz32(mask);
+    }
+#endif
+#if defined(TAM_SSE2)
+    for (; i + 16 <= n; i += 16) {
+        u32 mask = ~tam_space_mask16(_mm_loadu_si128((const __m128i *)(s + i))) & 0xffff;
+        if (mask != 0)
+            return i + tam_ctz32(mask);
+    }
+#endif
+    for (; i < n && tam_ascii_isspace(s[i]); i++)
         ;
-    *s = tam_slice_suffix(*s, i);
+    return i;
+}
+
+// Length of s with trailing whitespace removed
+static int tam_space_run_back(const char *s, int n) {
+    int i = n;
+#if defined(TAM_AVX2)
+    for (; i >= 32; i -= 32) {
+        u32 mask = ~tam_space_mask32(_mm256_loadu_si256((const __m256i *)(s + i - 32)));
+        if (mask != 0)
+            return i - tam_clz32(mask);
+    }
+#endif
+#if defined(TAM_SSE2)
+    for (; i >= 16; i -= 16) {
+        // shift the block's mask to the top of the word so that clz counts the trailing spaces
+        u32 mask = ~tam_space_mask16(_mm_loadu_si128((const __m128i *)(s + i - 16))) << 16;
+        if (mask != 0)
+            return i - tam_clz32(mask);
+    }
+#endif
+    for (; i > 0 && tam_ascii_isspace(s[i - 1]); i--)
+        ;
+    return i;
+}
+
+int tam_sl_lstrip(tam_slice_t *s) {
+    int i = tam_space_run(s->buf, s->len);
+    *s = tam_slice_n(s->buf + i, s->len - i);
     return i;
 }
 
@@ -301,13 +534,10 @@ tam_slice_t tam_slice_lstrip(tam_slice_t s) {
     return s;
 }
 
-#int tam_sl_rstrip(tam_slice_t *s) {
-int i;
-for (i = s->len - 1; i >= 0 && isspace(tam_sl_idx(*s, i)); i--)
-    ;
-i++;
-*s = tam_slice_prefix(*s, i);
-return i;
+int tam_sl_rstrip(tam_slice_t *s) {
+    int i = tam_space_run_back(s->buf, s->len);
+    *s = tam_slice_n(s->buf, i);
+    return i;
 }
 
 tam_slice_t tam_slice_rstrip(tam_slice_t s) {
@@ -358,23 +588,55 @@ bool tam_sl_startswith(tam_slice_t s, tam_slice_t x) { return strncmp(x.buf, s.b
 bool tam_sl_startswithstr(tam_slice_t s, const char *str) { return strncmp(str, s.buf, strlen(str)) == 0; }
 
 int tam_sl_find(tam_slice_t haystack, tam_slice_t needle) {
-    int pos;
-    // haystack:     "Hello, world!"
-    // haystack inds: 0123456789ABC
-    // haystack.len: 13
-    // if needle is "world!", then we need to advance the start pos up until 7
-    // the needle length is 6, so we want to start the search at 7 = haystack.len - needle.len
-    for (pos = 0; pos <= (haystack.len - needle.len); pos++) {
-        int i;
-        for (i = 0; i < needle.len; i++) {
-            if (tam_sl_idx(needle, i) != tam_sl_idx(haystack, pos + i)) {
-                break;
-            }
+    int n = haystack.len;
+    int m = needle.len;
+    if (m == 0)
+        return 0;
+    if (m > n)
+        return n;
+    const char *h = haystack.buf;
+    int pos = 0;
+    // compare the first and last bytes of the needle against 16 or 32 positions at once,
+    // and only compare the rest of the needle at positions where both agree
+#if defined(TAM_AVX2)
+    const __m256i first32 = _mm256_set1_epi8(needle.buf[0]);
+    const __m256i last32 = _mm256_set1_epi8(needle.buf[m - 1]);
+    for (; pos + m - 1 + 32 <= n; pos += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(h + pos));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(h + pos + m - 1));
+        u32 mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first32), _mm256_cmpeq_epi8(b, last32)));
+        for (; mask != 0; mask &= mask - 1) {
+            int i = pos + tam_ctz32(mask);
+            if (memcmp(h + i + 1, needle.buf + 1, m - 1) == 0)
+                return i;
         }
-        if (i == needle.len)
+    }
+#endif
+#if defined(TAM_SSE2)
+    const __m128i first16 = _mm_set1_epi8(needle.buf[0]);
+    const __m128i last16 = _mm_set1_epi8(needle.buf[m - 1]);
+    for (; pos + m - 1 + 16 <= n; pos += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(h + pos));
+        __m128i b = _mm_loadu_si128((const __m128i *)(h + pos + m - 1));
+        u32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first16), _mm_cmpeq_epi8(b, last16)));
+        for (; mask != 0; mask &= mask - 1) {
+            int i = pos + tam_ctz32(mask);
+            if (memcmp(h + i + 1, needle.buf + 1, m - 1) == 0)
+                return i;
+        }
+    }
+#endif
+    // memchr for the first byte, then compare the rest
+    while (pos <= n - m) {
+        const char *p = (const char *)memchr(h + pos, needle.buf[0], n - m + 1 - pos);
+        if (p == NULL)
+            break;
+        pos = p - h;
+        if (memcmp(p + 1, needle.buf + 1, m - 1) == 0)
             return pos;
+        pos++;
     }
-    return haystack.len;
+    return n;
 }
 
 u64 tam_sl_hash(tam_slice_t s) {
@@ -388,6 +650,759 @@ u64 tam_sl_hash(tam_slice_t s) {
 
 // end Slice implementation }}}
 
+// ### UTF-8 implementation {{{
+
+#if !defined(TAM_AVX2) && !defined(TAM_SSSE3)
+// Validate UTF-8 one codepoint at a time, for targets without the vector kernels below.
+// Those zero-pad their tails instead, since zeros are ASCII.
+static bool tam_utf8_valid_scalar(const u8 *s, usize n) {
+    usize i = 0;
+    while (i < n) {
+        // skip ASCII eight bytes at a time
+        if (i + 8 <= n && (tam_load_u64(s + i) & TAM_SWAR_HIGHS) == 0) {
+            i += 8;
+            continue;
+        }
+        u8 c = s[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        int len;
+        u32 min;
+        u32 cp;
+        if (c >= 0xc2 && c <= 0xdf) {
+            len = 2, min = 0x80, cp = c & 0x1f;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            len = 3, min = 0x800, cp = c & 0x0f;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            len = 4, min = 0x10000, cp = c & 0x07;
+        } else {
+            return false;
+        }
+        if (i + len > n)
+            return false;
+        for (int k = 1; k < len; k++) {
+            u8 cc = s[i + k];
+            if ((cc & 0xc0) != 0x80)
+                return false;
+            cp = (cp << 6) | (cc & 0x3f);
+        }
+        if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+            return false;
+        i += len;
+    }
+    return true;
+}
+#endif
+
+#if defined(TAM_SSSE3)
+// Error classes of the Keiser-Lemire algorithm. Each pair of consecutive bytes is classified by the
+// high nibble of the first byte, the low nibble of the first byte and the high nibble of the second
+// byte, and it is an error iff all three lookups share a bit.
+#define TAM_UTF8_TOO_SHORT (1 << 0)
+#define TAM_UTF8_TOO_LONG (1 << 1)
+#define TAM_UTF8_OVERLONG_3 (1 << 2)
+#define TAM_UTF8_TOO_LARGE (1 << 3)
+#define TAM_UTF8_SURROGATE (1 << 4)
+#define TAM_UTF8_OVERLONG_2 (1 << 5)
+#define TAM_UTF8_TOO_LARGE_1000 (1 << 6)
+#define TAM_UTF8_OVERLONG_4 (1 << 6)
+#define TAM_UTF8_TWO_CONTS (1 << 7)
+#define TAM_UTF8_CARRY (TAM_UTF8_TOO_SHORT | TAM_UTF8_TOO_LONG | TAM_UTF8_TWO_CONTS)
+
+#define TAM_UTF8_BYTE_1_HIGH                                                                                           \
+    TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG,  \
+        TAM_UTF8_TOO_LONG, TAM_UTF8_TOO_LONG, TAM_UTF8_TWO_CONTS, TAM_UTF8_TWO_CONTS, TAM_UTF8_TWO_CONTS,              \
+        TAM_UTF8_TWO_CONTS, TAM_UTF8_TOO_SHORT | TAM_UTF8_OVERLONG_2, TAM_UTF8_TOO_SHORT,                              \
+        TAM_UTF8_TOO_SHORT | TAM_UTF8_OVERLONG_3 | TAM_UTF8_SURROGATE,                                                 \
+        TAM_UTF8_TOO_SHORT | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000 | TAM_UTF8_OVERLONG_4
+
+#define TAM_UTF8_BYTE_1_LOW                                                                                            \
+    TAM_UTF8_CARRY | TAM_UTF8_OVERLONG_3 | TAM_UTF8_OVERLONG_2 | TAM_UTF8_OVERLONG_4,                                  \
+        TAM_UTF8_CARRY | TAM_UTF8_OVERLONG_2, TAM_UTF8_CARRY, TAM_UTF8_CARRY, TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE,     \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000 | TAM_UTF8_SURROGATE,                            \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000,                                                 \
+        TAM_UTF8_CARRY | TAM_UTF8_TOO_LARGE | TAM_UTF8_TOO_LARGE_1000
+
+#define TAM_UTF8_BYTE_2_HIGH                                                                                           \
+    TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT,                \
+        TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT,                                                    \
+        TAM_UTF8_TOO_LONG | TAM_UTF8_OVERLONG_2 | TAM_UTF8_TWO_CONTS | TAM_UTF8_OVERLONG_3 | TAM_UTF8_TOO_LARGE_1000 |  \
+            TAM_UTF8_OVERLONG_4,                                                                                       \
+        TAM_UTF8_TOO_LONG | TAM_UTF8_OVERLONG_2 | TAM_UTF8_TWO_CONTS | TAM_UTF8_OVERLONG_3 | TAM_UTF8_TOO_LARGE,       \
+        TAM_UTF8_TOO_LONG | TAM_UTF8_OVERLONG_2 | TAM_UTF8_TWO_CONTS | TAM_UTF8_SURROGATE | TAM_UTF8_TOO_LARGE,        \
+        TAM_UTF8_TOO_LONG | TAM_UTF8_OVERLONG_2 | TAM_UTF8_TWO_CONTS | TAM_UTF8_SURROGATE | TAM_UTF8_TOO_LARGE,        \
+        TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT, TAM_UTF8_TOO_SHORT
+
+// Errors in a 16-byte block, given the previous block (for sequences that straddle the boundary)
+static inline __m128i tam_utf8_block_errors(__m128i input, __m128i prev_input) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(_mm_setr_epi8(TAM_UTF8_BYTE_1_HIGH),
+                                           _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(_mm_setr_epi8(TAM_UTF8_BYTE_1_LOW), _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(_mm_setr_epi8(TAM_UTF8_BYTE_2_HIGH),
+                                           _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // the bytes that must be the 2nd or 3rd continuation of a 3 or 4 byte sequence
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i is_third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xe0 - 0x80)));
+    __m128i is_fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xf0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(is_third, is_fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+// Nonzero if the block ends in the middle of a multibyte sequence
+static inline __m128i tam_utf8_block_incomplete(__m128i input) {
+    const __m128i max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xf0 - 1),
+                                      (char)(0xe0 - 1), (char)(0xc0 - 1));
+    return _mm_subs_epu8(input, max);
+}
+#endif
+
+#if defined(TAM_AVX2)
+static inline __m256i tam_utf8_prev32(__m256i input, __m256i prev_input, int n) {
+    // the 16 bytes before each lane, so that alignr can reach across the lane boundary
+    __m256i before = _mm256_permute2x128_si256(prev_input, input, 0x21);
+    switch (n) {
+    case 1: return _mm256_alignr_epi8(input, before, 15);
+    case 2: return _mm256_alignr_epi8(input, before, 14);
+    default: return _mm256_alignr_epi8(input, before, 13);
+    }
+}
+
+static inline __m256i tam_utf8_block_errors32(__m256i input, __m256i prev_input) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i prev1 = tam_utf8_prev32(input, prev_input, 1);
+    __m256i byte_1_high = _mm256_shuffle_epi8(_mm256_setr_epi8(TAM_UTF8_BYTE_1_HIGH, TAM_UTF8_BYTE_1_HIGH),
+                                              _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(_mm256_setr_epi8(TAM_UTF8_BYTE_1_LOW, TAM_UTF8_BYTE_1_LOW),
+                                             _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(_mm256_setr_epi8(TAM_UTF8_BYTE_2_HIGH, TAM_UTF8_BYTE_2_HIGH),
+                                              _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i prev2 = tam_utf8_prev32(input, prev_input, 2);
+    __m256i prev3 = tam_utf8_prev32(input, prev_input, 3);
+    __m256i is_third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xe0 - 0x80)));
+    __m256i is_fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xf0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must23, special);
+}
+
+static inline __m256i tam_utf8_block_incomplete32(__m256i input) {
+    const __m256i max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xf0 - 1), (char)(0xe0 - 1),
+                                         (char)(0xc0 - 1));
+    return _mm256_subs_epu8(input, max);
+}
+#endif
+
+bool tam_sl_utf8_valid(tam_slice_t s) {
+    const u8 *p = (const u8 *)s.buf;
+    usize n = s.len;
+#if defined(TAM_AVX2)
+    {
+        __m256i error = _mm256_setzero_si256();
+        __m256i prev_input = _mm256_setzero_si256();
+        __m256i prev_incomplete = _mm256_setzero_si256();
+        usize i = 0;
+        // the tail is copied into a zero-padded block, zeros being ASCII
+        for (; i < n; i += 32) {
+            __m256i input;
+            if (i + 32 <= n) {
+                input = _mm256_loadu_si256((const __m256i *)(p + i));
+            } else {
+                u8 tail[32] = {0};
+                memcpy(tail, p + i, n - i);
+                input = _mm256_loadu_si256((const __m256i *)tail);
+            }
+            if (_mm256_movemask_epi8(input) == 0) {
+                // ASCII block: only a sequence left open by the previous block can be an error
+                error = _mm256_or_si256(error, prev_incomplete);
+            } else {
+                error = _mm256_or_si256(error, tam_utf8_block_errors32(input, prev_input));
+                prev_incomplete = tam_utf8_block_incomplete32(input);
+            }
+            prev_input = input;
+        }
+        error = _mm256_or_si256(error, prev_incomplete);
+        return _mm256_testz_si256(error, error);
+    }
+#elif defined(TAM_SSSE3)
+    {
+        __m128i error = _mm_setzero_si128();
+        __m128i prev_input = _mm_setzero_si128();
+        __m128i prev_incomplete = _mm_setzero_si128();
+        usize i = 0;
+        for (; i < n; i += 16) {
+            __m128i input;
+            if (i + 16 <= n) {
+                input = _mm_loadu_si128((const __m128i *)(p + i));
+            } else {
+                u8 tail[16] = {0};
+                memcpy(tail, p + i, n - i);
+                input = _mm_loadu_si128((const __m128i *)tail);
+            }
+            if (_mm_movemask_epi8(input) == 0) {
+                error = _mm_or_si128(error, prev_incomplete);
+            } else {
+                error = _mm_or_si128(error, tam_utf8_block_errors(input, prev_input));
+                prev_incomplete = tam_utf8_block_incomplete(input);
+            }
+            prev_input = input;
+        }
+        error = _mm_or_si128(error, prev_incomplete);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+    }
+#else
+    return tam_utf8_valid_scalar(p, n);
+#endif
+}
+
+int tam_sl_utf8_count(tam_slice_t s) {
+    const u8 *p = (const u8 *)s.buf;
+    usize n = s.len;
+    usize i = 0;
+    usize continuations = 0;
+#if defined(TAM_AVX2)
+    {
+        // continuation bytes are exactly the bytes below -64 as signed chars
+        const __m256i threshold = _mm256_set1_epi8(-64);
+        while (i + 32 <= n) {
+            // per-byte counters can take at most 255 blocks before they have to be summed
+            __m256i counts = _mm256_setzero_si256();
+            for (int k = 0; k < 255 && i + 32 <= n; k++, i += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+                counts = _mm256_sub_epi8(counts, _mm256_cmpgt_epi8(threshold, v));
+            }
+            __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+            continuations += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                             _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+        }
+    }
+#endif
+#if defined(TAM_SSE2)
+    {
+        const __m128i threshold = _mm_set1_epi8(-64);
+        while (i + 16 <= n) {
+            __m128i counts = _mm_setzero_si128();
+            for (int k = 0; k < 255 && i + 16 <= n; k++, i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+                counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(threshold, v));
+            }
+            __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+            continuations += (usize)_mm_cvtsi128_si32(sums) + (usize)_mm_extract_epi16(sums, 4);
+        }
+    }
+#endif
+    // continuation bytes have their top bit set and the next bit clear
+    for (; i + 8 <= n; i += 8) {
+        u64 x = tam_load_u64(p + i);
+        continuations += tam_popcount64(x & ~(x << 1) & TAM_SWAR_HIGHS);
+    }
+    for (; i < n; i++)
+        continuations += (p[i] & 0xc0) == 0x80;
+    return (int)(n - continuations);
+}
+
+// end UTF-8 implementation }}}
+
+// ### ASCII case-insensitive implementation {{{
+
+static inline char tam_ascii_lower(char c) { return (c >= 'A' && c <= 'Z') ? c | 0x20 : c; }
+
+// Flip the case bit of every byte of x in the range [lo, lo + 26), where lo is 'A' or 'a'
+static inline u64 tam_swar_case_flip(u64 x, char lo) {
+    u64 heptets = x & ~TAM_SWAR_HIGHS;
+    // the high bit of each byte is set iff the byte is >= lo, resp. >= lo + 26. Bytes with
+    // the high bit set in x are not ASCII and are left alone.
+    u64 ge_lo = heptets + TAM_SWAR_BYTES(0x80 - lo);
+    u64 ge_hi = heptets + TAM_SWAR_BYTES(0x80 - lo - 26);
+    u64 in_range = (ge_lo ^ ge_hi) & ~x & TAM_SWAR_HIGHS;
+    return x ^ (in_range >> 2);
+}
+
+#if defined(TAM_SSE2)
+static inline __m128i tam_case_flip16(__m128i v, char lo) {
+    // shift [lo, lo + 26) to [-128, -102) so that a single signed comparison finds it
+    __m128i t = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - lo)));
+    __m128i in_range = _mm_cmplt_epi8(t, _mm_set1_epi8(-128 + 26));
+    return _mm_xor_si128(v, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+#endif
+
+#if defined(TAM_AVX2)
+static inline __m256i tam_case_flip32(__m256i v, char lo) {
+    __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - lo)));
+    __m256i in_range = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), t);
+    return _mm256_xor_si256(v, _mm256_and_si256(in_range, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+// Compare n bytes of a and b, ignoring ASCII case
+static bool tam_ascii_eq_nocase(const char *a, const char *b, usize n) {
+    usize i = 0;
+#if defined(TAM_AVX2)
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = tam_case_flip32(_mm256_loadu_si256((const __m256i *)(a + i)), 'A');
+        __m256i vb = tam_case_flip32(_mm256_loadu_si256((const __m256i *)(b + i)), 'A');
+        if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0xffffffffu)
+            return false;
+    }
+#endif
+#if defined(TAM_SSE2)
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = tam_case_flip16(_mm_loadu_si128((const __m128i *)(a + i)), 'A');
+        __m128i vb = tam_case_flip16(_mm_loadu_si128((const __m128i *)(b + i)), 'A');
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff)
+            return false;
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        if (tam_swar_case_flip(tam_load_u64(a + i), 'A') != tam_swar_case_flip(tam_load_u64(b + i), 'A'))
+            return false;
+    }
+    for (; i < n; i++) {
+        if (tam_ascii_lower(a[i]) != tam_ascii_lower(b[i]))
+            return false;
+    }
+    return true;
+}
+
+// Copy n bytes from src to dst, flipping the case of the letters in [lo, lo + 26)
+static void tam_ascii_case_map(char *dst, const char *src, usize n, char lo) {
+    usize i = 0;
+#if defined(TAM_AVX2)
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), tam_case_flip32(v, lo));
+    }
+#endif
+#if defined(TAM_SSE2)
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), tam_case_flip16(v, lo));
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        u64 x = tam_swar_case_flip(tam_load_u64(src + i), lo);
+        memcpy(dst + i, &x, sizeof(x));
+    }
+    for (; i < n; i++) {
+        char c = src[i];
+        dst[i] = (c >= lo && c < lo + 26) ? c ^ 0x20 : c;
+    }
+}
+
+bool tam_sl_eq_nocase(tam_slice_t s1, tam_slice_t s2) {
+    if (s1.len != s2.len)
+        return false;
+    if (s1.buf == s2.buf)
+        return true;
+    return tam_ascii_eq_nocase(s1.buf, s2.buf, s1.len);
+}
+
+bool tam_sl_startswith_nocase(tam_slice_t s, tam_slice_t x) {
+    return x.len <= s.len && tam_ascii_eq_nocase(s.buf, x.buf, x.len);
+}
+
+int tam_sl_find_nocase(tam_slice_t haystack, tam_slice_t needle) {
+    int n = haystack.len;
+    int m = needle.len;
+    if (m == 0)
+        return 0;
+    if (m > n)
+        return n;
+    const char *h = haystack.buf;
+    char first = tam_ascii_lower(needle.buf[0]);
+    char last = tam_ascii_lower(needle.buf[m - 1]);
+    int pos = 0;
+    // test 16 or 32 candidate positions at once: a match has to agree with the needle in its first
+    // and last byte, and only positions that do are compared in full
+#if defined(TAM_AVX2)
+    const __m256i first32 = _mm256_set1_epi8(first);
+    const __m256i last32 = _mm256_set1_epi8(last);
+    for (; pos + m - 1 + 32 <= n; pos += 32) {
+        __m256i a = tam_case_flip32(_mm256_loadu_si256((const __m256i *)(h + pos)), 'A');
+        __m256i b = tam_case_flip32(_mm256_loadu_si256((const __m256i *)(h + pos + m - 1)), 'A');
+        u32 mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first32), _mm256_cmpeq_epi8(b, last32)));
+        for (; mask != 0; mask &= mask - 1) {
+            int i = pos + tam_ctz32(mask);
+            if (tam_ascii_eq_nocase(h + i + 1, needle.buf + 1, m - 1))
+                return i;
+        }
+    }
+#endif
+#if defined(TAM_SSE2)
+    const __m128i first16 = _mm_set1_epi8(first);
+    const __m128i last16 = _mm_set1_epi8(last);
+    for (; pos + m - 1 + 16 <= n; pos += 16) {
+        __m128i a = tam_case_flip16(_mm_loadu_si128((const __m128i *)(h + pos)), 'A');
+        __m128i b = tam_case_flip16(_mm_loadu_si128((const __m128i *)(h + pos + m - 1)), 'A');
+        u32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first16), _mm_cmpeq_epi8(b, last16)));
+        for (; mask != 0; mask &= mask - 1) {
+            int i = pos + tam_ctz32(mask);
+            if (tam_ascii_eq_nocase(h + i + 1, needle.buf + 1, m - 1))
+                return i;
+        }
+    }
+#endif
+    for (; pos <= n - m; pos++) {
+        if (tam_ascii_lower(h[pos]) == first && tam_ascii_eq_nocase(h + pos + 1, needle.buf + 1, m - 1))
+            return pos;
+    }
+    return n;
+}
+
+void tam_sl_tolower(char *dst, tam_slice_t s) { tam_ascii_case_map(dst, s.buf, s.len, 'A'); }
+
+void tam_sl_toupper(char *dst, tam_slice_t s) { tam_ascii_case_map(dst, s.buf, s.len, 'a'); }
+
+// end ASCII case-insensitive implementation }}}
+
+// ### Numeric parsing implementation {{{
+
+// Parse the digits of s starting at *i into *x, advancing *i. Returns false on overflow.
+static bool tam_sl_parse_digits(tam_slice_t s, int *i, u64 *x) {
+    u64 v = 0;
+    int j = *i;
+    for (; j < s.len && (u8)(s.buf[j] - '0') < 10; j++) {
+        u64 d = s.buf[j] - '0';
+        if (v > (UINT64_MAX - d) / 10)
+            return false;
+        v = v * 10 + d;
+    }
+    *i = j;
+    *x = v;
+    return true;
+}
+
+bool tam_sl_parse_u64(tam_slice_t s, u64 *out) {
+    int i = s.len > 0 && s.buf[0] == '+';
+    int start = i;
+    if (!tam_sl_parse_digits(s, &i, out))
+        return false;
+    return i > start && i == s.len;
+}
+
+bool tam_sl_parse_i64(tam_slice_t s, i64 *out) {
+    bool negative = s.len > 0 && s.buf[0] == '-';
+    int i = s.len > 0 && (s.buf[0] == '-' || s.buf[0] == '+');
+    int start = i;
+    u64 x;
+    if (!tam_sl_parse_digits(s, &i, &x) || i == start || i != s.len)
+        return false;
+    if (negative) {
+        if (x > (u64)INT64_MAX + 1)
+            return false;
+        *out = (i64)(0 - x);
+    } else {
+        if (x > INT64_MAX)
+            return false;
+        *out = (i64)x;
+    }
+    return true;
+}
+
+bool tam_sl_parse_f64(tam_slice_t s, f64 *out) {
+    // powers of ten that are exactly representable as doubles
+    static const f64 pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    int i = 0;
+    bool negative = false;
+    if (i < s.len && (s.buf[i] == '-' || s.buf[i] == '+'))
+        negative = s.buf[i++] == '-';
+
+    // validate, and collect up to 19 significant digits in the mantissa
+    u64 mantissa = 0;
+    int digits = 0;
+    int any_digits = 0;
+    int exp10 = 0;
+    bool dot = false;
+    for (; i < s.len; i++) {
+        char c = s.buf[i];
+        if ((u8)(c - '0') < 10) {
+            any_digits++;
+            if (mantissa == 0 && c == '0') {
+                // leading zeros are not significant
+            } else if (digits < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+                digits++;
+            } else {
+                // digits beyond the 19th only matter for rounding, which strtod takes care of
+                digits++;
+                exp10++;
+            }
+            if (dot)
+                exp10--;
+        } else if (c == '.' && !dot) {
+            dot = true;
+        } else {
+            break;
+        }
+    }
+    if (any_digits == 0)
+        return false;
+    if (i < s.len && (s.buf[i] == 'e' || s.buf[i] == 'E')) {
+        i++;
+        bool exp_negative = false;
+        if (i < s.len && (s.buf[i] == '-' || s.buf[i] == '+'))
+            exp_negative = s.buf[i++] == '-';
+        int start = i;
+        int e = 0;
+        for (; i < s.len && (u8)(s.buf[i] - '0') < 10; i++) {
+            if (e < 100000)
+                e = e * 10 + (s.buf[i] - '0');
+        }
+        if (i == start)
+            return false;
+        exp10 += exp_negative ? -e : e;
+    }
+    if (i != s.len)
+        return false;
+
+    // Clinger's fast path: both the mantissa and the power of ten are exact, so one operation rounds correctly
+    if (digits <= 15 && exp10 >= -22 && exp10 <= 22) {
+        f64 x = (f64)mantissa;
+        x = exp10 < 0 ? x / pow10[-exp10] : x * pow10[exp10];
+        *out = negative ? -x : x;
+        return true;
+    }
+
+    // otherwise let strtod round, on a null-terminated copy
+    char small[64];
+    char *buf = s.len < (int)sizeof(small) ? small : tam_allocate(char, s.len + 1);
+    memcpy(buf, s.buf, s.len);
+    buf[s.len] = '\0';
+    *out = strtod(buf, NULL);
+    if (buf != small)
+        tam_deallocate(buf);
+    return true;
+}
+
+// end numeric parsing implementation }}}
+
+// ### Timestamp parsing implementation {{{
+
+#define TAM_NS_PER_SEC 1000000000ll
+// timestamps in nanoseconds only fit in an i64 for about 292 years either side of the epoch
+#define TAM_MAX_EPOCH_SECS (INT64_MAX / TAM_NS_PER_SEC - 1)
+
+// Check that the bytes of x selected by `digits` are ASCII digits, and that the others equal those of `seps`
+static inline bool tam_swar_check_digits(u64 x, u64 digits, u64 seps) {
+    // a digit has high nibble 3 and a low nibble that doesn't carry into the high nibble when 6 is added
+    u64 d = x & digits;
+    bool ok_digits = (d & TAM_SWAR_BYTES(0xf0) & digits) == (TAM_SWAR_BYTES(0x30) & digits) &&
+                     ((d + TAM_SWAR_BYTES(0x06)) & TAM_SWAR_BYTES(0xf0) & digits) == (TAM_SWAR_BYTES(0x30) & digits);
+    return ok_digits && (x & ~digits) == seps;
+}
+
+// Combine adjacent digits into two-digit numbers: byte i of the result is 10 * digit i + digit i + 1
+static inline u64 tam_swar_digit_pairs(u64 x) {
+    x &= TAM_SWAR_BYTES(0x0f);
+    return x * 10 + (x >> 8);
+}
+
+// byte i of a little-endian word
+#define TAM_BYTE(x, i) ((int)(((x) >> (8 * (i))) & 0xff))
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar (Howard Hinnant's days_from_civil)
+static i64 tam_days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    i64 era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static bool tam_valid_date(int y, int m, int d) {
+    static const u8 days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m < 1 || m > 12 || d < 1)
+        return false;
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return d <= days_in_month[m - 1] + (m == 2 && leap);
+}
+
+// The date part of the last timestamp parsed on this thread, as raw text, and its day number
+typedef struct tam_date_cache_t {
+    u64 key;
+    u32 key_tail;
+    bool valid;
+    i64 days;
+} tam_date_cache_t;
+
+static _Thread_local tam_date_cache_t tam_iso8601_date_cache;
+static _Thread_local tam_date_cache_t tam_clf_date_cache;
+
+// Parse `HH:MM:SS` at p into seconds since midnight, or -1
+static int tam_parse_hhmmss(const char *p) {
+    u64 x = tam_load_u64(p);
+    if (!tam_swar_check_digits(x, 0xffff00ffff00ffffull, 0x00003a00003a0000ull))
+        return -1;
+    u64 v = tam_swar_digit_pairs(x);
+    int h = TAM_BYTE(v, 0), m = TAM_BYTE(v, 3), sec = TAM_BYTE(v, 6);
+    // allow a leap second
+    if (h > 23 || m > 59 || sec > 60)
+        return -1;
+    return h * 3600 + m * 60 + sec;
+}
+
+// Parse two digits at p, or -1
+static int tam_parse_2digits(const char *p) {
+    if ((u8)(p[0] - '0') > 9 || (u8)(p[1] - '0') > 9)
+        return -1;
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+bool tam_sl_parse_iso8601(tam_slice_t s, i64 *ns) {
+    // the shortest form is YYYY-MM-DDTHH:MM:SS
+    if (s.len < 19)
+        return false;
+    const char *p = s.buf;
+
+    // date
+    u64 date = tam_load_u64(p);
+    u32 date_tail = 0;
+    memcpy(&date_tail, p + 8, 2);
+    tam_date_cache_t *cache = &tam_iso8601_date_cache;
+    i64 days;
+    if (cache->valid && cache->key == date && cache->key_tail == date_tail) {
+        days = cache->days;
+    } else {
+        // YYYY-MM-
+        if (!tam_swar_check_digits(date, 0x00ffff00ffffffffull, 0x2d00002d00000000ull))
+            return false;
+        u64 v = tam_swar_digit_pairs(date);
+        int year = TAM_BYTE(v, 0) * 100 + TAM_BYTE(v, 2);
+        int month = TAM_BYTE(v, 5);
+        int day = tam_parse_2digits(p + 8);
+        if (day < 0 || !tam_valid_date(year, month, day))
+            return false;
+        days = tam_days_from_civil(year, month, day);
+        *cache = (tam_date_cache_t){date, date_tail, true, days};
+    }
+
+    // time
+    if (p[10] != 'T' && p[10] != 't' && p[10] != ' ')
+        return false;
+    int secs = tam_parse_hhmmss(p + 11);
+    if (secs < 0)
+        return false;
+    i64 t = days * 86400 + secs;
+    if (t < -TAM_MAX_EPOCH_SECS || t > TAM_MAX_EPOCH_SECS)
+        return false;
+    t *= TAM_NS_PER_SEC;
+
+    int i = 19;
+    if (i < s.len && (s.buf[i] == '.' || s.buf[i] == ',')) {
+        i++;
+        int start = i;
+        i64 frac = 0;
+        for (; i < s.len && (u8)(s.buf[i] - '0') < 10; i++) {
+            if (i - start < 9)
+                frac = frac * 10 + (s.buf[i] - '0');
+        }
+        int digits = i - start;
+        if (digits == 0)
+            return false;
+        for (; digits < 9; digits++)
+            frac *= 10;
+        t += frac;
+    }
+
+    // offset
+    if (i < s.len && (s.buf[i] == 'Z' || s.buf[i] == 'z')) {
+        i++;
+    } else if (i < s.len && (s.buf[i] == '+' || s.buf[i] == '-')) {
+        int sign = s.buf[i] == '-' ? -1 : 1;
+        int hours = i + 3 <= s.len ? tam_parse_2digits(s.buf + i + 1) : -1;
+        if (hours < 0 || hours > 23)
+            return false;
+        i += 3;
+        int minutes = 0;
+        if (i < s.len) {
+            i += s.buf[i] == ':';
+            minutes = i + 2 <= s.len ? tam_parse_2digits(s.buf + i) : -1;
+            if (minutes < 0 || minutes > 59)
+                return false;
+            i += 2;
+        }
+        // local time = UTC + offset
+        i64 offset = sign * (hours * 3600 + minutes * 60) * TAM_NS_PER_SEC;
+        if ((offset > 0 && t < INT64_MIN + offset) || (offset < 0 && t > INT64_MAX + offset))
+            return false;
+        t -= offset;
+    }
+    if (i != s.len)
+        return false;
+    *ns = t;
+    return true;
+}
+
+bool tam_sl_parse_clf_time(tam_slice_t s, i64 *ns) {
+    if (s.len >= 2 && s.buf[0] == '[' && s.buf[s.len - 1] == ']')
+        s = tam_slice_n(s.buf + 1, s.len - 2);
+    // DD/Mon/YYYY:HH:MM:SS +HHMM
+    if (s.len != 26)
+        return false;
+    const char *p = s.buf;
+
+    // date
+    // DD/Mon/YYYY:
+    u64 date = tam_load_u64(p);
+    u32 date_tail;
+    memcpy(&date_tail, p + 8, 4);
+    tam_date_cache_t *cache = &tam_clf_date_cache;
+    i64 days;
+    if (cache->valid && cache->key == date && cache->key_tail == date_tail) {
+        days = cache->days;
+    } else {
+        static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        int day = tam_parse_2digits(p);
+        int year_hi = tam_parse_2digits(p + 7);
+        int year_lo = tam_parse_2digits(p + 9);
+        if (day < 0 || year_hi < 0 || year_lo < 0 || p[2] != '/' || p[6] != '/' || p[11] != ':')
+            return false;
+        int month = 0;
+        while (month < 12 && memcmp(months + 3 * month, p + 3, 3) != 0)
+            month++;
+        int year = year_hi * 100 + year_lo;
+        if (!tam_valid_date(year, month + 1, day))
+            return false;
+        days = tam_days_from_civil(year, month + 1, day);
+        *cache = (tam_date_cache_t){date, date_tail, true, days};
+    }
+
+    int secs = tam_parse_hhmmss(p + 12);
+    if (secs < 0 || p[20] != ' ' || (p[21] != '+' && p[21] != '-'))
+        return false;
+    int hours = tam_parse_2digits(p + 22);
+    int minutes = tam_parse_2digits(p + 24);
+    if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59)
+        return false;
+    int offset = (hours * 3600 + minutes * 60) * (p[21] == '-' ? -1 : 1);
+    i64 t = days * 86400 + secs - offset;
+    if (t < -TAM_MAX_EPOCH_SECS || t > TAM_MAX_EPOCH_SECS)
+        return false;
+    *ns = t * TAM_NS_PER_SEC;
+    return true;
+}
+
+// end timestamp parsing implementation }}}
+
 #if defined(TAM_INCLUDE_TESTS)
 
 // ### Slice tests {{{
@@ -405,6 +1420,7 @@ int tam_test_slices() {
         assert(tam_sl_idx(hello, 4) == 'o');
         assert(tam_sl_idx(hello, -1) == 'o');
         assert(tam_sl_idx(hello, -2) == 'l');
+        assert(tam_sl_at(hello, 0) == 'H' && tam_sl_at(hello, 4) == 'o');
         assert(hello.len == 5);
         assert(tam_sl_eqstr(hello, "Hello"));
 
@@ -433,6 +1449,13 @@ int tam_test_slices() {
         assert(!tam_sl_eq(llo3, tam_slice("ll")));
         assert(!tam_sl_eq(llo3, tam_slice("llo3")));
 
+        // ordering
+        assert(tam_sl_cmp(llo, llo3) == 0);
+        assert(tam_sl_cmp(tam_slice("ll"), llo3) < 0 && tam_sl_cmp(llo3, tam_slice("ll")) > 0);
+        assert(tam_sl_cmp(llo3, tam_slice("lm")) < 0);
+        assert(tam_sl_cmp(tam_slice("a\x80"), tam_slice("a\x7f")) > 0);
+        assert(tam_sl_cmp(tam_slice(""), tam_slice_n((const char *)NULL, 0)) == 0);
+
         // finding chars and tokenizing
         assert(tam_sl_cspan(s1, ",") == 5);
         assert(tam_sl_cspan(s1, "0") == s1.len);
@@ -473,6 +1496,30 @@ int tam_test_slices() {
         assert(tam_sl_eq(sl4, tam_slice_lstrip(sl3)));
         assert(tam_sl_eq(sl4, tam_slice_rstrip(sl2)));
     }
+    {
+        // stripping long runs of whitespace, which take the vector path
+        char buf[128];
+        const char ws[] = " \t\n\v\f\r";
+        for (int lead = 0; lead < 50; lead += 7) {
+            for (int trail = 0; trail < 50; trail += 5) {
+                int n = 0;
+                for (int i = 0; i < lead; i++)
+                    buf[n++] = ws[i % 6];
+                memcpy(buf + n, "x \xa0 y", 5);
+                n += 5;
+                for (int i = 0; i < trail; i++)
+                    buf[n++] = ws[(i + 3) % 6];
+                tam_slice_t sl = tam_slice_n(buf, n);
+                assert(tam_sl_lstrip(&sl) == lead);
+                assert(tam_sl_rstrip(&sl) == 5);
+                assert(tam_sl_eq(sl, tam_slice("x \xa0 y")));
+            }
+        }
+        memset(buf, ' ', 100);
+        tam_slice_t blank = tam_slice_n(buf, 100);
+        assert(tam_sl_strip(&blank) == 100 && blank.len == 0);
+        assert(tam_sl_rstrip(&blank) == 0);
+    }
     {
         // Tokenizing
         const char *sentence = "a few words to check, with punctuation.";
@@ -514,6 +1561,157 @@ int tam_test_slices() {
         assert(tam_sl_findstr(sl, "\0") == 0);
         assert(tam_sl_findstr(sl, "") == 0);
     }
+    {
+        // UTF-8
+        assert(tam_sl_utf8_valid(tam_slice("")));
+        assert(tam_sl_utf8_valid(tam_slice("plain ascii")));
+        const char *mixed = "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf \xed\x9f\xbf \xee\x80\x80";
+        assert(tam_sl_utf8_valid(tam_slice(mixed)));
+        assert(tam_sl_utf8_count(tam_slice(mixed)) == 14);
+
+        const char *invalid[] = {
+            "\x80",             // stray continuation
+            "\xc3",             // truncated
+            "\xc0\xaf",         // overlong 2 byte
+            "\xe0\x80\xaf",     // overlong 3 byte
+            "\xf0\x80\x80\xaf", // overlong 4 byte
+            "\xed\xa0\x80",     // surrogate
+            "\xf4\x90\x80\x80", // above U+10FFFF
+            "\xf8\x88\x80\x80", // 5 byte lead
+            "\xe2\x82",         // truncated 3 byte
+            "\xe2\x28\xa1",     // bad continuation
+        };
+        // place each invalid sequence at every offset of a long ascii/multibyte string
+        char buf[128];
+        for (usize k = 0; k < sizeof(invalid) / sizeof(invalid[0]); k++) {
+            int len = strlen(invalid[k]);
+            assert(!tam_sl_utf8_valid(tam_slice(invalid[k])));
+            for (int off = 2; off + len <= 100; off++) {
+                for (int i = 0; i < 100; i++)
+                    buf[i] = 'a' + i % 26;
+                memcpy(buf, "\xc3\xa9", 2);
+                memcpy(buf + off, invalid[k], len);
+                assert(!tam_sl_utf8_valid(tam_slice_n(buf, 100)));
+            }
+        }
+
+        // long valid input, with codepoints straddling every block boundary
+        int count = 0;
+        int n = 0;
+        char big[4096];
+        const char *cps[] = {"a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80"};
+        for (int i = 0; n + 4 <= (int)sizeof(big); i++) {
+            const char *cp = cps[(i * 7 / 3) % 4];
+            memcpy(big + n, cp, strlen(cp));
+            n += strlen(cp);
+            count++;
+        }
+        assert(tam_sl_utf8_valid(tam_slice_n(big, n)));
+        assert(tam_sl_utf8_count(tam_slice_n(big, n)) == count);
+        assert(!tam_sl_utf8_valid(tam_slice_n(big, n - 1)) || (big[n - 1] & 0xc0) != 0x80);
+    }
+    {
+        // ASCII case-insensitive functions
+        assert(tam_sl_eq_nocase(tam_slice("Content-Type"), tam_slice("content-type")));
+        assert(!tam_sl_eq_nocase(tam_slice("Content-Type"), tam_slice("content-typo")));
+        assert(!tam_sl_eq_nocase(tam_slice("Content-Type"), tam_slice("content-type ")));
+        // only letters fold: '@' and '`' differ from 'A' and 'a' in the case bit but are not letters
+        assert(!tam_sl_eq_nocase(tam_slice("@[\\]^"), tam_slice("`{|}~")));
+        assert(!tam_sl_eq_nocase(tam_slice("\xc3\xa9"), tam_slice("\xe3\xa9")));
+
+        const char *a = "The Quick Brown Fox Jumps Over The Lazy Dog, 0123456789 [brackets] @home `ticks`";
+        const char *b = "tHE qUICK bROWN fOX jUMPS oVER tHE lAZY dOG, 0123456789 [BRACKETS] @HOME `TICKS`";
+        assert(tam_sl_eq_nocase(tam_slice(a), tam_slice(b)));
+        assert(tam_sl_startswith_nocase(tam_slice(a), tam_slice("the QUICK")));
+        assert(!tam_sl_startswith_nocase(tam_slice("the"), tam_slice("the QUICK")));
+
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("LAZY dog")) == 35);
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("@HOME")) == 67);
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("`TICKS`")) == 73);
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("t")) == 0);
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("cat")) == (int)strlen(a));
+        assert(tam_sl_find_nocase(tam_slice("short"), tam_slice("much longer")) == 5);
+        assert(tam_sl_find_nocase(tam_slice(a), tam_slice("")) == 0);
+
+        // find agrees with a lowercased copy and the case-sensitive find at every position
+        char lower[100];
+        int n = strlen(b);
+        tam_sl_tolower(lower, tam_slice_n(b, n));
+        for (int i = 0; i < n; i++) {
+            for (int len = 1; i + len <= n && len < 20; len++) {
+                int expected = tam_sl_find(tam_slice_n(lower, n), tam_slice_n(lower + i, len));
+                assert(tam_sl_find_nocase(tam_slice_n(a, n), tam_slice_n(b + i, len)) == expected);
+            }
+        }
+
+        // case conversion, in place and into another buffer
+        char upper[100];
+        tam_sl_toupper(upper, tam_slice_n(lower, n));
+        assert(tam_sl_eq(tam_slice_n(upper, n), tam_slice("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, 0123456789 "
+                                                          "[BRACKETS] @HOME `TICKS`")));
+        tam_sl_tolower(upper, tam_slice_n(upper, n));
+        assert(tam_sl_eq(tam_slice_n(upper, n), tam_slice_n(lower, n)));
+        assert(tam_sl_eq(tam_slice_n(lower, n), tam_slice("the quick brown fox jumps over the lazy dog, 0123456789 "
+                                                          "[brackets] @home `ticks`")));
+    }
+    {
+        // numeric parsing
+        i64 i;
+        u64 u;
+        f64 x;
+        assert(tam_sl_parse_i64(tam_slice("-9223372036854775808"), &i) && i == INT64_MIN);
+        assert(tam_sl_parse_i64(tam_slice("+9223372036854775807"), &i) && i == INT64_MAX);
+        assert(!tam_sl_parse_i64(tam_slice("9223372036854775808"), &i));
+        assert(tam_sl_parse_u64(tam_slice("18446744073709551615"), &u) && u == UINT64_MAX);
+        assert(!tam_sl_parse_u64(tam_slice("18446744073709551616"), &u));
+        assert(!tam_sl_parse_u64(tam_slice("-1"), &u));
+        assert(!tam_sl_parse_i64(tam_slice(""), &i) && !tam_sl_parse_i64(tam_slice("-"), &i));
+        assert(!tam_sl_parse_i64(tam_slice(" 1"), &i) && !tam_sl_parse_i64(tam_slice("12a"), &i));
+        // parsing stops at the end of the slice, not at a null terminator
+        assert(tam_sl_parse_i64(tam_slice_n("12345", 3), &i) && i == 123);
+
+        const char *floats[] = {"0",     "-0.0",  "3.14159", "1e10",  "2.5E-3",    "-1.7976931348623157e308",
+                                "5e-324", ".5",   "5.",      "1e400", "123456789012345678901234567890",
+                                "0.1000000000000000055511151231257827021181583404541015625"};
+        for (usize k = 0; k < sizeof(floats) / sizeof(floats[0]); k++) {
+            assert(tam_sl_parse_f64(tam_slice(floats[k]), &x));
+            assert(x == strtod(floats[k], NULL));
+        }
+        assert(!tam_sl_parse_f64(tam_slice("."), &x) && !tam_sl_parse_f64(tam_slice("1e"), &x));
+        assert(!tam_sl_parse_f64(tam_slice("1.2.3"), &x) && !tam_sl_parse_f64(tam_slice("nan"), &x));
+    }
+    {
+        // timestamps
+        i64 t;
+        assert(tam_sl_parse_iso8601(tam_slice("1970-01-01T00:00:00Z"), &t) && t == 0);
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15T12:34:56.789Z"), &t) && t == 1792067696789000000ll);
+        // same day, so the cached date is used
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15 12:34:57"), &t) && t == 1792067697000000000ll);
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15T14:34:56.789+02:00"), &t) && t == 1792067696789000000ll);
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15T07:04:56.789-0530"), &t) && t == 1792067696789000000ll);
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15T12:34:56.123456789Z"), &t) && t == 1792067696123456789ll);
+        assert(tam_sl_parse_iso8601(tam_slice("2026-10-15T12:34:56.1234567891Z"), &t) && t == 1792067696123456789ll);
+        assert(tam_sl_parse_iso8601(tam_slice("1969-12-31T23:59:59.5Z"), &t) && t == -500000000ll);
+        assert(tam_sl_parse_iso8601(tam_slice("2024-02-29T00:00:00+01"), &t) && t == 1709161200000000000ll);
+
+        const char *bad_iso[] = {"2026-10-15",           "2026-10-15T12:34",     "2026/10/15T12:34:56",
+                                 "2026-13-01T00:00:00",  "2026-02-29T00:00:00",  "2026-04-31T00:00:00",
+                                 "2026-10-15T24:00:00",  "2026-10-15T12:60:00",  "2026-10-15T12:34:56.",
+                                 "2026-10-15T12:34:56Q", "2026-10-15T12:34:56+2", "2026-10-15X12:34:56",
+                                 "2026-1a-15T12:34:56",  "2026-10-15T12:34:56Z ", "2026-10-15T1:34:56Z"};
+        for (usize k = 0; k < sizeof(bad_iso) / sizeof(bad_iso[0]); k++)
+            assert(!tam_sl_parse_iso8601(tam_slice(bad_iso[k]), &t));
+        // an invalid time after a cached date is still rejected
+        assert(!tam_sl_parse_iso8601(tam_slice("2026-10-15T12:34:5x"), &t));
+
+        assert(tam_sl_parse_clf_time(tam_slice("10/Oct/2000:13:55:36 -0700"), &t) && t == 971211336000000000ll);
+        assert(tam_sl_parse_clf_time(tam_slice("[10/Oct/2000:20:55:36 +0000]"), &t) && t == 971211336000000000ll);
+        assert(tam_sl_parse_clf_time(tam_slice("10/Oct/2001:13:55:36 -0700"), &t) && t == 1002747336000000000ll);
+        assert(!tam_sl_parse_clf_time(tam_slice("10/Oct/2000:13:55:36"), &t));
+        assert(!tam_sl_parse_clf_time(tam_slice("31/Sep/2000:13:55:36 -0700"), &t));
+        assert(!tam_sl_parse_clf_time(tam_slice("10/Foo/2000:13:55:36 -0700"), &t));
+        assert(!tam_sl_parse_clf_time(tam_slice("10/Oct/2000 13:55:36 -0700"), &t));
+    }
     printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
     return 0;
 }
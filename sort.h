@@ -0,0 +1,1205 @@
+#ifndef TAM_SORT_H
+#define TAM_SORT_H
+
+// TAM sorting
+//
+// Sorts specialized for arrays of slices and of numbers, which avoid the indirect comparator calls of qsort.
+
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Sort declarations *** {{{
+
+/*
+ * Sort an array of slices in place, in the order of `sl_cmp`.
+ * This is a multikey quicksort that partitions on 8 bytes at a time: the next 8 bytes of every slice are
+ * cached as a big-endian integer in a side array, so partitioning compares integers in one sequential array
+ * instead of chasing a pointer per comparison, and each slice is only read again when its group of equal
+ * prefixes moves on to the next 8 bytes.
+ */
+void tam_sort_slices(tam_slice_t *a, usize n);
+
+/*
+ * Sort an array of slices stably, so that slices with equal contents keep their order.
+ * This is an MSD radix sort, which caches the byte that each pass sorts on in a side array.
+ * It allocates space for a copy of the array.
+ */
+void tam_sort_slices_stable(tam_slice_t *a, usize n);
+
+/*
+ * Sort an array of slices with `nthreads` threads (one per online CPU if `nthreads` is 0), stably if `stable`.
+ * This is a sample sort: splitters picked from a sample divide the slices into one bucket per thread, the
+ * threads move the slices into their buckets in parallel, and then sort one bucket each.
+ * Small arrays are sorted on the calling thread.
+ * Uses pthreads on POSIX systems (link with -pthread), and sorts serially elsewhere.
+ */
+void tam_sort_slices_parallel(tam_slice_t *a, usize n, int nthreads, bool stable);
+
+/*
+ * Sort an array of numbers in place, in ascending order.
+ * The sort is a quicksort, which partitions a vector of keys at a time when AVX2 is available and falls back to
+ * a heapsort if its pivots are bad. Ranges of up to 16 keys are finished with a sorting network (with AVX2) or an
+ * insertion sort, and ranges of TAM_SORT_RADIX_MIN to TAM_SORT_RADIX_MAX keys, which fit in cache, with an LSD radix
+ * sort that skips the passes over bytes that all keys share. Its scratch buffer holds at most TAM_SORT_RADIX_MAX
+ * keys, and is allocated once per call.
+ * Floats are ordered by sign and then magnitude, so -0.0 comes before 0.0 and NaNs go first or last depending on
+ * their sign bit. They are sorted as integer keys in a temporary array, which takes as much memory as the input.
+ */
+void tam_sort_i32(i32 *a, usize n);
+void tam_sort_u32(u32 *a, usize n);
+void tam_sort_i64(i64 *a, usize n);
+void tam_sort_u64(u64 *a, usize n);
+void tam_sort_f32(f32 *a, usize n);
+void tam_sort_f64(f64 *a, usize n);
+
+/*
+ * Sort `keys` in place stably, in the same order as above, and move `values` along with them.
+ * Filling `values` with 0, 1, ..., n - 1 first gives the permutation that sorts the keys (an argsort).
+ */
+void tam_sort_i32_kv(i32 *keys, u32 *values, usize n);
+void tam_sort_u32_kv(u32 *keys, u32 *values, usize n);
+void tam_sort_i64_kv(i64 *keys, u32 *values, usize n);
+void tam_sort_u64_kv(u64 *keys, u32 *values, usize n);
+void tam_sort_f32_kv(f32 *keys, u32 *values, usize n);
+void tam_sort_f64_kv(f64 *keys, u32 *values, usize n);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_SORT) ///{{{
+#define sort_slices tam_sort_slices
+#define sort_slices_stable tam_sort_slices_stable
+#define sort_slices_parallel tam_sort_slices_parallel
+#define sort_i32 tam_sort_i32
+#define sort_u32 tam_sort_u32
+#define sort_i64 tam_sort_i64
+#define sort_u64 tam_sort_u64
+#define sort_f32 tam_sort_f32
+#define sort_f64 tam_sort_f64
+#define sort_i32_kv tam_sort_i32_kv
+#define sort_u32_kv tam_sort_u32_kv
+#define sort_i64_kv tam_sort_i64_kv
+#define sort_u64_kv tam_sort_u64_kv
+#define sort_f32_kv tam_sort_f32_kv
+#define sort_f64_kv tam_sort_f64_kv
+#endif // end sort namespace }}}
+
+// end sort declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_SORT_IMPLEMENTATION)
+
+#include <assert.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// ### Slice sorts {{{
+
+// ranges of this many slices or fewer are insertion sorted
+#define TAM_SORT_SLICES_SMALL 16
+
+// a range of an array still to sort, whose slices share their first `depth` bytes
+typedef struct tam_sort_range_t {
+    usize lo;
+    usize n;
+    int depth;
+} tam_sort_range_t;
+
+static void tam_sort_push(tam_sort_range_t **stack, usize *len, usize *cap, usize lo, usize n, int depth) {
+    if (*len == *cap) {
+        usize newcap = tam_grow_capacity(*cap, *len + 1);
+        *stack = tam_reallocate_sized(*stack, tam_sort_range_t, *cap, newcap);
+        *cap = newcap;
+    }
+    (*stack)[(*len)++] = (tam_sort_range_t){lo, n, depth};
+}
+
+// The 8 bytes of `s` starting at `depth`, padded with zeros, as a big-endian integer.
+// Slices with different keys compare like their keys. With equal keys, a slice that ends within the 8 bytes
+// is a prefix of any longer one.
+static inline u64 tam_slice_key(tam_slice_t s, int depth) {
+    int rest = s.len - depth;
+    if (rest >= 8)
+        return tam_load_be64(s.buf + depth);
+    u8 buf[8] = {0};
+    if (rest > 0)
+        memcpy(buf, s.buf + depth, rest);
+    return tam_load_be64(buf);
+}
+
+// Compare two slices that share their first `depth` bytes
+static inline int tam_slice_cmp_from(tam_slice_t a, tam_slice_t b, int depth) {
+    return tam_sl_cmp(tam_slice_n(a.buf + depth, a.len - depth), tam_slice_n(b.buf + depth, b.len - depth));
+}
+
+// Stable insertion sort of slices sharing their first `depth` bytes, whose keys at `depth` are in `keys`
+static void tam_sort_slices_insertion(tam_slice_t *a, u64 *keys, usize n, int depth) {
+    for (usize i = 1; i < n; i++) {
+        tam_slice_t s = a[i];
+        u64 k = keys[i];
+        usize j = i;
+        for (; j > 0 && (keys[j - 1] > k || (keys[j - 1] == k && tam_slice_cmp_from(a[j - 1], s, depth) > 0)); j--) {
+            a[j] = a[j - 1];
+            keys[j] = keys[j - 1];
+        }
+        a[j] = s;
+        keys[j] = k;
+    }
+}
+
+static inline u64 tam_median3_u64(u64 a, u64 b, u64 c) {
+    if (a > b) {
+        u64 t = a;
+        a = b;
+        b = t;
+    }
+    return c <= a ? a : c >= b ? b : c;
+}
+
+static void tam_sort_slices_mkqs(tam_slice_t *a, u64 *keys, usize n) {
+    for (usize i = 0; i < n; i++)
+        keys[i] = tam_slice_key(a[i], 0);
+    // an explicit stack, since the depth of the recursion grows with the length of common prefixes
+    tam_sort_range_t *stack = NULL;
+    usize sp = 0, cap = 0;
+    tam_sort_push(&stack, &sp, &cap, 0, n, 0);
+    while (sp > 0) {
+        tam_sort_range_t r = stack[--sp];
+        tam_slice_t *s = a + r.lo;
+        u64 *k = keys + r.lo;
+        usize m = r.n;
+        if (m <= TAM_SORT_SLICES_SMALL) {
+            tam_sort_slices_insertion(s, k, m, r.depth);
+            continue;
+        }
+
+        u64 pivot;
+        if (m >= 128) {
+            // ninther
+            usize e = m / 8;
+            pivot = tam_median3_u64(tam_median3_u64(k[0], k[e], k[2 * e]),
+                                    tam_median3_u64(k[3 * e], k[4 * e], k[5 * e]),
+                                    tam_median3_u64(k[6 * e], k[7 * e], k[m - 1]));
+        } else {
+            pivot = tam_median3_u64(k[0], k[m / 2], k[m - 1]);
+        }
+
+        // three-way partition: [0, lt) < pivot, [lt, gt) == pivot, [gt, m) > pivot
+        usize lt = 0, i = 0, gt = m;
+        while (i < gt) {
+            if (k[i] < pivot) {
+                tam_slice_t ts = s[i];
+                s[i] = s[lt];
+                s[lt] = ts;
+                u64 tk = k[i];
+                k[i] = k[lt];
+                k[lt] = tk;
+                lt++;
+                i++;
+            } else if (k[i] > pivot) {
+                gt--;
+                tam_slice_t ts = s[i];
+                s[i] = s[gt];
+                s[gt] = ts;
+                u64 tk = k[i];
+                k[i] = k[gt];
+                k[gt] = tk;
+            } else {
+                i++;
+            }
+        }
+        if (lt > 1)
+            tam_sort_push(&stack, &sp, &cap, r.lo, lt, r.depth);
+        if (m - gt > 1)
+            tam_sort_push(&stack, &sp, &cap, r.lo + gt, m - gt, r.depth);
+
+        // in the equal part, the slices that end within these 8 bytes come first, shortest first.
+        // they all have the same key, so only the slices are moved.
+        tam_slice_t *e = s + lt;
+        usize eq = gt - lt;
+        usize ended = 0;
+        for (usize j = 0; j < eq; j++) {
+            if (e[j].len <= r.depth + 8) {
+                tam_slice_t ts = e[j];
+                e[j] = e[ended];
+                e[ended++] = ts;
+            }
+        }
+        for (usize j = 1; j < ended; j++) {
+            tam_slice_t ts = e[j];
+            usize q = j;
+            for (; q > 0 && e[q - 1].len > ts.len; q--)
+                e[q] = e[q - 1];
+            e[q] = ts;
+        }
+        // the rest continue with the next 8 bytes
+        if (eq - ended > 1) {
+            usize lo = r.lo + lt + ended;
+            for (usize j = lo; j < lo + eq - ended; j++)
+                keys[j] = tam_slice_key(a[j], r.depth + 8);
+            tam_sort_push(&stack, &sp, &cap, lo, eq - ended, r.depth + 8);
+        }
+    }
+    tam_deallocate_sized(stack, tam_sort_range_t, cap);
+}
+
+void tam_sort_slices(tam_slice_t *a, usize n) {
+    if (n < 2)
+        return;
+    u64 *keys = tam_allocate(u64, n);
+    tam_sort_slices_mkqs(a, keys, n);
+    tam_deallocate(keys);
+}
+
+// Stable MSD radix sort, distributing through `tmp`. `digits` caches the byte of each slice at the current depth.
+static void tam_sort_slices_radix(tam_slice_t *a, tam_slice_t *tmp, u16 *digits, usize n) {
+    tam_sort_range_t *stack = NULL;
+    usize sp = 0, cap = 0;
+    tam_sort_push(&stack, &sp, &cap, 0, n, 0);
+    while (sp > 0) {
+        tam_sort_range_t r = stack[--sp];
+        tam_slice_t *s = a + r.lo;
+        usize m = r.n;
+        if (m <= TAM_SORT_SLICES_SMALL) {
+            u64 keys[TAM_SORT_SLICES_SMALL];
+            for (usize j = 0; j < m; j++)
+                keys[j] = tam_slice_key(s[j], r.depth);
+            tam_sort_slices_insertion(s, keys, m, r.depth);
+            continue;
+        }
+
+        // digit 0 is for slices that end here, which come first, and byte b is digit b + 1
+        usize count[257] = {0};
+        u16 *d = digits + r.lo;
+        for (usize j = 0; j < m; j++) {
+            d[j] = s[j].len > r.depth ? (u8)s[j].buf[r.depth] + 1 : 0;
+            count[d[j]]++;
+        }
+        if (count[d[0]] == m) {
+            // all in one bucket, so there is nothing to move
+            if (d[0] != 0)
+                tam_sort_push(&stack, &sp, &cap, r.lo, m, r.depth + 1);
+            continue;
+        }
+        usize pos[257];
+        usize sum = 0;
+        for (int b = 0; b < 257; b++) {
+            pos[b] = sum;
+            sum += count[b];
+        }
+        tam_slice_t *t = tmp + r.lo;
+        for (usize j = 0; j < m; j++)
+            t[pos[d[j]]++] = s[j];
+        memcpy(s, t, m * sizeof(tam_slice_t));
+        // the slices that ended are equal, and already in their original order
+        for (int b = 1; b < 257; b++) {
+            if (count[b] > 1)
+                tam_sort_push(&stack, &sp, &cap, r.lo + pos[b] - count[b], count[b], r.depth + 1);
+        }
+    }
+    tam_deallocate_sized(stack, tam_sort_range_t, cap);
+}
+
+void tam_sort_slices_stable(tam_slice_t *a, usize n) {
+    if (n < 2)
+        return;
+    tam_slice_t *tmp = tam_allocate(tam_slice_t, n);
+    u16 *digits = tam_allocate(u16, n);
+    tam_sort_slices_radix(a, tmp, digits, n);
+    tam_deallocate(tmp);
+    tam_deallocate(digits);
+}
+
+// below this many slices per thread, starting threads costs more than the sorting
+#define TAM_SORT_MIN_PER_THREAD (1 << 14)
+// how many samples per thread to pick the splitters of the parallel sort from
+#define TAM_SORT_OVERSAMPLING 64
+
+typedef struct tam_sort_job_t {
+    // 0: find the bucket of each slice, 1: move the slices into their buckets, 2: sort a bucket
+    int phase;
+    tam_slice_t *a;
+    tam_slice_t *tmp;
+    u8 *bucket;
+    // the slices of this job in phases 0 and 1, and its bucket in phase 2
+    usize beg;
+    usize end;
+    // the number of this job's slices in each bucket, and then where they go
+    usize *counts;
+    const tam_slice_t *splitters;
+    int num_splitters;
+    bool stable;
+} tam_sort_job_t;
+
+static void *tam_sort_worker(void *arg) {
+    tam_sort_job_t *job = (tam_sort_job_t *)arg;
+    if (job->phase == 0) {
+        for (usize i = job->beg; i < job->end; i++) {
+            // the number of splitters that are less than or equal to the slice
+            int lo = 0, hi = job->num_splitters;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (tam_sl_cmp(job->splitters[mid], job->a[i]) <= 0)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            job->bucket[i] = lo;
+            job->counts[lo]++;
+        }
+    } else if (job->phase == 1) {
+        for (usize i = job->beg; i < job->end; i++)
+            job->tmp[job->counts[job->bucket[i]]++] = job->a[i];
+    } else {
+        usize n = job->end - job->beg;
+        if (job->stable)
+            tam_sort_slices_stable(job->tmp + job->beg, n);
+        else
+            tam_sort_slices(job->tmp + job->beg, n);
+        memcpy(job->a + job->beg, job->tmp + job->beg, n * sizeof(tam_slice_t));
+    }
+    return NULL;
+}
+
+static void tam_sort_run_jobs(tam_sort_job_t *jobs, int n) {
+#if defined(__unix__) || defined(__APPLE__)
+    // the calling thread takes the first job itself
+    pthread_t *threads = tam_allocate(pthread_t, n);
+    bool *started = tam_allocate(bool, n);
+    for (int t = 1; t < n; t++)
+        started[t] = pthread_create(&threads[t], NULL, tam_sort_worker, &jobs[t]) == 0;
+    tam_sort_worker(&jobs[0]);
+    for (int t = 1; t < n; t++) {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+        else
+            tam_sort_worker(&jobs[t]);
+    }
+    tam_deallocate(threads);
+    tam_deallocate(started);
+#else
+    for (int t = 0; t < n; t++)
+        tam_sort_worker(&jobs[t]);
+#endif
+}
+
+void tam_sort_slices_parallel(tam_slice_t *a, usize n, int nthreads, bool stable) {
+#if defined(__unix__) || defined(__APPLE__)
+    if (nthreads <= 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    usize max_threads = n / TAM_SORT_MIN_PER_THREAD;
+    if ((usize)nthreads > max_threads)
+        nthreads = max_threads;
+    // bucket numbers are stored in a byte
+    if (nthreads > 256)
+        nthreads = 256;
+    if (nthreads <= 1) {
+        if (stable)
+            tam_sort_slices_stable(a, n);
+        else
+            tam_sort_slices(a, n);
+        return;
+    }
+
+    // splitters from an evenly spaced sample
+    int num_samples = nthreads * TAM_SORT_OVERSAMPLING;
+    tam_slice_t *samples = tam_allocate(tam_slice_t, num_samples);
+    for (int i = 0; i < num_samples; i++)
+        samples[i] = a[(usize)i * n / num_samples];
+    tam_sort_slices(samples, num_samples);
+    int num_splitters = nthreads - 1;
+    tam_slice_t *splitters = tam_allocate(tam_slice_t, num_splitters);
+    for (int i = 0; i < num_splitters; i++)
+        splitters[i] = samples[(i + 1) * TAM_SORT_OVERSAMPLING];
+    tam_deallocate(samples);
+
+    tam_slice_t *tmp = tam_allocate(tam_slice_t, n);
+    u8 *bucket = tam_allocate(u8, n);
+    usize *counts = tam_allocate(usize, nthreads * nthreads);
+    memset(counts, 0, nthreads * nthreads * sizeof(usize));
+    tam_sort_job_t *jobs = tam_allocate(tam_sort_job_t, nthreads);
+    for (int t = 0; t < nthreads; t++) {
+        jobs[t] = (tam_sort_job_t){.phase = 0,
+                                   .a = a,
+                                   .tmp = tmp,
+                                   .bucket = bucket,
+                                   .beg = n / nthreads * t,
+                                   .end = t == nthreads - 1 ? n : n / nthreads * (t + 1),
+                                   .counts = counts + t * nthreads,
+                                   .splitters = splitters,
+                                   .num_splitters = num_splitters,
+                                   .stable = stable};
+    }
+    tam_sort_run_jobs(jobs, nthreads);
+
+    // each job's slices of a bucket go after those of the previous jobs, which keeps the move stable
+    usize *bucket_start = tam_allocate(usize, nthreads + 1);
+    usize sum = 0;
+    for (int b = 0; b < nthreads; b++) {
+        bucket_start[b] = sum;
+        for (int t = 0; t < nthreads; t++) {
+            usize c = counts[t * nthreads + b];
+            counts[t * nthreads + b] = sum;
+            sum += c;
+        }
+    }
+    bucket_start[nthreads] = n;
+    for (int t = 0; t < nthreads; t++)
+        jobs[t].phase = 1;
+    tam_sort_run_jobs(jobs, nthreads);
+
+    for (int t = 0; t < nthreads; t++) {
+        jobs[t].phase = 2;
+        jobs[t].beg = bucket_start[t];
+        jobs[t].end = bucket_start[t + 1];
+    }
+    tam_sort_run_jobs(jobs, nthreads);
+
+    tam_deallocate(jobs);
+    tam_deallocate(bucket_start);
+    tam_deallocate(counts);
+    tam_deallocate(bucket);
+    tam_deallocate(tmp);
+    tam_deallocate(splitters);
+}
+
+// end slice sorts }}}
+
+// ### Primitive sorts {{{
+
+// Ranges of keys between these sizes are radix sorted: smaller ones are faster to sort in place, and larger
+// ones are faster to partition first, since the radix sort's scattered writes miss the cache
+#define TAM_SORT_RADIX_MIN (1 << 12)
+#define TAM_SORT_RADIX_MAX (1 << 16)
+// ranges of this many keys or fewer are finished by a sorting network, or an insertion sort without AVX2
+#define TAM_SORT_SMALL 16
+
+#if defined(TAM_AVX2)
+// For each bitmask of the lanes that are greater than the pivot, the permutation that moves the other lanes to
+// the front and those lanes to the back, with the index of the lane to take in each nibble
+static const u32 tam_sort_perm_i32[256] = {
+    0x76543210, 0x07654321, 0x17654320, 0x10765432, 0x27654310, 0x20765431, 0x21765430, 0x21076543,
+    0x37654210, 0x30765421, 0x31765420, 0x31076542, 0x32765410, 0x32076541, 0x32176540, 0x32107654,
+    0x47653210, 0x40765321, 0x41765320, 0x41076532, 0x42765310, 0x42076531, 0x42176530, 0x42107653,
+    0x43765210, 0x43076521, 0x43176520, 0x43107652, 0x43276510, 0x43207651, 0x43217650, 0x43210765,
+    0x57643210, 0x50764321, 0x51764320, 0x51076432, 0x52764310, 0x52076431, 0x52176430, 0x52107643,
+    0x53764210, 0x53076421, 0x53176420, 0x53107642, 0x53276410, 0x53207641, 0x53217640, 0x53210764,
+    0x54763210, 0x54076321, 0x54176320, 0x54107632, 0x54276310, 0x54207631, 0x54217630, 0x54210763,
+    0x54376210, 0x54307621, 0x54317620, 0x54310762, 0x54327610, 0x54320761, 0x54321760, 0x54321076,
+    0x67543210, 0x60754321, 0x61754320, 0x61075432, 0x62754310, 0x62075431, 0x62175430, 0x62107543,
+    0x63754210, 0x63075421, 0x63175420, 0x63107542, 0x63275410, 0x63207541, 0x63217540, 0x63210754,
+    0x64753210, 0x64075321, 0x64175320, 0x64107532, 0x64275310, 0x64207531, 0x64217530, 0x64210753,
+    0x64375210, 0x64307521, 0x64317520, 0x64310752, 0x64327510, 0x64320751, 0x64321750, 0x64321075,
+    0x65743210, 0x65074321, 0x65174320, 0x65107432, 0x65274310, 0x65207431, 0x65217430, 0x65210743,
+    0x65374210, 0x65307421, 0x65317420, 0x65310742, 0x65327410, 0x65320741, 0x65321740, 0x65321074,
+    0x65473210, 0x65407321, 0x65417320, 0x65410732, 0x65427310, 0x65420731, 0x65421730, 0x65421073,
+    0x65437210, 0x65430721, 0x65431720, 0x65431072, 0x65432710, 0x65432071, 0x65432170, 0x65432107,
+    0x76543210, 0x70654321, 0x71654320, 0x71065432, 0x72654310, 0x72065431, 0x72165430, 0x72106543,
+    0x73654210, 0x73065421, 0x73165420, 0x73106542, 0x73265410, 0x73206541, 0x73216540, 0x73210654,
+    0x74653210, 0x74065321, 0x74165320, 0x74106532, 0x74265310, 0x74206531, 0x74216530, 0x74210653,
+    0x74365210, 0x74306521, 0x74316520, 0x74310652, 0x74326510, 0x74320651, 0x74321650, 0x74321065,
+    0x75643210, 0x75064321, 0x75164320, 0x75106432, 0x75264310, 0x75206431, 0x75216430, 0x75210643,
+    0x75364210, 0x75306421, 0x75316420, 0x75310642, 0x75326410, 0x75320641, 0x75321640, 0x75321064,
+    0x75463210, 0x75406321, 0x75416320, 0x75410632, 0x75426310, 0x75420631, 0x75421630, 0x75421063,
+    0x75436210, 0x75430621, 0x75431620, 0x75431062, 0x75432610, 0x75432061, 0x75432160, 0x75432106,
+    0x76543210, 0x76054321, 0x76154320, 0x76105432, 0x76254310, 0x76205431, 0x76215430, 0x76210543,
+    0x76354210, 0x76305421, 0x76315420, 0x76310542, 0x76325410, 0x76320541, 0x76321540, 0x76321054,
+    0x76453210, 0x76405321, 0x76415320, 0x76410532, 0x76425310, 0x76420531, 0x76421530, 0x76421053,
+    0x76435210, 0x76430521, 0x76431520, 0x76431052, 0x76432510, 0x76432051, 0x76432150, 0x76432105,
+    0x76543210, 0x76504321, 0x76514320, 0x76510432, 0x76524310, 0x76520431, 0x76521430, 0x76521043,
+    0x76534210, 0x76530421, 0x76531420, 0x76531042, 0x76532410, 0x76532041, 0x76532140, 0x76532104,
+    0x76543210, 0x76540321, 0x76541320, 0x76541032, 0x76542310, 0x76542031, 0x76542130, 0x76542103,
+    0x76543210, 0x76543021, 0x76543120, 0x76543102, 0x76543210, 0x76543201, 0x76543210, 0x76543210,
+};
+// The same for 64-bit lanes, as the indices of their 32-bit halves
+static const u32 tam_sort_perm_i64[16] = {
+    0x76543210, 0x10765432, 0x32765410, 0x32107654, 0x54763210, 0x54107632, 0x54327610, 0x54321076,
+    0x76543210, 0x76105432, 0x76325410, 0x76321054, 0x76543210, 0x76541032, 0x76543210, 0x76543210,
+};
+
+static inline __m256i tam_sort_perm(u32 nibbles) {
+    __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    return _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(nibbles), shifts), _mm256_set1_epi32(15));
+}
+
+// One comparator stage of a sorting network: each lane is compared with the lane that `p` moved to it,
+// and the lanes in `imm` keep the larger key
+#define TAM_SORT_STAGE_I32(v, p, imm) _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), imm)
+#define TAM_SORT_STAGE_I64(v, p, imm) _mm256_blend_epi32(tam_sort_min_i64(v, p), tam_sort_max_i64(v, p), imm)
+
+static inline __m256i tam_sort_min_i64(__m256i a, __m256i b) {
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __m256i tam_sort_max_i64(__m256i a, __m256i b) {
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __m256i tam_sort_reverse_i32(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// Bitonic sort of the 8 lanes of a vector
+static inline __m256i tam_sort8_i32(__m256i v) {
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)), 0xCC);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA);
+    v = TAM_SORT_STAGE_I32(v, tam_sort_reverse_i32(v), 0xF0);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xCC);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA);
+    return v;
+}
+
+// Sort the 8 lanes of a bitonic vector
+static inline __m256i tam_sort_clean8_i32(__m256i v) {
+    v = TAM_SORT_STAGE_I32(v, _mm256_permute2x128_si256(v, v, 1), 0xF0);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xCC);
+    v = TAM_SORT_STAGE_I32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA);
+    return v;
+}
+
+// Merge two sorted vectors into the lower and upper half of their keys
+static inline void tam_sort_merge8_i32(__m256i *a, __m256i *b) {
+    __m256i r = tam_sort_reverse_i32(*b);
+    __m256i lo = _mm256_min_epi32(*a, r);
+    __m256i hi = _mm256_max_epi32(*a, r);
+    *a = tam_sort_clean8_i32(lo);
+    *b = tam_sort_clean8_i32(hi);
+}
+
+static inline __m256i tam_sort4_i64(__m256i v) {
+    v = TAM_SORT_STAGE_I64(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xCC);
+    v = TAM_SORT_STAGE_I64(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(0, 1, 2, 3)), 0xF0);
+    v = TAM_SORT_STAGE_I64(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xCC);
+    return v;
+}
+
+static inline __m256i tam_sort_clean4_i64(__m256i v) {
+    v = TAM_SORT_STAGE_I64(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xF0);
+    v = TAM_SORT_STAGE_I64(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xCC);
+    return v;
+}
+
+static inline void tam_sort_merge4_i64(__m256i *a, __m256i *b) {
+    __m256i r = _mm256_permute4x64_epi64(*b, _MM_SHUFFLE(0, 1, 2, 3));
+    __m256i lo = tam_sort_min_i64(*a, r);
+    __m256i hi = tam_sort_max_i64(*a, r);
+    *a = tam_sort_clean4_i64(lo);
+    *b = tam_sort_clean4_i64(hi);
+}
+
+// Sort two sorted pairs of vectors, each holding 8 keys, into 16 keys
+static inline void tam_sort_merge8_i64(__m256i v[4]) {
+    __m256i r2 = _mm256_permute4x64_epi64(v[3], _MM_SHUFFLE(0, 1, 2, 3));
+    __m256i r3 = _mm256_permute4x64_epi64(v[2], _MM_SHUFFLE(0, 1, 2, 3));
+    __m256i lo0 = tam_sort_min_i64(v[0], r2), hi0 = tam_sort_max_i64(v[0], r2);
+    __m256i lo1 = tam_sort_min_i64(v[1], r3), hi1 = tam_sort_max_i64(v[1], r3);
+    v[0] = tam_sort_clean4_i64(tam_sort_min_i64(lo0, lo1));
+    v[1] = tam_sort_clean4_i64(tam_sort_max_i64(lo0, lo1));
+    v[2] = tam_sort_clean4_i64(tam_sort_min_i64(hi0, hi1));
+    v[3] = tam_sort_clean4_i64(tam_sort_max_i64(hi0, hi1));
+}
+
+// Write the lanes of `v` that are <= the pivot at `a + *l` and the others so that they end at `a + *r`,
+// which writes a full vector at both places
+static inline void tam_sort_partition_vec_i32(i32 *a, usize *l, usize *r, __m256i v, __m256i pv) {
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pv)));
+    __m256i p = _mm256_permutevar8x32_epi32(v, tam_sort_perm(tam_sort_perm_i32[mask]));
+    int gt = tam_popcount64(mask);
+    _mm256_storeu_si256((__m256i *)(a + *l), p);
+    _mm256_storeu_si256((__m256i *)(a + *r - 8), p);
+    *l += 8 - gt;
+    *r -= gt;
+}
+
+static inline void tam_sort_partition_vec_i64(i64 *a, usize *l, usize *r, __m256i v, __m256i pv) {
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, pv)));
+    __m256i p = _mm256_permutevar8x32_epi32(v, tam_sort_perm(tam_sort_perm_i64[mask]));
+    int gt = tam_popcount64(mask);
+    _mm256_storeu_si256((__m256i *)(a + *l), p);
+    _mm256_storeu_si256((__m256i *)(a + *r - 4), p);
+    *l += 4 - gt;
+    *r -= gt;
+}
+#endif // TAM_AVX2
+
+// Partition a[0, n) in place so that the keys <= pivot come first, and return their count.
+// With AVX2, the first and last vectors are set aside, which leaves room to write each vector that is read
+// to both ends before they are overwritten. Reading from the end with less room left keeps room at both.
+static usize tam_sort_i32_partition(i32 *a, usize n, i32 pivot) {
+#if defined(TAM_AVX2)
+    if (n >= 16) {
+        __m256i pv = _mm256_set1_epi32(pivot);
+        __m256i first = _mm256_loadu_si256((const __m256i *)a);
+        __m256i last = _mm256_loadu_si256((const __m256i *)(a + n - 8));
+        // written to [0, l) and [r, n), and still to read [rl, rr)
+        usize l = 0, r = n, rl = 8, rr = n - 8;
+        while (rr - rl >= 8) {
+            __m256i v;
+            if (rl - l <= r - rr) {
+                v = _mm256_loadu_si256((const __m256i *)(a + rl));
+                rl += 8;
+            } else {
+                rr -= 8;
+                v = _mm256_loadu_si256((const __m256i *)(a + rr));
+            }
+            tam_sort_partition_vec_i32(a, &l, &r, v, pv);
+        }
+        i32 rest[8];
+        usize nrest = rr - rl;
+        memcpy(rest, a + rl, nrest * sizeof(i32));
+        for (usize i = 0; i < nrest; i++) {
+            if (rest[i] <= pivot)
+                a[l++] = rest[i];
+            else
+                a[--r] = rest[i];
+        }
+        tam_sort_partition_vec_i32(a, &l, &r, first, pv);
+        // exactly one vector of room is left, so the last vector is written once
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(last, pv)));
+        __m256i p = _mm256_permutevar8x32_epi32(last, tam_sort_perm(tam_sort_perm_i32[mask]));
+        _mm256_storeu_si256((__m256i *)(a + l), p);
+        return l + 8 - tam_popcount64(mask);
+    }
+#endif
+    usize l = 0;
+    for (usize i = 0; i < n; i++) {
+        i32 x = a[i];
+        a[i] = a[l];
+        a[l] = x;
+        l += x <= pivot;
+    }
+    return l;
+}
+
+static usize tam_sort_i64_partition(i64 *a, usize n, i64 pivot) {
+#if defined(TAM_AVX2)
+    if (n >= 8) {
+        __m256i pv = _mm256_set1_epi64x(pivot);
+        __m256i first = _mm256_loadu_si256((const __m256i *)a);
+        __m256i last = _mm256_loadu_si256((const __m256i *)(a + n - 4));
+        usize l = 0, r = n, rl = 4, rr = n - 4;
+        while (rr - rl >= 4) {
+            __m256i v;
+            if (rl - l <= r - rr) {
+                v = _mm256_loadu_si256((const __m256i *)(a + rl));
+                rl += 4;
+            } else {
+                rr -= 4;
+                v = _mm256_loadu_si256((const __m256i *)(a + rr));
+            }
+            tam_sort_partition_vec_i64(a, &l, &r, v, pv);
+        }
+        i64 rest[4];
+        usize nrest = rr - rl;
+        memcpy(rest, a + rl, nrest * sizeof(i64));
+        for (usize i = 0; i < nrest; i++) {
+            if (rest[i] <= pivot)
+                a[l++] = rest[i];
+            else
+                a[--r] = rest[i];
+        }
+        tam_sort_partition_vec_i64(a, &l, &r, first, pv);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(last, pv)));
+        __m256i p = _mm256_permutevar8x32_epi32(last, tam_sort_perm(tam_sort_perm_i64[mask]));
+        _mm256_storeu_si256((__m256i *)(a + l), p);
+        return l + 4 - tam_popcount64(mask);
+    }
+#endif
+    usize l = 0;
+    for (usize i = 0; i < n; i++) {
+        i64 x = a[i];
+        a[i] = a[l];
+        a[l] = x;
+        l += x <= pivot;
+    }
+    return l;
+}
+
+// Sort at most TAM_SORT_SMALL keys
+static void tam_sort_i32_small(i32 *a, usize n) {
+#if defined(TAM_AVX2)
+    // padded with the largest key, which sorts to the end
+    i32 buf[16];
+    for (usize i = 0; i < 16; i++)
+        buf[i] = i < n ? a[i] : INT32_MAX;
+    __m256i v0 = tam_sort8_i32(_mm256_loadu_si256((const __m256i *)buf));
+    if (n > 8) {
+        __m256i v1 = tam_sort8_i32(_mm256_loadu_si256((const __m256i *)(buf + 8)));
+        tam_sort_merge8_i32(&v0, &v1);
+        _mm256_storeu_si256((__m256i *)(buf + 8), v1);
+    }
+    _mm256_storeu_si256((__m256i *)buf, v0);
+    memcpy(a, buf, n * sizeof(i32));
+#else
+    for (usize i = 1; i < n; i++) {
+        i32 x = a[i];
+        usize j = i;
+        for (; j > 0 && a[j - 1] > x; j--)
+            a[j] = a[j - 1];
+        a[j] = x;
+    }
+#endif
+}
+
+static void tam_sort_i64_small(i64 *a, usize n) {
+#if defined(TAM_AVX2)
+    i64 buf[16];
+    for (usize i = 0; i < 16; i++)
+        buf[i] = i < n ? a[i] : INT64_MAX;
+    __m256i v[4];
+    usize nv = n <= 4 ? 1 : n <= 8 ? 2 : 4;
+    for (usize i = 0; i < nv; i++)
+        v[i] = tam_sort4_i64(_mm256_loadu_si256((const __m256i *)(buf + 4 * i)));
+    if (nv >= 2)
+        tam_sort_merge4_i64(&v[0], &v[1]);
+    if (nv == 4) {
+        tam_sort_merge4_i64(&v[2], &v[3]);
+        tam_sort_merge8_i64(v);
+    }
+    for (usize i = 0; i < nv; i++)
+        _mm256_storeu_si256((__m256i *)(buf + 4 * i), v[i]);
+    memcpy(a, buf, n * sizeof(i64));
+#else
+    for (usize i = 1; i < n; i++) {
+        i64 x = a[i];
+        usize j = i;
+        for (; j > 0 && a[j - 1] > x; j--)
+            a[j] = a[j - 1];
+        a[j] = x;
+    }
+#endif
+}
+
+// The quicksort, heapsort and radix sorts for signed keys of type T, whose unsigned type is U
+#define TAM_SORT_INT_FUNCS(T, U, T_MIN)                                                                                \
+    static void tam_sort_##T##_sift(T *a, usize n, usize i) {                                                          \
+        T x = a[i];                                                                                                    \
+        for (;;) {                                                                                                     \
+            usize c = 2 * i + 1;                                                                                       \
+            if (c >= n)                                                                                                \
+                break;                                                                                                 \
+            if (c + 1 < n && a[c + 1] > a[c])                                                                          \
+                c++;                                                                                                   \
+            if (a[c] <= x)                                                                                             \
+                break;                                                                                                 \
+            a[i] = a[c];                                                                                               \
+            i = c;                                                                                                     \
+        }                                                                                                              \
+        a[i] = x;                                                                                                      \
+    }                                                                                                                  \
+                                                                                                                       \
+    static void tam_sort_##T##_heap(T *a, usize n) {                                                                   \
+        for (usize i = n / 2; i-- > 0;)                                                                                \
+            tam_sort_##T##_sift(a, n, i);                                                                              \
+        for (usize i = n; i-- > 1;) {                                                                                  \
+            T x = a[0];                                                                                                \
+            a[0] = a[i];                                                                                               \
+            a[i] = x;                                                                                                  \
+            tam_sort_##T##_sift(a, i, 0);                                                                              \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    static inline T tam_sort_##T##_median3(T a, T b, T c) {                                                            \
+        if (a > b) {                                                                                                   \
+            T t = a;                                                                                                   \
+            a = b;                                                                                                     \
+            b = t;                                                                                                     \
+        }                                                                                                              \
+        return c <= a ? a : c >= b ? b : c;                                                                            \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* LSD radix sort by bytes through `tmp`, moving `values` too unless NULL. The sign bit is flipped to order */     \
+    /* the signed keys as unsigned ones. */                                                                            \
+    static void tam_sort_##T##_radix(T *a, u32 *values, T *tmp, u32 *tmp_values, usize n) {                            \
+        const U sign = (U)1 << (sizeof(T) * 8 - 1);                                                                    \
+        usize counts[sizeof(T)][256];                                                                                  \
+        memset(counts, 0, sizeof(counts));                                                                             \
+        for (usize i = 0; i < n; i++) {                                                                                \
+            U u = (U)a[i] ^ sign;                                                                                      \
+            for (usize d = 0; d < sizeof(T); d++)                                                                      \
+                counts[d][(u >> (8 * d)) & 0xff]++;                                                                    \
+        }                                                                                                              \
+        T *src = a, *dst = tmp;                                                                                        \
+        u32 *vsrc = values, *vdst = tmp_values;                                                                        \
+        for (usize d = 0; d < sizeof(T); d++) {                                                                        \
+            usize *c = counts[d];                                                                                      \
+            int shift = 8 * d;                                                                                         \
+            /* skip the bytes that all keys share */                                                                   \
+            if (c[(((U)src[0] ^ sign) >> shift) & 0xff] == n)                                                          \
+                continue;                                                                                              \
+            usize sum = 0;                                                                                             \
+            for (int b = 0; b < 256; b++) {                                                                            \
+                usize t = c[b];                                                                                        \
+                c[b] = sum;                                                                                            \
+                sum += t;                                                                                              \
+            }                                                                                                          \
+            if (values) {                                                                                              \
+                for (usize i = 0; i < n; i++) {                                                                        \
+                    usize j = c[(((U)src[i] ^ sign) >> shift) & 0xff]++;                                               \
+                    dst[j] = src[i];                                                                                   \
+                    vdst[j] = vsrc[i];                                                                                 \
+                }                                                                                                      \
+                u32 *vt = vsrc;                                                                                        \
+                vsrc = vdst;                                                                                           \
+                vdst = vt;                                                                                             \
+            } else {                                                                                                   \
+                for (usize i = 0; i < n; i++)                                                                          \
+                    dst[c[(((U)src[i] ^ sign) >> shift) & 0xff]++] = src[i];                                           \
+            }                                                                                                          \
+            T *t = src;                                                                                                \
+            src = dst;                                                                                                 \
+            dst = t;                                                                                                   \
+        }                                                                                                              \
+        if (src != a) {                                                                                                \
+            memcpy(a, src, n * sizeof(T));                                                                             \
+            if (values)                                                                                                \
+                memcpy(values, vsrc, n * sizeof(u32));                                                                 \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* sorts a[0, n) with at most `budget` levels of partitions before switching to a heapsort, and radix */           \
+    /* sorts the ranges that fit in `tmp` unless it is NULL */                                                         \
+    static void tam_sort_##T##_quick(T *a, usize n, T *tmp, int budget) {                                              \
+        while (n > TAM_SORT_SMALL) {                                                                                   \
+            if (tmp && n >= TAM_SORT_RADIX_MIN && n <= TAM_SORT_RADIX_MAX) {                                           \
+                tam_sort_##T##_radix(a, NULL, tmp, NULL, n);                                                           \
+                return;                                                                                                \
+            }                                                                                                          \
+            if (budget-- == 0) {                                                                                       \
+                tam_sort_##T##_heap(a, n);                                                                             \
+                return;                                                                                                \
+            }                                                                                                          \
+            T p;                                                                                                       \
+            if (n >= 128) {                                                                                            \
+                usize e = n / 8;                                                                                       \
+                p = tam_sort_##T##_median3(tam_sort_##T##_median3(a[0], a[e], a[2 * e]),                               \
+                                           tam_sort_##T##_median3(a[3 * e], a[4 * e], a[5 * e]),                       \
+                                           tam_sort_##T##_median3(a[6 * e], a[7 * e], a[n - 1]));                      \
+            } else {                                                                                                   \
+                p = tam_sort_##T##_median3(a[0], a[n / 2], a[n - 1]);                                                  \
+            }                                                                                                          \
+            usize m = tam_sort_##T##_partition(a, n, p);                                                               \
+            if (m == n) {                                                                                              \
+                /* the pivot is the largest key, so the keys equal to it are in place once split off */                \
+                if (p == T_MIN)                                                                                        \
+                    return;                                                                                            \
+                n = tam_sort_##T##_partition(a, n, p - 1);                                                             \
+                continue;                                                                                              \
+            }                                                                                                          \
+            /* recursing into the smaller side bounds the depth of the stack */                                        \
+            if (m < n - m) {                                                                                           \
+                tam_sort_##T##_quick(a, m, tmp, budget);                                                               \
+                a += m;                                                                                                \
+                n -= m;                                                                                                \
+            } else {                                                                                                   \
+                tam_sort_##T##_quick(a + m, n - m, tmp, budget);                                                       \
+                n = m;                                                                                                 \
+            }                                                                                                          \
+        }                                                                                                              \
+        tam_sort_##T##_small(a, n);                                                                                    \
+    }                                                                                                                  \
+                                                                                                                       \
+    static void tam_sort_##T##_keys(T *a, usize n) {                                                                   \
+        if (n < 2)                                                                                                     \
+            return;                                                                                                    \
+        T *tmp = NULL;                                                                                                 \
+        if (n >= TAM_SORT_RADIX_MIN)                                                                                   \
+            tmp = tam_allocate(T, n < TAM_SORT_RADIX_MAX ? n : TAM_SORT_RADIX_MAX);                                    \
+        int budget = 0;                                                                                                \
+        for (usize m = n; m > 1; m >>= 1)                                                                              \
+            budget += 2;                                                                                               \
+        tam_sort_##T##_quick(a, n, tmp, budget);                                                                       \
+        if (tmp)                                                                                                       \
+            tam_deallocate(tmp);                                                                                       \
+    }                                                                                                                  \
+                                                                                                                       \
+    static void tam_sort_##T##_pairs(T *a, u32 *values, usize n) {                                                     \
+        if (n <= TAM_SORT_SMALL) {                                                                                     \
+            for (usize i = 1; i < n; i++) {                                                                            \
+                T x = a[i];                                                                                            \
+                u32 v = values[i];                                                                                     \
+                usize j = i;                                                                                           \
+                for (; j > 0 && a[j - 1] > x; j--) {                                                                   \
+                    a[j] = a[j - 1];                                                                                   \
+                    values[j] = values[j - 1];                                                                         \
+                }                                                                                                      \
+                a[j] = x;                                                                                              \
+                values[j] = v;                                                                                         \
+            }                                                                                                          \
+            return;                                                                                                    \
+        }                                                                                                              \
+        T *tmp = tam_allocate(T, n);                                                                                   \
+        u32 *tmp_values = tam_allocate(u32, n);                                                                        \
+        tam_sort_##T##_radix(a, values, tmp, tmp_values, n);                                                           \
+        tam_deallocate(tmp);                                                                                           \
+        tam_deallocate(tmp_values);                                                                                    \
+    }
+
+TAM_SORT_INT_FUNCS(i32, u32, INT32_MIN)
+TAM_SORT_INT_FUNCS(i64, u64, INT64_MIN)
+
+// The keys of the other types are mapped to signed integers in the same order and back.
+// Unsigned keys flip their sign bit in place, which is allowed since they may alias their signed counterparts.
+static void tam_sort_u32_to_i32(u32 *a, usize n) {
+    for (usize i = 0; i < n; i++)
+        a[i] ^= 0x80000000u;
+}
+
+static void tam_sort_u64_to_i64(u64 *a, usize n) {
+    for (usize i = 0; i < n; i++)
+        a[i] ^= 0x8000000000000000ull;
+}
+
+// Floats may not be accessed through integer pointers, so they are copied into an array of integer keys and back.
+// Negative floats flip their other bits to reverse their order, which maps keys back to floats as well.
+static void tam_sort_f32_keys(void *dst, const void *src, usize n) {
+    for (usize i = 0; i < n; i++) {
+        i32 b;
+        memcpy(&b, (const char *)src + i * sizeof(b), sizeof(b));
+        b ^= (i32)((u32)(b >> 31) >> 1);
+        memcpy((char *)dst + i * sizeof(b), &b, sizeof(b));
+    }
+}
+
+static void tam_sort_f64_keys(void *dst, const void *src, usize n) {
+    for (usize i = 0; i < n; i++) {
+        i64 b;
+        memcpy(&b, (const char *)src + i * sizeof(b), sizeof(b));
+        b ^= (i64)((u64)(b >> 63) >> 1);
+        memcpy((char *)dst + i * sizeof(b), &b, sizeof(b));
+    }
+}
+
+void tam_sort_i32(i32 *a, usize n) { tam_sort_i32_keys(a, n); }
+
+void tam_sort_u32(u32 *a, usize n) {
+    tam_sort_u32_to_i32(a, n);
+    tam_sort_i32_keys((i32 *)a, n);
+    tam_sort_u32_to_i32(a, n);
+}
+
+void tam_sort_i64(i64 *a, usize n) { tam_sort_i64_keys(a, n); }
+
+void tam_sort_u64(u64 *a, usize n) {
+    tam_sort_u64_to_i64(a, n);
+    tam_sort_i64_keys((i64 *)a, n);
+    tam_sort_u64_to_i64(a, n);
+}
+
+void tam_sort_f32(f32 *a, usize n) {
+    if (n < 2)
+        return;
+    i32 *keys = tam_allocate(i32, n);
+    tam_sort_f32_keys(keys, a, n);
+    tam_sort_i32_keys(keys, n);
+    tam_sort_f32_keys(a, keys, n);
+    tam_deallocate(keys);
+}
+
+void tam_sort_f64(f64 *a, usize n) {
+    if (n < 2)
+        return;
+    i64 *keys = tam_allocate(i64, n);
+    tam_sort_f64_keys(keys, a, n);
+    tam_sort_i64_keys(keys, n);
+    tam_sort_f64_keys(a, keys, n);
+    tam_deallocate(keys);
+}
+
+void tam_sort_i32_kv(i32 *keys, u32 *values, usize n) { tam_sort_i32_pairs(keys, values, n); }
+
+void tam_sort_u32_kv(u32 *keys, u32 *values, usize n) {
+    tam_sort_u32_to_i32(keys, n);
+    tam_sort_i32_pairs((i32 *)keys, values, n);
+    tam_sort_u32_to_i32(keys, n);
+}
+
+void tam_sort_i64_kv(i64 *keys, u32 *values, usize n) { tam_sort_i64_pairs(keys, values, n); }
+
+void tam_sort_u64_kv(u64 *keys, u32 *values, usize n) {
+    tam_sort_u64_to_i64(keys, n);
+    tam_sort_i64_pairs((i64 *)keys, values, n);
+    tam_sort_u64_to_i64(keys, n);
+}
+
+void tam_sort_f32_kv(f32 *keys, u32 *values, usize n) {
+    if (n < 2)
+        return;
+    i32 *ikeys = tam_allocate(i32, n);
+    tam_sort_f32_keys(ikeys, keys, n);
+    tam_sort_i32_pairs(ikeys, values, n);
+    tam_sort_f32_keys(keys, ikeys, n);
+    tam_deallocate(ikeys);
+}
+
+void tam_sort_f64_kv(f64 *keys, u32 *values, usize n) {
+    if (n < 2)
+        return;
+    i64 *ikeys = tam_allocate(i64, n);
+    tam_sort_f64_keys(ikeys, keys, n);
+    tam_sort_i64_pairs(ikeys, values, n);
+    tam_sort_f64_keys(keys, ikeys, n);
+    tam_deallocate(ikeys);
+}
+
+// end primitive sorts }}}
+
+#if defined(TAM_TEST)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ### Sort tests {{{
+
+// Check that `a` is the sorted order of `orig`, and if `stable`, that equal slices kept their order,
+// which is the order of their addresses in these tests
+static void tam_test_check_sorted(const tam_slice_t *a, tam_slice_t *orig, usize n, bool stable) {
+    for (usize i = 1; i < n; i++) {
+        int c = tam_sl_cmp(a[i - 1], a[i]);
+        assert(c <= 0);
+        if (stable && c == 0)
+            assert(a[i - 1].buf < a[i].buf);
+    }
+    // the same slices, as the stable sort of the original puts them in the same order
+    tam_sort_slices_stable(orig, n);
+    for (usize i = 0; i < n; i++)
+        assert(tam_sl_eq(a[i], orig[i]) && (!stable || tam_sl_eqv(a[i], orig[i])));
+}
+
+// Check the sorts of numbers of type T against qsort, on keys made by GEN from a random u64 `x`, the index `i`,
+// and a `mode` that picks small or full ranges, a constant, or a descending run
+#define TAM_TEST_SORT_NUMBERS(T, GEN)                                                                                  \
+    for (int mode = 0; mode < 4; mode++) {                                                                             \
+        for (usize k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {                                                 \
+            usize n = sizes[k];                                                                                        \
+            T *a = tam_allocate(T, n + 1), *ref = tam_allocate(T, n + 1), *keys = tam_allocate(T, n + 1);              \
+            u32 *idx = tam_allocate(u32, n + 1);                                                                       \
+            for (usize i = 0; i < n; i++) {                                                                            \
+                r ^= r << 13, r ^= r >> 7, r ^= r << 17;                                                               \
+                a[i] = GEN;                                                                                            \
+                idx[i] = i;                                                                                            \
+            }                                                                                                          \
+            memcpy(ref, a, n * sizeof(T));                                                                             \
+            memcpy(keys, a, n * sizeof(T));                                                                            \
+            qsort(ref, n, sizeof(T), tam_test_cmp_##T);                                                                \
+            tam_sort_##T##_kv(keys, idx, n);                                                                           \
+            for (usize i = 0; i < n; i++) {                                                                            \
+                assert(keys[i] == ref[i] && memcmp(&keys[i], &a[idx[i]], sizeof(T)) == 0);                             \
+                if (i > 0 && memcmp(&keys[i - 1], &keys[i], sizeof(T)) == 0)                                           \
+                    assert(idx[i - 1] < idx[i]);                                                                       \
+            }                                                                                                          \
+            tam_sort_##T(a, n);                                                                                        \
+            for (usize i = 0; i < n; i++)                                                                              \
+                assert(a[i] == ref[i] && memcmp(&a[i], &keys[i], sizeof(T)) == 0);                                     \
+            tam_deallocate(a);                                                                                         \
+            tam_deallocate(ref);                                                                                       \
+            tam_deallocate(keys);                                                                                      \
+            tam_deallocate(idx);                                                                                       \
+        }                                                                                                              \
+    }
+
+#define TAM_TEST_CMP(T)                                                                                                \
+    static int tam_test_cmp_##T(const void *a, const void *b) {                                                        \
+        T x = *(const T *)a, y = *(const T *)b;                                                                        \
+        return (x > y) - (x < y);                                                                                      \
+    }
+TAM_TEST_CMP(i32)
+TAM_TEST_CMP(u32)
+TAM_TEST_CMP(i64)
+TAM_TEST_CMP(u64)
+TAM_TEST_CMP(f32)
+TAM_TEST_CMP(f64)
+
+int tam_test_sort() {
+    // strings from a small alphabet that includes zero bytes, with many duplicates and long common prefixes
+    usize n = 100000;
+    char *text = tam_allocate(char, n * 40);
+    tam_slice_t *orig = tam_allocate(tam_slice_t, n);
+    tam_slice_t *a = tam_allocate(tam_slice_t, n);
+    tam_slice_t *b = tam_allocate(tam_slice_t, n);
+    u32 x = 2463534242u;
+    usize pos = 0;
+    for (usize i = 0; i < n; i++) {
+        x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+        int len = x % 5 == 0 ? (int)(x >> 8) % 30 : (int)(x >> 8) % 4;
+        char *s = text + pos;
+        for (int j = 0; j < len; j++) {
+            x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+            // mostly a shared prefix, so that many slices tie on their first 8 and 16 bytes
+            s[j] = j < 12 && x % 8 != 0 ? 'p' : "\0ab\x80"[x % 4];
+        }
+        orig[i] = tam_slice_n(s, len);
+        pos += len + 1;
+    }
+
+    memcpy(a, orig, n * sizeof(tam_slice_t));
+    memcpy(b, orig, n * sizeof(tam_slice_t));
+    tam_sort_slices(a, n);
+    tam_sort_slices_stable(b, n);
+    tam_test_check_sorted(b, orig, n, true);
+    tam_test_check_sorted(a, orig, n, false);
+
+    for (int stable = 0; stable < 2; stable++) {
+        memcpy(a, orig, n * sizeof(tam_slice_t));
+        tam_sort_slices_parallel(a, n, 4, stable);
+        tam_test_check_sorted(a, orig, n, stable);
+    }
+
+    // small and trivial inputs
+    tam_slice_t words[] = {tam_slice("pear"), tam_slice("apple"), tam_slice(""), tam_slice("app"), tam_slice("apple")};
+    tam_sort_slices(words, 5);
+    assert(tam_sl_eqstr(words[0], "") && tam_sl_eqstr(words[1], "app") && tam_sl_eqstr(words[4], "pear"));
+    tam_sort_slices(words, 0);
+    tam_sort_slices_stable(words, 1);
+    tam_sort_slices_parallel(words, 5, 0, true);
+    assert(tam_sl_eqstr(words[2], "apple") && tam_sl_eqstr(words[3], "apple"));
+
+    tam_deallocate(text);
+    tam_deallocate(orig);
+    tam_deallocate(a);
+    tam_deallocate(b);
+
+    // numbers, with sizes around the sorting network, the vector partitions and the radix sort
+    usize sizes[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 23, 31, 32, 33, 100, 1000, 4095, 5000, 70000};
+    u64 r = 88172645463325252ull;
+    TAM_TEST_SORT_NUMBERS(i32, mode == 0 ? (i32)(r % 100) - 50 : mode == 1 ? (i32)r : mode == 2 ? 7 : -(i32)i)
+    TAM_TEST_SORT_NUMBERS(u32, mode == 0 ? (u32)(r % 100) - 50 : mode == 1 ? (u32)r : mode == 2 ? 0 : ~(u32)i)
+    TAM_TEST_SORT_NUMBERS(i64, mode == 0 ? (i64)(r % 100) - 50 : mode == 1 ? (i64)r : mode == 2 ? INT64_MIN : -(i64)i)
+    TAM_TEST_SORT_NUMBERS(u64, mode == 0 ? (u64)(r % 100) - 50 : mode == 1 ? r : mode == 2 ? UINT64_MAX : ~(u64)i)
+    TAM_TEST_SORT_NUMBERS(f32, mode == 0   ? ((i32)(r % 100) - 50) * 0.5f
+                               : mode == 1 ? (f32)(i64)r * 1e-10f
+                               : mode == 2 ? -0.0f
+                                           : -(f32)i)
+    TAM_TEST_SORT_NUMBERS(f64, mode == 0   ? (r % 7 == 0 ? -0.0 : ((i32)(r % 100) - 50) * 0.25)
+                               : mode == 1 ? (f64)(i64)r * 1e-300
+                               : mode == 2 ? 1.5
+                                           : -(f64)i)
+
+    // signed zeros, infinities and NaNs
+    f64 special[] = {NAN, 1.0, -NAN, -INFINITY, 0.0, -0.0, INFINITY};
+    tam_sort_f64(special, 7);
+    assert(isnan(special[0]) && signbit(special[0]) && special[1] == -INFINITY && signbit(special[2]));
+    assert(special[3] == 0.0 && !signbit(special[3]) && special[4] == 1.0 && special[5] == INFINITY);
+    assert(isnan(special[6]) && !signbit(special[6]));
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end sort tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_SORT_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_SORT_H
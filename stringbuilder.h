@@ -1,6 +1,11 @@
 #ifndef TAM_STRINGBUILDER_H
 #define TAM_STRINGBUILDER_H
 
+#include <stdarg.h>
+#include <stdio.h>
+#include <tam/memory.h>
+#include <tam/slices.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +16,7 @@ extern "C" {
  * They can then can be appended to repeatedly using `sb_append[slice/chars/charsn]`.
  * A string builder can then construct a string (char*) by calling `sb_tochars` on the builder.
  * The returned char* is heap-allocated and must be freed by the user.
+ * If the builder is no longer needed, `sb_take` hands over its internal buffer instead of copying it.
  * The StrinBbuilder copies all data passed to it into an internal buffer, so the user is free to do whatever
  * they want with the data passed to the stringbuilder after they have done so.
  * The user is responsible for freeing the StringBuilder using sb_deallocate when they are done with it.
@@ -18,8 +24,19 @@ extern "C" {
 
 typedef struct tam_stringbuilder_t {
     char *buf;
-    int len;
-    int cap;
+    isize len;
+    isize cap;
+    // if not NULL, the buffer is allocated from this arena instead of the heap
+    tam_arena_t *arena;
+    // streaming builders (see `sb_new_file` and `sb_new_fd`) write their contents to `file` or `fd`
+    // whenever the length passes `flush_at`. For in-memory builders, file is NULL, fd is -1 and flush_at is 0.
+    FILE *file;
+    int fd;
+    int flush_at;
+    // set if any write to the file or file descriptor failed
+    bool write_error;
+    // set while `buf` is caller-provided storage (see `sb_new_buffer`), which must not be freed or reallocated
+    bool inline_buf;
 } tam_stringbuilder_t;
 
 /*
@@ -28,10 +45,94 @@ typedef struct tam_stringbuilder_t {
 tam_stringbuilder_t tam_sb_new();
 
 /*
- * Free a StringBuilder instance
+ * Create an empty StringBuilder that allocates its buffer from an arena.
+ * While the builder's buffer is the arena's most recent allocation, it grows in place without copying.
+ * The buffer lives as long as the arena does, so strings obtained from `sb_take` must not be freed
+ * by the user, and `sb_deallocate` only gives memory back to the arena if nothing was allocated after it.
+ */
+tam_stringbuilder_t tam_sb_new_arena(tam_arena_t *arena);
+
+/*
+ * Create an empty StringBuilder that initially writes into caller-provided storage of `cap` bytes,
+ * typically a stack array. Nothing is allocated until the contents outgrow the storage, at which point
+ * they move to the heap, or to `arena` if it is not NULL.
+ * The storage must outlive the builder, but the builder must still be freed using `sb_deallocate`.
+ */
+tam_stringbuilder_t tam_sb_new_buffer(char *storage, isize cap, tam_arena_t *arena);
+
+#ifndef TAM_SB_INLINE_CAPACITY
+#define TAM_SB_INLINE_CAPACITY 128
+#endif
+
+/*
+ * Declare a StringBuilder named `name`, backed by a TAM_SB_INLINE_CAPACITY byte array on the stack.
+ * e.g. `TAM_SB_INLINE(sb); tam_sb_appendchars(&sb, "no allocation here");`
+ */
+#define TAM_SB_INLINE(name)                                                                                            \
+    char name##_storage[TAM_SB_INLINE_CAPACITY];                                                                       \
+    tam_stringbuilder_t name = tam_sb_new_buffer(name##_storage, TAM_SB_INLINE_CAPACITY, NULL)
+
+#define TAM_SB_DEFAULT_FLUSH_AT (64 * 1024)
+
+/*
+ * Create a streaming StringBuilder, which acts as a buffered writer to `file`.
+ * All of the `sb_append*` functions work as usual, but once the builder holds at least `flush_at` bytes
+ * (TAM_SB_DEFAULT_FLUSH_AT if `flush_at` is 0), its contents are written out and the builder is emptied,
+ * so memory use stays bounded no matter how much is written. Appends larger than `flush_at` are written
+ * directly without being buffered.
+ * Remaining output is written by `sb_flush` or `sb_deallocate`.
+ */
+tam_stringbuilder_t tam_sb_new_file(FILE *file, int flush_at);
+
+/*
+ * Create a streaming StringBuilder that writes to a file descriptor. See `sb_new_file`.
+ */
+tam_stringbuilder_t tam_sb_new_fd(int fd, int flush_at);
+
+/*
+ * Write the contents of a streaming StringBuilder to its file or file descriptor and empty the builder.
+ * Returns false if this or any earlier write failed. Does nothing for in-memory builders.
+ */
+bool tam_sb_flush(tam_stringbuilder_t *sb);
+
+/*
+ * Free a StringBuilder instance.
+ * The builder is left empty, with a NULL buffer, and can be reused.
  */
 void tam_sb_deallocate(tam_stringbuilder_t *sb);
 
+/*
+ * Empty a StringBuilder, but keep its buffer so that it can be refilled without allocating.
+ */
+void tam_sb_clear(tam_stringbuilder_t *sb);
+
+#ifndef TAM_SB_POOL_SIZE
+#define TAM_SB_POOL_SIZE 8
+#endif
+
+#ifndef TAM_SB_POOL_MAX_CAPACITY
+#define TAM_SB_POOL_MAX_CAPACITY (64 * 1024)
+#endif
+
+/*
+ * Get an empty heap-backed StringBuilder from the calling thread's pool of released builders,
+ * or a new one if the pool is empty. Pooled builders keep their buffers, so at steady state
+ * acquiring and filling a builder does not allocate.
+ */
+tam_stringbuilder_t tam_sb_acquire();
+
+/*
+ * Return a StringBuilder to the calling thread's pool.
+ * At most TAM_SB_POOL_SIZE builders are kept, and builders with more than TAM_SB_POOL_MAX_CAPACITY bytes,
+ * or that use an arena, inline storage or a file, are deallocated instead.
+ */
+void tam_sb_release(tam_stringbuilder_t *sb);
+
+/*
+ * Free all builders in the calling thread's pool. Call this before a thread that used the pool exits.
+ */
+void tam_sb_pool_drain();
+
 /*
  * Append a slice to a StringBuilder
  */
@@ -48,27 +149,447 @@ void tam_sb_appendchars(tam_stringbuilder_t *sb, const char *s);
 void tam_sb_appendcharsn(tam_stringbuilder_t *sb, const char *s, usize n);
 
 /*
- * Append a formatted string to StringBuilder
+ * Append a formatted string to StringBuilder.
+ * The string is formatted directly into the builder's spare capacity, and only formatted a second time
+ * if it does not fit. The builder contents are null-terminated after this call.
  */
 void tam_sb_appendf(tam_stringbuilder_t *sb, const char *fmt, ...);
 
+/*
+ * Append the decimal representation of a signed integer to a StringBuilder.
+ * This does not go through printf, so it is considerably cheaper than `sb_appendf(sb, "%lld", x)`.
+ */
+void tam_sb_appendint(tam_stringbuilder_t *sb, i64 x);
+
+/*
+ * Append the decimal representation of an unsigned integer to a StringBuilder.
+ */
+void tam_sb_appenduint(tam_stringbuilder_t *sb, u64 x);
+
+/*
+ * Append the lowercase (or uppercase, if `upper` is true) hexadecimal representation of an unsigned integer
+ * to a StringBuilder, without a leading `0x`.
+ */
+void tam_sb_appendhex(tam_stringbuilder_t *sb, u64 x, bool upper);
+
+/*
+ * Append a single char to a StringBuilder
+ */
+void tam_sb_appendchar(tam_stringbuilder_t *sb, char c);
+
+/*
+ * Append `true` or `false` to a StringBuilder
+ */
+void tam_sb_appendbool(tam_stringbuilder_t *sb, bool x);
+
+/*
+ * Append a double to a StringBuilder, in `%g` notation with the fewest significant digits (15, 16 or 17)
+ * that read back as the same value. Trailing zeros are dropped, so e.g. 0.1 is written as `0.1`, and
+ * this is the shortest round-tripping representation of any normal (not subnormal) double.
+ * Formatting goes through snprintf, so the decimal point is that of the current LC_NUMERIC locale.
+ */
+void tam_sb_appenddouble(tam_stringbuilder_t *sb, f64 x);
+
+/*
+ * Append the contents of a slice to a StringBuilder, converted to lowercase (ASCII letters only).
+ * The conversion writes straight into the builder, without an intermediate copy.
+ */
+void tam_sb_append_lower(tam_stringbuilder_t *sb, tam_slice_t s);
+
+/*
+ * Append the contents of a slice to a StringBuilder, converted to uppercase (ASCII letters only).
+ */
+void tam_sb_append_upper(tam_stringbuilder_t *sb, tam_slice_t s);
+
 /*
  * Construct a char array from a Stringbuilder
  */
 char *tam_sb_tochars(tam_stringbuilder_t sb);
 
+/*
+ * Take ownership of a StringBuilder's internal buffer, without copying it.
+ * The returned char* is null-terminated and must be freed by the user with `tam_deallocate` (or free()).
+ * Buffers of at least TAM_MMAP_THRESHOLD bytes are mapped rather than heap-allocated, so they are copied to
+ * the heap instead. For arena-backed builders the string belongs to the arena.
+ * If `shrink` is true, the buffer is reallocated to exactly fit the string.
+ * The StringBuilder is left empty, and can be reused.
+ */
+char *tam_sb_take(tam_stringbuilder_t *sb, bool shrink);
+
+/*
+ * Get a slice that views the current contents of a StringBuilder, without copying them.
+ * The slice is invalidated by any subsequent append to or deallocation of the builder.
+ * Slices have an int length, so builders longer than INT_MAX bytes cannot be viewed.
+ */
+tam_slice_t tam_sb_view(const tam_stringbuilder_t *sb);
+
+/*
+ * Make sure a StringBuilder has room for at least `n` more bytes, and return a pointer to that spare room.
+ * Kernels that produce output directly (encoders, case conversion, ...) write there and then call
+ * `sb_commit` with the number of bytes they wrote. The pointer is invalidated by any other append.
+ */
+char *tam_sb_reserve(tam_stringbuilder_t *sb, usize n);
+
+/*
+ * Add `n` bytes written into the space returned by `sb_reserve` to the contents of a StringBuilder.
+ */
+void tam_sb_commit(tam_stringbuilder_t *sb, usize n);
+
+/*
+ * Append the contents of `n` StringBuilders to `dst`, in order.
+ * The offset of each part is computed up front and `dst` grows once. For large outputs the copying is
+ * then split evenly across `nthreads` threads (one per online CPU if `nthreads` is 0), so assembling
+ * the output of parallel workers is limited by memory bandwidth rather than a single core.
+ * Uses pthreads on POSIX systems (link with -pthread), and copies serially elsewhere.
+ * Lengths are added up in usize, and an error is raised before anything is written if the joined
+ * output would be longer than a builder can hold (PTRDIFF_MAX bytes).
+ */
+void tam_sb_join_parallel(tam_stringbuilder_t *dst, const tam_stringbuilder_t *parts, int n, int nthreads);
+
+// end StringBuilder declarations }}}
+
+//*** ## Compiled format declarations *** {{{
+/*
+ * A compiled format is a printf-style format string that has been parsed once into a list of operations,
+ * each of which is either a run of literal text or a single conversion with a known argument type.
+ * Appending with a compiled format (`sb_appendfmt`) skips format parsing entirely, and plain integer,
+ * string and char conversions use the fast appenders above instead of printf.
+ * Conversions with flags, a width or a precision (e.g. `%08.3f`) are still supported, but fall back to
+ * printf for that single argument. `*` widths and precisions and the `%n` conversion are not supported.
+ * Compiled formats copy the format string, and must be freed using `fmt_deallocate`.
+ * If the format string is invalid, `error` is set on the compiled format, which then appends nothing.
+ */
+
+typedef enum tam_fmt_arg_t {
+    TAM_FMT_LITERAL,
+    TAM_FMT_INT,
+    TAM_FMT_LONG,
+    TAM_FMT_LLONG,
+    TAM_FMT_ISIZE,
+    TAM_FMT_UINT,
+    TAM_FMT_ULONG,
+    TAM_FMT_ULLONG,
+    TAM_FMT_USIZE,
+    TAM_FMT_DOUBLE,
+    TAM_FMT_LDOUBLE,
+    TAM_FMT_CHAR,
+    TAM_FMT_STR,
+    TAM_FMT_PTR,
+} tam_fmt_arg_t;
+
+#define TAM_FMT_MAX_SPEC 16
+
+typedef struct tam_fmt_op_t {
+    tam_fmt_arg_t arg;
+    // the conversion character (d, u, x, s, ...), or 0 for literal runs
+    char conv;
+    // true if the conversion has no flags, width, precision or length modifiers that we cannot handle
+    // ourselves, in which case we do not need printf
+    bool plain;
+    // offset and length of literal runs in the format text
+    int off;
+    int len;
+    // the full conversion spec (e.g. "%08.3f"), used when the conversion is not plain
+    char spec[TAM_FMT_MAX_SPEC];
+} tam_fmt_op_t;
+
+typedef struct tam_fmt_t {
+    char *text;
+    tam_fmt_op_t *ops;
+    int count;
+    // total length of all literal runs, used to size the builder ahead of time
+    int literal_len;
+    // NULL if the format string was valid, otherwise a description of the problem and its offset in the string
+    const char *error;
+    int error_pos;
+} tam_fmt_t;
+
+/*
+ * Parse a printf-style format string into a compiled format.
+ * If the format is invalid, `error` is set on the result, which must still be freed with `fmt_deallocate`.
+ */
+tam_fmt_t tam_fmt_compile(const char *fmt);
+
+/*
+ * Free a compiled format
+ */
+void tam_fmt_deallocate(tam_fmt_t *fmt);
+
+/*
+ * Append a string to a StringBuilder using a compiled format.
+ * Arguments are passed exactly as they would be to `sb_appendf` with the original format string.
+ */
+void tam_sb_appendfmt(tam_stringbuilder_t *sb, const tam_fmt_t *fmt, ...);
+
+/*
+ * Like `sb_appendfmt`, but takes a va_list.
+ */
+void tam_sb_vappendfmt(tam_stringbuilder_t *sb, const tam_fmt_t *fmt, va_list va);
+
+// end compiled format declarations }}}
+
+//*** ## Type-generic append declarations *** {{{
+/*
+ * `sb_append(sb, x)` picks the appender matching the type of `x` at compile time:
+ * signed integers go to `sb_appendint`, unsigned integers to `sb_appenduint`, floats and doubles to
+ * `sb_appenddouble`, `bool` to `sb_appendbool`, `char` to `sb_appendchar`, `char*` to `sb_appendchars`
+ * and slices to `sb_appendslice`.
+ * In C this uses `_Generic`, in C++ it is a set of overloads.
+ * Note that in C character literals such as 'a' have type int, so `sb_append(sb, 'a')` appends "97".
+ * Use `sb_appendchar` for these.
+ *
+ * `sb_concat(sb, a, b, c, ...)` appends each of its (up to 12) arguments in the same way, but computes
+ * an upper bound on the total length first, so the builder grows at most once.
+ * Each argument is evaluated exactly once.
+ */
+
+typedef enum tam_sb_argtype_t {
+    TAM_SB_ARG_INT,
+    TAM_SB_ARG_UINT,
+    TAM_SB_ARG_DOUBLE,
+    TAM_SB_ARG_CHAR,
+    TAM_SB_ARG_SLICE,
+} tam_sb_argtype_t;
+
+typedef struct tam_sb_arg_t {
+    tam_sb_argtype_t type;
+    union {
+        i64 i;
+        u64 u;
+        f64 d;
+        char c;
+        tam_slice_t sl;
+    };
+} tam_sb_arg_t;
+
+/*
+ * Append a list of tagged arguments to a StringBuilder, growing the builder once.
+ * This is what `sb_concat` expands to.
+ */
+void tam_sb_concatn(tam_stringbuilder_t *sb, const tam_sb_arg_t *args, int n);
+
+static inline tam_sb_arg_t tam_sb_arg_int(i64 x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_INT;
+    a.i = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_uint(u64 x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_UINT;
+    a.u = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_double(f64 x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_DOUBLE;
+    a.d = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_char(char x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_CHAR;
+    a.c = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_slice(tam_slice_t x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_SLICE;
+    a.sl = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_chars(const char *x) {
+    tam_sb_arg_t a;
+    a.type = TAM_SB_ARG_SLICE;
+    a.sl.len = strlen(x);
+    a.sl.buf = x;
+    return a;
+}
+
+static inline tam_sb_arg_t tam_sb_arg_bool(bool x) { return tam_sb_arg_chars(x ? "true" : "false"); }
+
+#ifndef __cplusplus
+
+#define TAM_SB_GENERIC(x, prefix)                                                                                      \
+    _Generic((x),                                                                                                      \
+        bool: prefix##bool,                                                                                            \
+        char: prefix##char,                                                                                            \
+        signed char: prefix##int,                                                                                      \
+        short: prefix##int,                                                                                            \
+        int: prefix##int,                                                                                              \
+        long: prefix##int,                                                                                             \
+        long long: prefix##int,                                                                                        \
+        unsigned char: prefix##uint,                                                                                   \
+        unsigned short: prefix##uint,                                                                                  \
+        unsigned int: prefix##uint,                                                                                    \
+        unsigned long: prefix##uint,                                                                                   \
+        unsigned long long: prefix##uint,                                                                              \
+        float: prefix##double,                                                                                         \
+        double: prefix##double,                                                                                        \
+        char *: prefix##chars,                                                                                         \
+        const char *: prefix##chars,                                                                                   \
+        tam_slice_t: prefix##slice)
+
+#define tam_sb_append(sb, x) TAM_SB_GENERIC(x, tam_sb_append)(sb, x)
+#define tam_sb_arg(x) TAM_SB_GENERIC(x, tam_sb_arg_)(x)
+
+// argument counting and mapping for sb_concat
+#define TAM_SB_NARGS(...) TAM_SB_NARGS_(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TAM_SB_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+#define TAM_SB_ARGS_1(a) tam_sb_arg(a)
+#define TAM_SB_ARGS_2(a, ...) tam_sb_arg(a), TAM_SB_ARGS_1(__VA_ARGS__)
+#define TAM_SB_ARGS_3(a, ...) tam_sb_arg(a), TAM_SB_ARGS_2(__VA_ARGS__)
+#define TAM_SB_ARGS_4(a, ...) tam_sb_arg(a), TAM_SB_ARGS_3(__VA_ARGS__)
+#define TAM_SB_ARGS_5(a, ...) tam_sb_arg(a), TAM_SB_ARGS_4(__VA_ARGS__)
+#define TAM_SB_ARGS_6(a, ...) tam_sb_arg(a), TAM_SB_ARGS_5(__VA_ARGS__)
+#define TAM_SB_ARGS_7(a, ...) tam_sb_arg(a), TAM_SB_ARGS_6(__VA_ARGS__)
+#define TAM_SB_ARGS_8(a, ...) tam_sb_arg(a), TAM_SB_ARGS_7(__VA_ARGS__)
+#define TAM_SB_ARGS_9(a, ...) tam_sb_arg(a), TAM_SB_ARGS_8(__VA_ARGS__)
+#define TAM_SB_ARGS_10(a, ...) tam_sb_arg(a), TAM_SB_ARGS_9(__VA_ARGS__)
+#define TAM_SB_ARGS_11(a, ...) tam_sb_arg(a), TAM_SB_ARGS_10(__VA_ARGS__)
+#define TAM_SB_ARGS_12(a, ...) tam_sb_arg(a), TAM_SB_ARGS_11(__VA_ARGS__)
+#define TAM_SB_ARGS_(n) TAM_SB_ARGS_##n
+#define TAM_SB_ARGS(n) TAM_SB_ARGS_(n)
+
+#define tam_sb_concat(sb, ...)                                                                                         \
+    tam_sb_concatn((sb), (tam_sb_arg_t[]){TAM_SB_ARGS(TAM_SB_NARGS(__VA_ARGS__))(__VA_ARGS__)},                      \
+                   TAM_SB_NARGS(__VA_ARGS__))
+
+#endif // __cplusplus
+
+// end type-generic append declarations }}}
+
+//*** ## Segmented builder declarations *** {{{
+/*
+ * A segmented builder appends into a list of fixed-size chunks instead of one contiguous buffer.
+ * Growing never copies or reallocates existing data, so it is suited to very large outputs, where
+ * doubling a single buffer would copy everything and briefly need several times the final size.
+ * The chunks can be written out directly with `writev` using `segb_iovec` or `segb_write`,
+ * or copied into one contiguous string using `segb_flatten`.
+ * The user is responsible for freeing the builder using segb_deallocate when they are done with it.
+ */
+
+// same layout as the POSIX `struct iovec`
+typedef struct tam_iovec_t {
+    void *iov_base;
+    usize iov_len;
+} tam_iovec_t;
+
+#define TAM_SEGB_DEFAULT_CHUNK_SIZE (1 << 20)
+
+typedef struct tam_segbuilder_t {
+    // one entry per chunk, where iov_len is the number of bytes used in that chunk
+    tam_iovec_t *chunks;
+    int count;
+    int cap;
+    usize chunk_size;
+    usize len;
+} tam_segbuilder_t;
+
+/*
+ * Create an empty segmented builder with chunks of `chunk_size` bytes.
+ * A chunk size of 0 selects TAM_SEGB_DEFAULT_CHUNK_SIZE.
+ */
+tam_segbuilder_t tam_segb_new(usize chunk_size);
+
+/*
+ * Free a segmented builder and all of its chunks
+ */
+void tam_segb_deallocate(tam_segbuilder_t *sb);
+
+/*
+ * Append a char array with known length to a segmented builder
+ */
+void tam_segb_appendcharsn(tam_segbuilder_t *sb, const char *s, usize n);
+
+/*
+ * Append a char array to a segmented builder
+ */
+void tam_segb_appendchars(tam_segbuilder_t *sb, const char *s);
+
+/*
+ * Append a slice to a segmented builder
+ */
+void tam_segb_appendslice(tam_segbuilder_t *sb, tam_slice_t sl);
+
+/*
+ * Get the chunks of a segmented builder as an array of iovecs, suitable for passing to `writev`
+ * after a cast to `struct iovec *`.
+ * The number of chunks is written to `count`. The array is invalidated by any subsequent append.
+ */
+const tam_iovec_t *tam_segb_iovec(const tam_segbuilder_t *sb, int *count);
+
+/*
+ * Copy the contents of a segmented builder into a single contiguous char array.
+ * The returned char* is null-terminated, heap-allocated and must be freed by the user.
+ */
+char *tam_segb_flatten(const tam_segbuilder_t *sb);
+
+#if defined(__unix__) || defined(__APPLE__)
+/*
+ * Write the contents of a segmented builder to a file descriptor using `writev`, without copying.
+ * Returns the number of bytes written, or -1 on error (with errno set by `writev`).
+ */
+isize tam_segb_write(const tam_segbuilder_t *sb, int fd);
+#endif
+
+// end segmented builder declarations }}}
+
 #if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_STRINGS) ///{{{
 typedef tam_stringbuilder_t StringBuilder;
 #define sb_new tam_sb_new
+#define sb_new_arena tam_sb_new_arena
+#define sb_new_buffer tam_sb_new_buffer
+#define SB_INLINE TAM_SB_INLINE
+#define sb_new_file tam_sb_new_file
+#define sb_new_fd tam_sb_new_fd
+#define sb_flush tam_sb_flush
 #define sb_deallocate tam_sb_deallocate
+#define sb_clear tam_sb_clear
+#define sb_acquire tam_sb_acquire
+#define sb_release tam_sb_release
+#define sb_pool_drain tam_sb_pool_drain
 #define sb_appendslice tam_sb_appendslice
 #define sb_appendchars tam_sb_appendchars
 #define sb_appendcharsn tam_sb_appendcharsn
 #define sb_appendf tam_sb_appendf
 #define sb_tochars tam_sb_tochars
+#define sb_take tam_sb_take
+#define sb_view tam_sb_view
+#define sb_reserve tam_sb_reserve
+#define sb_commit tam_sb_commit
+#define sb_join_parallel tam_sb_join_parallel
+#define sb_appendint tam_sb_appendint
+#define sb_appenduint tam_sb_appenduint
+#define sb_appendhex tam_sb_appendhex
+#define sb_appendchar tam_sb_appendchar
+#define sb_appendbool tam_sb_appendbool
+#define sb_appenddouble tam_sb_appenddouble
+#define sb_append_lower tam_sb_append_lower
+#define sb_append_upper tam_sb_append_upper
+#define sb_append tam_sb_append
+#define sb_concat tam_sb_concat
+typedef tam_segbuilder_t SegmentedBuilder;
+#define segb_new tam_segb_new
+#define segb_deallocate tam_segb_deallocate
+#define segb_appendcharsn tam_segb_appendcharsn
+#define segb_appendchars tam_segb_appendchars
+#define segb_appendslice tam_segb_appendslice
+#define segb_iovec tam_segb_iovec
+#define segb_flatten tam_segb_flatten
+#define segb_write tam_segb_write
+typedef tam_fmt_t Format;
+#define fmt_compile tam_fmt_compile
+#define fmt_deallocate tam_fmt_deallocate
+#define sb_appendfmt tam_sb_appendfmt
+#define sb_vappendfmt tam_sb_vappendfmt
 #endif // end StringBuilder namespace }}}
 
-// end StringBuilder declarations }}}
 //
 // ### StringBuilder implementation {{{
 
@@ -76,30 +597,176 @@ typedef tam_stringbuilder_t StringBuilder;
 
 #if defined(TAM_IMPLEMENTATION)
 
-tam_stringbuilder_t tam_sb_new() { return (tam_stringbuilder_t){.cap = 0, .len = 0, .buf = NULL}; }
+#include <errno.h>
+#include <limits.h>
+#include <tam/errors.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+tam_stringbuilder_t tam_sb_new() {
+    return (tam_stringbuilder_t){.cap = 0, .len = 0, .buf = NULL, .arena = NULL, .file = NULL, .fd = -1};
+}
+
+tam_stringbuilder_t tam_sb_new_arena(tam_arena_t *arena) {
+    return (tam_stringbuilder_t){.cap = 0, .len = 0, .buf = NULL, .arena = arena, .file = NULL, .fd = -1};
+}
+
+tam_stringbuilder_t tam_sb_new_buffer(char *storage, isize cap, tam_arena_t *arena) {
+    tam_stringbuilder_t sb = tam_sb_new();
+    sb.buf = storage;
+    sb.cap = cap;
+    sb.arena = arena;
+    sb.inline_buf = true;
+    return sb;
+}
+
+tam_stringbuilder_t tam_sb_new_file(FILE *file, int flush_at) {
+    tam_stringbuilder_t sb = tam_sb_new();
+    sb.file = file;
+    sb.flush_at = flush_at > 0 ? flush_at : TAM_SB_DEFAULT_FLUSH_AT;
+    return sb;
+}
+
+tam_stringbuilder_t tam_sb_new_fd(int fd, int flush_at) {
+    tam_stringbuilder_t sb = tam_sb_new();
+    sb.fd = fd;
+    sb.flush_at = flush_at > 0 ? flush_at : TAM_SB_DEFAULT_FLUSH_AT;
+    return sb;
+}
+
+// Write n bytes to the builder's file or file descriptor
+static void tam_sb_write(tam_stringbuilder_t *sb, const char *s, usize n) {
+    if (sb->file != NULL) {
+        if (fwrite(s, 1, n, sb->file) != n)
+            sb->write_error = true;
+        return;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    while (n > 0) {
+        isize written = write(sb->fd, s, n);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            sb->write_error = true;
+            return;
+        }
+        s += written;
+        n -= written;
+    }
+#else
+    sb->write_error = true;
+#endif
+}
+
+bool tam_sb_flush(tam_stringbuilder_t *sb) {
+    if (sb->flush_at == 0)
+        return true;
+    if (sb->len > 0)
+        tam_sb_write(sb, sb->buf, sb->len);
+    sb->len = 0;
+    if (sb->file != NULL && fflush(sb->file) != 0)
+        sb->write_error = true;
+    return !sb->write_error;
+}
+
+// Called after every append, so that streaming builders stay below their flush threshold
+static inline void tam_sb_check_flush(tam_stringbuilder_t *sb) {
+    if (sb->flush_at > 0 && sb->len >= sb->flush_at) {
+        tam_sb_write(sb, sb->buf, sb->len);
+        sb->len = 0;
+    }
+}
 
 void tam_sb_deallocate(tam_stringbuilder_t *sb) {
-    free(sb->buf);
+    tam_sb_flush(sb);
+    if (sb->inline_buf)
+        sb->inline_buf = false;
+    else if (sb->arena != NULL)
+        tam_arena_release(sb->arena, sb->buf, sb->cap);
+    else
+        TAM_deallocate_sized(sb->buf, sb->cap);
+    sb->buf = NULL;
     sb->cap = 0;
     sb->len = 0;
 }
 
+void tam_sb_clear(tam_stringbuilder_t *sb) {
+    tam_sb_flush(sb);
+    sb->len = 0;
+}
+
+static _Thread_local tam_stringbuilder_t tam_sb_pool[TAM_SB_POOL_SIZE];
+static _Thread_local int tam_sb_pool_count = 0;
+
+tam_stringbuilder_t tam_sb_acquire() {
+    if (tam_sb_pool_count > 0)
+        return tam_sb_pool[--tam_sb_pool_count];
+    return tam_sb_new();
+}
+
+void tam_sb_release(tam_stringbuilder_t *sb) {
+    bool plain = sb->arena == NULL && !sb->inline_buf && sb->flush_at == 0;
+    if (plain && sb->buf != NULL && sb->cap <= TAM_SB_POOL_MAX_CAPACITY && tam_sb_pool_count < TAM_SB_POOL_SIZE) {
+        sb->len = 0;
+        tam_sb_pool[tam_sb_pool_count++] = *sb;
+        *sb = tam_sb_new();
+        return;
+    }
+    tam_sb_deallocate(sb);
+}
+
+void tam_sb_pool_drain() {
+    while (tam_sb_pool_count > 0)
+        tam_sb_deallocate(&tam_sb_pool[--tam_sb_pool_count]);
+}
+
 static void tam_sb_grow(tam_stringbuilder_t *sb, usize newlen) {
-    if (newlen <= sb->cap)
+    if (newlen <= (usize)sb->cap)
         return;
-    usize newcap = sb->buf == NULL ? TAM_SB_INITIAL_CAPACITY : 2 * sb->cap;
-    if (newcap < newlen)
-        newcap = newlen + 1;
-    sb->buf = tam_reallocate(sb->buf, char, newcap);
+    usize newcap;
+    if (sb->buf == NULL && newlen <= TAM_SB_INITIAL_CAPACITY) {
+        newcap = TAM_SB_INITIAL_CAPACITY;
+    } else if (sb->arena != NULL) {
+        // arena buffers are never mapped, so rounding them to whole pages would only waste the arena
+        newcap = (usize)(sb->cap * TAM_GROWTH_FACTOR);
+        newcap = newcap > newlen + 1 ? newcap : newlen + 1;
+        newcap = (newcap + 15) & ~(usize)15;
+    } else {
+        // large buffers are rounded to whole pages and grown with mremap where possible, see memory.h
+        newcap = tam_grow_capacity(sb->cap, newlen + 1);
+    }
+    if (sb->inline_buf) {
+        // spill out of the caller's storage
+        char *buf = sb->arena != NULL ? tam_arena_alloc(sb->arena, char, newcap)
+                                      : tam_reallocate_sized(NULL, char, 0, newcap);
+        memcpy(buf, sb->buf, sb->len);
+        sb->buf = buf;
+        sb->inline_buf = false;
+    } else if (sb->arena != NULL) {
+        sb->buf = tam_arena_realloc(sb->arena, sb->buf, char, sb->cap, newcap);
+    } else {
+        sb->buf = tam_reallocate_sized(sb->buf, char, sb->cap, newcap);
+    }
     sb->cap = newcap;
 }
 
 // Appending
 void tam_sb_appendcharsn(tam_stringbuilder_t *sb, const char *s, usize n) {
+    if (n == 0)
+        return;
+    // large appends to streaming builders skip the buffer entirely
+    if (sb->flush_at > 0 && n >= (usize)sb->flush_at) {
+        tam_sb_flush(sb);
+        tam_sb_write(sb, s, n);
+        return;
+    }
     usize newlen = sb->len + n;
     tam_sb_grow(sb, newlen);
     memcpy(sb->buf + sb->len, s, n);
     sb->len = newlen;
+    tam_sb_check_flush(sb);
 }
 
 void tam_sb_appendslice(tam_stringbuilder_t *sb, tam_slice_t sl) { tam_sb_appendcharsn(sb, sl.buf, sl.len); }
@@ -107,21 +774,130 @@ void tam_sb_appendslice(tam_stringbuilder_t *sb, tam_slice_t sl) { tam_sb_append
 void tam_sb_appendchars(tam_stringbuilder_t *sb, const char *s) { tam_sb_appendcharsn(sb, s, strlen(s)); }
 
 void tam_sb_appendf(tam_stringbuilder_t *sb, const char *fmt, ...) {
-    va_list va;
+    va_list va, retry;
     va_start(va, fmt);
-    // first, determine size
-    int size = vsnprintf(NULL, 0, fmt, va);
+    // keep a copy of the arguments in case we need to format a second time
+    va_copy(retry, va);
+
+    // make sure there is at least room for the literal part of the format string and the null terminator,
+    // so that most short formats succeed in a single pass
+    tam_sb_grow(sb, sb->len + strlen(fmt) + 1);
+
+    // try to print directly into the spare capacity of the buffer
+    usize spare = sb->cap - sb->len;
+    int size = vsnprintf(sb->buf + sb->len, spare, fmt, va);
     va_end(va);
 
-    // Next, allocated needed memory
-    // need to restart va_list as it becomes invalidated after vsnprintf
-    va_start(va, fmt);
-    tam_sb_grow(sb, sb->len + size + 1);
-    // finally, print formatted string to newly-allocated memory and increment length
-    vsprintf(sb->buf + sb->len, fmt, va);
+    if (size < 0) {
+        va_end(retry);
+        return;
+    }
+
+    // output was truncated -- grow to fit the formatted string plus a null terminator and print again
+    if ((usize)size >= spare) {
+        tam_sb_grow(sb, sb->len + size + 1);
+        vsnprintf(sb->buf + sb->len, size + 1, fmt, retry);
+    }
+    va_end(retry);
+
+    // vsnprintf null-terminates the output, so the builder contents are a valid C string after this call
     sb->len += size;
+    tam_sb_check_flush(sb);
+}
 
-    va_end(va);
+static const char tam_sb_digit_pairs[201] = "00010203040506070809"
+                                            "10111213141516171819"
+                                            "20212223242526272829"
+                                            "30313233343536373839"
+                                            "40414243444546474849"
+                                            "50515253545556575859"
+                                            "60616263646566676869"
+                                            "70717273747576777879"
+                                            "80818283848586878889"
+                                            "90919293949596979899";
+
+// Write the decimal digits of x backwards, ending at `end`. Returns a pointer to the first digit.
+static char *tam_sb_format_u64(char *end, u64 x) {
+    char *p = end;
+    // two digits at a time to halve the number of divisions
+    while (x >= 100) {
+        u64 r = x % 100;
+        x /= 100;
+        p -= 2;
+        memcpy(p, tam_sb_digit_pairs + 2 * r, 2);
+    }
+    if (x >= 10) {
+        p -= 2;
+        memcpy(p, tam_sb_digit_pairs + 2 * x, 2);
+    } else {
+        *--p = (char)('0' + x);
+    }
+    return p;
+}
+
+void tam_sb_appenduint(tam_stringbuilder_t *sb, u64 x) {
+    char buf[20];
+    char *end = buf + sizeof(buf);
+    char *start = tam_sb_format_u64(end, x);
+    tam_sb_appendcharsn(sb, start, end - start);
+}
+
+void tam_sb_appendint(tam_stringbuilder_t *sb, i64 x) {
+    char buf[21];
+    char *end = buf + sizeof(buf);
+    // negate in unsigned arithmetic so that INT64_MIN is handled correctly
+    u64 mag = x < 0 ? -(u64)x : (u64)x;
+    char *start = tam_sb_format_u64(end, mag);
+    if (x < 0)
+        *--start = '-';
+    tam_sb_appendcharsn(sb, start, end - start);
+}
+
+void tam_sb_appendhex(tam_stringbuilder_t *sb, u64 x, bool upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buf[16];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    do {
+        *--p = digits[x & 0xf];
+        x >>= 4;
+    } while (x != 0);
+    tam_sb_appendcharsn(sb, p, end - p);
+}
+
+void tam_sb_appendchar(tam_stringbuilder_t *sb, char c) {
+    tam_sb_grow(sb, sb->len + 1);
+    sb->buf[sb->len++] = c;
+    tam_sb_check_flush(sb);
+}
+
+void tam_sb_appendbool(tam_stringbuilder_t *sb, bool x) {
+    if (x)
+        tam_sb_appendcharsn(sb, "true", 4);
+    else
+        tam_sb_appendcharsn(sb, "false", 5);
+}
+
+void tam_sb_appenddouble(tam_stringbuilder_t *sb, f64 x) {
+    // for normal doubles, a shortest round-tripping representation with at most 15 digits is exactly what %.15g
+    // prints once %g has dropped the trailing zeros. Otherwise add digits until it round-trips, which 17 always does.
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.15g", x);
+    if (x == x) {
+        for (int digits = 16; digits <= 17 && strtod(buf, NULL) != x; digits++)
+            n = snprintf(buf, sizeof(buf), "%.*g", digits, x);
+    }
+    tam_sb_appendcharsn(sb, buf, n);
+}
+
+void tam_sb_append_lower(tam_stringbuilder_t *sb, tam_slice_t s) {
+    tam_sl_tolower(tam_sb_reserve(sb, s.len), s);
+    tam_sb_commit(sb, s.len);
+}
+
+void tam_sb_append_upper(tam_stringbuilder_t *sb, tam_slice_t s) {
+    tam_sl_toupper(tam_sb_reserve(sb, s.len), s);
+    tam_sb_commit(sb, s.len);
 }
 
 // string creation
@@ -131,8 +907,538 @@ char *tam_sb_tochars(tam_stringbuilder_t sb) {
     return buf;
 }
 
+char *tam_sb_take(tam_stringbuilder_t *sb, bool shrink) {
+    // the caller's storage can't be handed over, so move the contents out of it first
+    if (sb->inline_buf)
+        tam_sb_grow(sb, sb->cap + 1);
+    // make room for the null terminator
+    tam_sb_grow(sb, sb->len + 1);
+    if (sb->arena != NULL) {
+        if (shrink && sb->cap > sb->len + 1)
+            tam_arena_release(sb->arena, sb->buf + sb->len + 1, sb->cap - sb->len - 1);
+    } else if ((usize)sb->cap >= TAM_MMAP_THRESHOLD) {
+        // the caller frees the string with free(), which can't release a mapping
+        char *buf = tam_allocate(char, sb->len + 1);
+        memcpy(buf, sb->buf, sb->len);
+        tam_deallocate_sized(sb->buf, char, sb->cap);
+        sb->buf = buf;
+    } else if (shrink && sb->cap > sb->len + 1) {
+        sb->buf = tam_reallocate(sb->buf, char, sb->len + 1);
+    }
+    char *buf = sb->buf;
+    buf[sb->len] = '\0';
+
+    sb->buf = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    return buf;
+}
+
+tam_slice_t tam_sb_view(const tam_stringbuilder_t *sb) {
+    if (sb->len > INT_MAX)
+        tam_errorf("tam_sb_view: a builder of %zd bytes is too long to view as a slice", sb->len);
+    return tam_slice_n(sb->buf, sb->len);
+}
+
+char *tam_sb_reserve(tam_stringbuilder_t *sb, usize n) {
+    tam_sb_grow(sb, sb->len + n);
+    return sb->buf + sb->len;
+}
+
+void tam_sb_commit(tam_stringbuilder_t *sb, usize n) {
+    assert(sb->len + n <= (usize)sb->cap);
+    sb->len += n;
+    tam_sb_check_flush(sb);
+}
+
+// below this many bytes per thread, starting threads costs more than the copying
+#define TAM_SB_JOIN_MIN_BYTES_PER_THREAD (1 << 20)
+
+typedef struct tam_sb_join_job_t {
+    char *dst;
+    const tam_stringbuilder_t *parts;
+    const usize *offsets;
+    int n;
+    // byte range of the output that this job copies
+    usize beg;
+    usize end;
+} tam_sb_join_job_t;
+
+static void *tam_sb_join_worker(void *arg) {
+    tam_sb_join_job_t *job = (tam_sb_join_job_t *)arg;
+    // binary search for the last part that starts at or before `beg`
+    int lo = 0, hi = job->n - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (job->offsets[mid] <= job->beg)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    usize pos = job->beg;
+    for (int i = lo; i < job->n && pos < job->end; i++) {
+        usize part_end = job->offsets[i] + job->parts[i].len;
+        usize stop = part_end < job->end ? part_end : job->end;
+        if (stop > pos)
+            memcpy(job->dst + pos, job->parts[i].buf + (pos - job->offsets[i]), stop - pos);
+        pos = stop > pos ? stop : pos;
+    }
+    return NULL;
+}
+
+void tam_sb_join_parallel(tam_stringbuilder_t *dst, const tam_stringbuilder_t *parts, int n, int nthreads) {
+    if (n <= 0)
+        return;
+
+    // streaming builders have to go through the regular append path to flush correctly
+    if (dst->flush_at > 0) {
+        for (int i = 0; i < n; i++)
+            tam_sb_appendcharsn(dst, parts[i].buf, parts[i].len);
+        return;
+    }
+
+    // prefix sum of part lengths gives the offset of each part in the output
+    usize *offsets = tam_allocate(usize, n);
+    usize total = 0;
+    for (int i = 0; i < n; i++) {
+        offsets[i] = total;
+        total += (usize)parts[i].len;
+    }
+    // fail before writing anything if the joined output would not fit in a builder
+    if (total > (usize)PTRDIFF_MAX - (usize)dst->len)
+        tam_errorf("tam_sb_join_parallel: joining %zu bytes to a builder of %zd bytes overflows it", total, dst->len);
+    tam_sb_grow(dst, (usize)dst->len + total);
+    char *out = dst->buf + dst->len;
+
+#if defined(__unix__) || defined(__APPLE__)
+    if (nthreads <= 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    usize max_threads = total / TAM_SB_JOIN_MIN_BYTES_PER_THREAD;
+    if ((usize)nthreads > max_threads)
+        nthreads = max_threads;
+    if (nthreads < 1)
+        nthreads = 1;
+
+    tam_sb_join_job_t *jobs = tam_allocate(tam_sb_join_job_t, nthreads);
+    for (int t = 0; t < nthreads; t++) {
+        jobs[t] = (tam_sb_join_job_t){.dst = out,
+                                      .parts = parts,
+                                      .offsets = offsets,
+                                      .n = n,
+                                      .beg = total / nthreads * t,
+                                      .end = t == nthreads - 1 ? total : total / nthreads * (t + 1)};
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // the calling thread takes the first job itself
+    pthread_t *threads = tam_allocate(pthread_t, nthreads);
+    bool *started = tam_allocate(bool, nthreads);
+    for (int t = 1; t < nthreads; t++)
+        started[t] = pthread_create(&threads[t], NULL, tam_sb_join_worker, &jobs[t]) == 0;
+    tam_sb_join_worker(&jobs[0]);
+    for (int t = 1; t < nthreads; t++) {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+        else
+            tam_sb_join_worker(&jobs[t]);
+    }
+    tam_deallocate(threads);
+    tam_deallocate(started);
+#else
+    for (int t = 0; t < nthreads; t++)
+        tam_sb_join_worker(&jobs[t]);
+#endif
+
+    dst->len += (isize)total;
+    tam_deallocate(jobs);
+    tam_deallocate(offsets);
+}
+
 // end StringBuilder implementation }}}
 
+// ### Compiled format implementation {{{
+
+static void tam_fmt_push(tam_fmt_t *fmt, int *cap, tam_fmt_op_t op) {
+    if (fmt->count == *cap) {
+        *cap = *cap == 0 ? 8 : 2 * *cap;
+        fmt->ops = tam_reallocate(fmt->ops, tam_fmt_op_t, *cap);
+    }
+    fmt->ops[fmt->count++] = op;
+}
+
+// Record an error at offset `pos` of the format string, and drop the operations parsed so far
+static tam_fmt_t tam_fmt_error(tam_fmt_t *fmt, const char *msg, int pos) {
+    fmt->error = msg;
+    fmt->error_pos = pos;
+    fmt->count = 0;
+    fmt->literal_len = 0;
+    return *fmt;
+}
+
+tam_fmt_t tam_fmt_compile(const char *fmt_str) {
+    int n = strlen(fmt_str);
+    tam_fmt_t fmt = {
+        .text = tam_allocate(char, n + 1), .ops = NULL, .count = 0, .literal_len = 0, .error = NULL, .error_pos = 0};
+    memcpy(fmt.text, fmt_str, n);
+    int cap = 0;
+
+    const char *s = fmt.text;
+    int i = 0;
+    while (i < n) {
+        // literal run, up to the next conversion
+        int start = i;
+        while (i < n && s[i] != '%')
+            i++;
+        // "%%" is a literal percent sign -- include the first one in the run and skip the second
+        if (i + 1 < n && s[i + 1] == '%') {
+            i++;
+            tam_fmt_push(&fmt, &cap, (tam_fmt_op_t){.arg = TAM_FMT_LITERAL, .off = start, .len = i - start});
+            fmt.literal_len += i - start;
+            i++;
+            continue;
+        }
+        if (i > start) {
+            tam_fmt_push(&fmt, &cap, (tam_fmt_op_t){.arg = TAM_FMT_LITERAL, .off = start, .len = i - start});
+            fmt.literal_len += i - start;
+        }
+        if (i >= n)
+            break;
+
+        // conversion: %[flags][width][.precision][length]conv
+        int spec_start = i++;
+        bool plain = true;
+        while (i < n && strchr("-+ #0", s[i]))
+            i++, plain = false;
+        while (i < n && (s[i] >= '0' && s[i] <= '9'))
+            i++, plain = false;
+        if (i < n && s[i] == '.') {
+            i++, plain = false;
+            while (i < n && (s[i] >= '0' && s[i] <= '9'))
+                i++;
+        }
+        if (i < n && s[i] == '*')
+            return tam_fmt_error(&fmt, "`*` widths and precisions are not supported", i);
+
+        // length modifiers
+        int longs = 0;
+        bool size = false, long_double = false;
+        while (i < n && strchr("hlzjtL", s[i])) {
+            if (s[i] == 'l')
+                longs++;
+            else if (s[i] == 'z' || s[i] == 't' || s[i] == 'j')
+                size = true;
+            else if (s[i] == 'L')
+                long_double = true;
+            else if (s[i] == 'h')
+                plain = false;
+            i++;
+        }
+        if (i >= n)
+            return tam_fmt_error(&fmt, "incomplete conversion", spec_start);
+        // `L` only applies to floating point conversions, which read a long double
+        if (long_double && !strchr("fFeEgGaA", s[i]))
+            return tam_fmt_error(&fmt, "`L` is only valid for floating point conversions", i);
+
+        tam_fmt_op_t op = {.conv = s[i], .plain = plain};
+        switch (s[i]) {
+        case 'd':
+        case 'i':
+            op.arg = size ? TAM_FMT_ISIZE : longs == 0 ? TAM_FMT_INT : longs == 1 ? TAM_FMT_LONG : TAM_FMT_LLONG;
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            op.arg = size ? TAM_FMT_USIZE : longs == 0 ? TAM_FMT_UINT : longs == 1 ? TAM_FMT_ULONG : TAM_FMT_ULLONG;
+            op.plain = plain && s[i] != 'o';
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            op.arg = long_double ? TAM_FMT_LDOUBLE : TAM_FMT_DOUBLE;
+            // we leave floating point formatting to printf
+            op.plain = false;
+            break;
+        case 'c':
+            op.arg = TAM_FMT_CHAR;
+            op.plain = plain && longs == 0;
+            break;
+        case 's':
+            op.arg = TAM_FMT_STR;
+            op.plain = plain && longs == 0;
+            break;
+        case 'p':
+            op.arg = TAM_FMT_PTR;
+            op.plain = false;
+            break;
+        default:
+            return tam_fmt_error(&fmt, "unsupported conversion", i);
+        }
+        i++;
+
+        int spec_len = i - spec_start;
+        if (spec_len >= TAM_FMT_MAX_SPEC)
+            return tam_fmt_error(&fmt, "conversion spec too long", spec_start);
+        memcpy(op.spec, s + spec_start, spec_len);
+        op.spec[spec_len] = '\0';
+        tam_fmt_push(&fmt, &cap, op);
+    }
+    return fmt;
+}
+
+void tam_fmt_deallocate(tam_fmt_t *fmt) {
+    tam_deallocate(fmt->text);
+    tam_deallocate(fmt->ops);
+    fmt->count = 0;
+    fmt->literal_len = 0;
+}
+
+// Format an integer argument, either using the fast appenders or printf
+static void tam_fmt_appendint(tam_stringbuilder_t *sb, const tam_fmt_op_t *op, bool is_signed, u64 x) {
+    if (!op->plain) {
+        // the spec's length modifier tells printf how wide the argument is,
+        // so pass it with the same type it was read as
+        switch (op->arg) {
+        case TAM_FMT_INT: tam_sb_appendf(sb, op->spec, (int)x); break;
+        case TAM_FMT_UINT: tam_sb_appendf(sb, op->spec, (unsigned)x); break;
+        case TAM_FMT_LONG: tam_sb_appendf(sb, op->spec, (long)x); break;
+        case TAM_FMT_ULONG: tam_sb_appendf(sb, op->spec, (unsigned long)x); break;
+        case TAM_FMT_LLONG: tam_sb_appendf(sb, op->spec, (long long)x); break;
+        case TAM_FMT_ULLONG: tam_sb_appendf(sb, op->spec, (unsigned long long)x); break;
+        case TAM_FMT_ISIZE: tam_sb_appendf(sb, op->spec, (isize)x); break;
+        default: tam_sb_appendf(sb, op->spec, (usize)x); break;
+        }
+        return;
+    }
+    if (op->conv == 'x' || op->conv == 'X')
+        tam_sb_appendhex(sb, x, op->conv == 'X');
+    else if (is_signed)
+        tam_sb_appendint(sb, (i64)x);
+    else
+        tam_sb_appenduint(sb, x);
+}
+
+void tam_sb_vappendfmt(tam_stringbuilder_t *sb, const tam_fmt_t *fmt, va_list va) {
+    // the literal text is always written, so reserve room for it up front
+    tam_sb_grow(sb, sb->len + fmt->literal_len);
+
+    for (int i = 0; i < fmt->count; i++) {
+        const tam_fmt_op_t *op = &fmt->ops[i];
+        switch (op->arg) {
+        case TAM_FMT_LITERAL:
+            tam_sb_appendcharsn(sb, fmt->text + op->off, op->len);
+            break;
+        case TAM_FMT_INT:
+            tam_fmt_appendint(sb, op, true, (u64)(i64)va_arg(va, int));
+            break;
+        case TAM_FMT_LONG:
+            tam_fmt_appendint(sb, op, true, (u64)(i64)va_arg(va, long));
+            break;
+        case TAM_FMT_LLONG:
+            tam_fmt_appendint(sb, op, true, (u64)(i64)va_arg(va, long long));
+            break;
+        case TAM_FMT_ISIZE:
+            tam_fmt_appendint(sb, op, true, (u64)(i64)va_arg(va, isize));
+            break;
+        case TAM_FMT_UINT:
+            tam_fmt_appendint(sb, op, false, va_arg(va, unsigned));
+            break;
+        case TAM_FMT_ULONG:
+            tam_fmt_appendint(sb, op, false, va_arg(va, unsigned long));
+            break;
+        case TAM_FMT_ULLONG:
+            tam_fmt_appendint(sb, op, false, va_arg(va, unsigned long long));
+            break;
+        case TAM_FMT_USIZE:
+            tam_fmt_appendint(sb, op, false, va_arg(va, usize));
+            break;
+        case TAM_FMT_DOUBLE:
+            tam_sb_appendf(sb, op->spec, va_arg(va, double));
+            break;
+        case TAM_FMT_LDOUBLE:
+            tam_sb_appendf(sb, op->spec, va_arg(va, long double));
+            break;
+        case TAM_FMT_CHAR: {
+            char c = (char)va_arg(va, int);
+            if (op->plain)
+                tam_sb_appendcharsn(sb, &c, 1);
+            else
+                tam_sb_appendf(sb, op->spec, c);
+            break;
+        }
+        case TAM_FMT_STR: {
+            const char *str = va_arg(va, const char *);
+            if (op->plain)
+                tam_sb_appendchars(sb, str);
+            else
+                tam_sb_appendf(sb, op->spec, str);
+            break;
+        }
+        case TAM_FMT_PTR:
+            tam_sb_appendf(sb, op->spec, va_arg(va, void *));
+            break;
+        }
+    }
+}
+
+void tam_sb_appendfmt(tam_stringbuilder_t *sb, const tam_fmt_t *fmt, ...) {
+    va_list va;
+    va_start(va, fmt);
+    tam_sb_vappendfmt(sb, fmt, va);
+    va_end(va);
+}
+
+// end compiled format implementation }}}
+
+// ### Type-generic append implementation {{{
+
+void tam_sb_concatn(tam_stringbuilder_t *sb, const tam_sb_arg_t *args, int n) {
+    // compute an upper bound on the appended length, so that we grow only once
+    usize total = 0;
+    for (int i = 0; i < n; i++) {
+        switch (args[i].type) {
+        case TAM_SB_ARG_INT: total += 20; break;
+        case TAM_SB_ARG_UINT: total += 20; break;
+        case TAM_SB_ARG_DOUBLE: total += 32; break;
+        case TAM_SB_ARG_CHAR: total += 1; break;
+        case TAM_SB_ARG_SLICE: total += args[i].sl.len; break;
+        }
+    }
+    tam_sb_grow(sb, sb->len + total);
+
+    for (int i = 0; i < n; i++) {
+        switch (args[i].type) {
+        case TAM_SB_ARG_INT: tam_sb_appendint(sb, args[i].i); break;
+        case TAM_SB_ARG_UINT: tam_sb_appenduint(sb, args[i].u); break;
+        case TAM_SB_ARG_DOUBLE: tam_sb_appenddouble(sb, args[i].d); break;
+        case TAM_SB_ARG_CHAR: tam_sb_appendchar(sb, args[i].c); break;
+        case TAM_SB_ARG_SLICE: tam_sb_appendslice(sb, args[i].sl); break;
+        }
+    }
+}
+
+// end type-generic append implementation }}}
+
+// ### Segmented builder implementation {{{
+
+tam_segbuilder_t tam_segb_new(usize chunk_size) {
+    if (chunk_size == 0)
+        chunk_size = TAM_SEGB_DEFAULT_CHUNK_SIZE;
+    return (tam_segbuilder_t){.chunks = NULL, .count = 0, .cap = 0, .chunk_size = chunk_size, .len = 0};
+}
+
+void tam_segb_deallocate(tam_segbuilder_t *sb) {
+    for (int i = 0; i < sb->count; i++)
+        free(sb->chunks[i].iov_base);
+    tam_deallocate(sb->chunks);
+    sb->count = 0;
+    sb->cap = 0;
+    sb->len = 0;
+}
+
+static void tam_segb_newchunk(tam_segbuilder_t *sb) {
+    if (sb->count == sb->cap) {
+        // only the (small) array of chunk pointers is ever reallocated
+        sb->cap = sb->cap == 0 ? 8 : 2 * sb->cap;
+        sb->chunks = tam_reallocate(sb->chunks, tam_iovec_t, sb->cap);
+    }
+    sb->chunks[sb->count].iov_base = tam_reallocate(NULL, char, sb->chunk_size);
+    sb->chunks[sb->count].iov_len = 0;
+    sb->count++;
+}
+
+void tam_segb_appendcharsn(tam_segbuilder_t *sb, const char *s, usize n) {
+    sb->len += n;
+    while (n > 0) {
+        if (sb->count == 0 || sb->chunks[sb->count - 1].iov_len == sb->chunk_size)
+            tam_segb_newchunk(sb);
+        tam_iovec_t *chunk = &sb->chunks[sb->count - 1];
+        usize room = sb->chunk_size - chunk->iov_len;
+        usize k = n < room ? n : room;
+        memcpy((char *)chunk->iov_base + chunk->iov_len, s, k);
+        chunk->iov_len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+void tam_segb_appendchars(tam_segbuilder_t *sb, const char *s) { tam_segb_appendcharsn(sb, s, strlen(s)); }
+
+void tam_segb_appendslice(tam_segbuilder_t *sb, tam_slice_t sl) { tam_segb_appendcharsn(sb, sl.buf, sl.len); }
+
+const tam_iovec_t *tam_segb_iovec(const tam_segbuilder_t *sb, int *count) {
+    *count = sb->count;
+    return sb->chunks;
+}
+
+char *tam_segb_flatten(const tam_segbuilder_t *sb) {
+    char *buf = tam_allocate(char, sb->len + 1);
+    char *p = buf;
+    for (int i = 0; i < sb->count; i++) {
+        memcpy(p, sb->chunks[i].iov_base, sb->chunks[i].iov_len);
+        p += sb->chunks[i].iov_len;
+    }
+    return buf;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(tam_iovec_t) == sizeof(struct iovec) &&
+                   offsetof(tam_iovec_t, iov_base) == offsetof(struct iovec, iov_base) &&
+                   offsetof(tam_iovec_t, iov_len) == offsetof(struct iovec, iov_len),
+               "tam_iovec_t must match struct iovec");
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+isize tam_segb_write(const tam_segbuilder_t *sb, int fd) {
+    isize total = 0;
+    int i = 0;
+    // bytes of chunk i that have already been written by a partial write
+    usize done = 0;
+    while (i < sb->count) {
+        struct iovec iov[64];
+        int n = 0;
+        int max = IOV_MAX < 64 ? IOV_MAX : 64;
+        for (int j = i; j < sb->count && n < max; j++, n++) {
+            usize skip = j == i ? done : 0;
+            iov[n].iov_base = (char *)sb->chunks[j].iov_base + skip;
+            iov[n].iov_len = sb->chunks[j].iov_len - skip;
+        }
+        isize written = writev(fd, iov, n);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        total += written;
+        // advance past the chunks that were written completely
+        usize w = written;
+        while (i < sb->count && w >= sb->chunks[i].iov_len - done) {
+            w -= sb->chunks[i].iov_len - done;
+            done = 0;
+            i++;
+        }
+        done += w;
+    }
+    return total;
+}
+#endif
+
+// end segmented builder implementation }}}
+
 #if defined(TAM_TEST)
 
 // ### StringBuilder tests {{{
@@ -151,6 +1457,7 @@ int tam_test_stringbuilders() {
     tam_sb_appendf(&sb, "%s", ", ");
     assert(sb.cap == TAM_SB_INITIAL_CAPACITY);
     assert(sb.len == 7);
+    assert(sb.buf[sb.len] == '\0');
 
     tam_sb_appendchars(&sb, "world!");
     assert(sb.cap == TAM_SB_INITIAL_CAPACITY);
@@ -159,13 +1466,344 @@ int tam_test_stringbuilders() {
     tam_slice_t next = slice(" Here's another sentence that should cause the buffer to reallocate.");
     tam_sb_appendslice(&sb, next);
     assert((int)sb.len == 13 + next.len);
-    assert((int)sb.cap == 13 + next.len + 1);
+    assert((int)sb.cap >= 13 + next.len + 1);
+    assert(sb.cap % 16 == 0);
 
     char *sentence = tam_sb_tochars(sb);
     const char *expected = "Hello, world! Here's another sentence that should cause the buffer to reallocate.";
     assert(strcmp(sentence, expected) == 0);
     tam_deallocate(sentence);
 
+    // formatted output that does not fit in the spare capacity
+    tam_stringbuilder_t sb2 = tam_sb_new();
+    tam_sb_appendf(&sb2, "%d-%s-%d", 12345, expected, 67890);
+    assert(sb2.len == 12 + (int)strlen(expected));
+    assert(sb2.buf[sb2.len] == '\0');
+    assert(strncmp(sb2.buf + 6, expected, strlen(expected)) == 0);
+    tam_sb_deallocate(&sb2);
+
+    // number formatting and compiled formats
+    {
+        tam_stringbuilder_t a = tam_sb_new(), b = tam_sb_new();
+        tam_sb_appendint(&a, INT64_MIN);
+        tam_sb_appendchars(&a, " ");
+        tam_sb_appenduint(&a, UINT64_MAX);
+        tam_sb_appendchars(&a, " ");
+        tam_sb_appendhex(&a, 0xbeef, true);
+        tam_sb_appendf(&b, "%lld %llu %X", (long long)INT64_MIN, (unsigned long long)UINT64_MAX, 0xbeef);
+        assert(a.len == b.len && strncmp(a.buf, b.buf, a.len) == 0);
+        tam_sb_deallocate(&a);
+        tam_sb_deallocate(&b);
+
+        const char *f = "[%s] %d%% of %zu items, %c=%5.2f (%x) %-4d|%ld";
+        tam_fmt_t fmt = tam_fmt_compile(f);
+        assert(fmt.count == 17);
+        a = tam_sb_new(), b = tam_sb_new();
+        for (int i = -2; i < 3; i++) {
+            tam_sb_appendfmt(&a, &fmt, "info", i, (usize)100, 'x', 3.14159, 255, i, -1234567890L);
+            tam_sb_appendf(&b, f, "info", i, (usize)100, 'x', 3.14159, 255, i, -1234567890L);
+        }
+        assert(a.len == b.len && strncmp(a.buf, b.buf, a.len) == 0);
+        tam_fmt_deallocate(&fmt);
+        tam_sb_deallocate(&a);
+        tam_sb_deallocate(&b);
+
+        fmt = tam_fmt_compile("%.3Lf|%Le");
+        assert(fmt.error == NULL);
+        a = tam_sb_new(), b = tam_sb_new();
+        tam_sb_appendfmt(&a, &fmt, 1.25L, 3.0L);
+        tam_sb_appendf(&b, "%.3Lf|%Le", 1.25L, 3.0L);
+        assert(a.len == b.len && strncmp(a.buf, b.buf, a.len) == 0);
+        tam_fmt_deallocate(&fmt);
+
+        // invalid formats are reported rather than aborting, and append nothing
+        const char *invalid[] = {"%Ld", "%*d", "abc %", "%k", "%0000000000000000000d"};
+        int pos[] = {2, 1, 4, 1, 0};
+        for (int i = 0; i < 5; i++) {
+            fmt = tam_fmt_compile(invalid[i]);
+            assert(fmt.error != NULL && fmt.error_pos == pos[i]);
+            tam_sb_appendfmt(&a, &fmt, 1);
+            tam_fmt_deallocate(&fmt);
+        }
+        assert(a.len == b.len);
+        tam_sb_deallocate(&a);
+        tam_sb_deallocate(&b);
+    }
+
+    // case conversion
+    {
+        tam_stringbuilder_t a = tam_sb_new();
+        tam_sb_append_lower(&a, tam_slice("Content-Type: "));
+        tam_sb_append_upper(&a, tam_slice("text/html; charset=utf-8"));
+        assert(tam_sl_eqstr(tam_sb_view(&a), "content-type: TEXT/HTML; CHARSET=UTF-8"));
+        tam_sb_deallocate(&a);
+    }
+
+    // type-generic appending
+    {
+        tam_stringbuilder_t a = tam_sb_new();
+        char c = '!';
+        tam_sb_append(&a, -42);
+        tam_sb_append(&a, c);
+        tam_sb_append(&a, 7u);
+        tam_sb_append(&a, " and ");
+        tam_sb_append(&a, slice("a slice "));
+        tam_sb_append(&a, 0.1);
+        tam_sb_append(&a, (bool)true);
+        assert(a.len == 25 && strncmp(a.buf, "-42!7 and a slice 0.1true", a.len) == 0);
+
+        a.len = 0;
+        isize cap = a.cap;
+        tam_sb_concat(&a, "x = ", (i64)-3, c, ", y = ", 2.5f, slice(", z = "), (u8)255);
+        assert(a.len == 25 && strncmp(a.buf, "x = -3!, y = 2.5, z = 255", a.len) == 0);
+        assert(a.cap == cap || a.cap >= 25);
+
+        a.len = 0;
+        bool yes = true, no = false;
+        tam_sb_concat(&a, yes, " ", no);
+        assert(a.len == 10 && strncmp(a.buf, "true false", a.len) == 0);
+
+        // doubles are written with the fewest digits that round-trip
+        f64 values[] = {0.1, 1.0 / 3.0, 0.1 + 0.2, 1e300, -2.5e-300, 123456789012345678.0};
+        const char *shortest[] = {"0.1",    "0.3333333333333333", "0.30000000000000004",
+                                  "1e+300", "-2.5e-300",          "1.2345678901234568e+17"};
+        for (int i = 0; i < 6; i++) {
+            a.len = 0;
+            tam_sb_appenddouble(&a, values[i]);
+            assert(tam_sl_eqstr(tam_sb_view(&a), shortest[i]));
+        }
+        tam_sb_deallocate(&a);
+    }
+
+    // taking ownership of the buffer
+    {
+        tam_stringbuilder_t a = tam_sb_new();
+        tam_sb_appendchars(&a, "Hello");
+        tam_slice_t view = tam_sb_view(&a);
+        assert(view.buf == a.buf && tam_sl_eqstr(view, "Hello"));
+
+        const char *orig = a.buf;
+        char *taken = tam_sb_take(&a, false);
+        assert(taken == orig && strcmp(taken, "Hello") == 0);
+        assert(a.buf == NULL && a.len == 0 && a.cap == 0);
+        tam_deallocate(taken);
+
+        tam_sb_appendchars(&a, "world");
+        taken = tam_sb_take(&a, true);
+        assert(strcmp(taken, "world") == 0);
+        tam_deallocate(taken);
+
+        taken = tam_sb_take(&a, true);
+        assert(strcmp(taken, "") == 0);
+        tam_deallocate(taken);
+    }
+
+    // growth by TAM_GROWTH_FACTOR, and large buffers, which are mapped (see memory.h)
+    {
+        tam_stringbuilder_t a = tam_sb_new();
+        for (int i = 0; i < 64; i++) {
+            isize cap = a.cap;
+            tam_sb_appendchars(&a, "0123456789abcdef");
+            if (cap > 0 && a.cap != cap && (usize)a.cap < TAM_MMAP_THRESHOLD) {
+                f64 target = cap * TAM_GROWTH_FACTOR > a.len + 1 ? cap * TAM_GROWTH_FACTOR : a.len + 1;
+                assert(a.cap >= target && a.cap < target + 16);
+            }
+        }
+
+        // reserving maps the buffer, but only the pages we write to are touched, so this is cheap
+        // even with the default threshold
+        a.len = 0;
+        tam_sb_appendchars(&a, "start");
+        tam_sb_reserve(&a, TAM_MMAP_THRESHOLD);
+        tam_sb_commit(&a, TAM_MMAP_THRESHOLD);
+        isize cap = a.cap;
+        char tail[8192];
+        memset(tail, 'x', sizeof(tail));
+        tail[sizeof(tail) - 1] = '!';
+        tam_sb_appendcharsn(&a, tail, sizeof(tail));
+        assert(a.cap >= cap * TAM_GROWTH_FACTOR);
+#ifdef TAM_HAVE_MMAP
+        assert(a.cap % 4096 == 0);
+#endif
+        isize len = a.len;
+        // the mapping is copied to the heap, so the string is freed like any other
+        char *taken = tam_sb_take(&a, false);
+        assert(strncmp(taken, "start", 5) == 0 && taken[len - 1] == '!' && taken[len] == '\0');
+        assert(a.buf == NULL && a.len == 0 && a.cap == 0);
+        tam_deallocate(taken);
+    }
+
+    // arena-backed builders
+    {
+        tam_arena_t arena = tam_arena_new(1024);
+        tam_stringbuilder_t a = tam_sb_new_arena(&arena);
+        tam_sb_appendchars(&a, "Hello");
+        const char *orig = a.buf;
+        for (int i = 0; i < 20; i++)
+            tam_sb_appendchars(&a, ", world");
+        // nothing else was allocated from the arena, so the buffer grew in place
+        assert(a.buf == orig);
+        assert(a.len == 5 + 20 * 7);
+
+        char *taken = tam_sb_take(&a, true);
+        assert(strncmp(taken, "Hello, world, world", 19) == 0);
+        assert(arena.ptr == taken + 5 + 20 * 7 + 1);
+
+        tam_stringbuilder_t b = tam_sb_new_arena(&arena);
+        tam_sb_appendf(&b, "%d", 42);
+        char *p = arena.ptr;
+        tam_sb_deallocate(&b);
+        assert(arena.ptr < p);
+        assert(arena.ptr == taken + 5 + 20 * 7 + 1);
+        tam_arena_dealloc(&arena);
+    }
+
+    // segmented builders
+    {
+        tam_segbuilder_t seg = tam_segb_new(8);
+        tam_stringbuilder_t a = tam_sb_new();
+        for (int i = 0; i < 10; i++) {
+            tam_segb_appendchars(&seg, "chunk ");
+            tam_sb_appendchars(&a, "chunk ");
+        }
+        tam_segb_appendslice(&seg, slice("and a slice that spans several chunks"));
+        tam_sb_appendchars(&a, "and a slice that spans several chunks");
+        assert(seg.len == (usize)a.len);
+        assert(seg.count == (int)(seg.len + 7) / 8);
+
+        int count;
+        const tam_iovec_t *iov = tam_segb_iovec(&seg, &count);
+        usize total = 0;
+        for (int i = 0; i < count; i++) {
+            assert(memcmp(iov[i].iov_base, a.buf + total, iov[i].iov_len) == 0);
+            total += iov[i].iov_len;
+        }
+        assert(total == seg.len);
+
+        char *flat = tam_segb_flatten(&seg);
+        assert(strlen(flat) == seg.len && strncmp(flat, a.buf, a.len) == 0);
+        tam_deallocate(flat);
+
+#if defined(__unix__) || defined(__APPLE__)
+        // enough chunks that writev is called more than once
+        for (int i = 0; i < 100; i++) {
+            tam_segb_appendchars(&seg, "0123456789");
+            tam_sb_appendchars(&a, "0123456789");
+        }
+        assert(seg.count > 64 && seg.len < 4096);
+        // small enough to fit in the pipe's buffer without a reader
+        int fds[2];
+        assert(pipe(fds) == 0);
+        assert(tam_segb_write(&seg, fds[1]) == (isize)seg.len);
+        close(fds[1]);
+        char *back = tam_allocate(char, seg.len + 1);
+        usize got = 0;
+        for (isize r; (r = read(fds[0], back + got, seg.len + 1 - got)) > 0;)
+            got += r;
+        close(fds[0]);
+        assert(got == seg.len && memcmp(back, a.buf, a.len) == 0);
+        tam_deallocate(back);
+#endif
+        tam_segb_deallocate(&seg);
+        tam_sb_deallocate(&a);
+    }
+
+    // streaming builders
+    {
+        FILE *f = tmpfile();
+        tam_stringbuilder_t a = tam_sb_new_file(f, 32);
+        for (int i = 0; i < 100; i++) {
+            tam_sb_appendf(&a, "line %d\n", i);
+            assert(a.len < 32);
+        }
+        assert(a.cap <= 64);
+        char big[100];
+        memset(big, 'x', sizeof(big));
+        tam_sb_appendcharsn(&a, big, sizeof(big));
+        tam_sb_appendchars(&a, "end");
+        assert(tam_sb_flush(&a));
+        assert(a.len == 0);
+
+        rewind(f);
+        char line[16];
+        for (int i = 0; i < 100; i++) {
+            char expected[16];
+            snprintf(expected, sizeof(expected), "line %d\n", i);
+            assert(fgets(line, sizeof(line), f) && strcmp(line, expected) == 0);
+        }
+        for (int i = 0; i < 100; i++)
+            assert(fgetc(f) == 'x');
+        assert(fgets(line, sizeof(line), f) && strcmp(line, "end") == 0);
+        tam_sb_deallocate(&a);
+        fclose(f);
+    }
+
+    // inline storage
+    {
+        TAM_SB_INLINE(a);
+        assert(a.buf == a_storage && a.cap == TAM_SB_INLINE_CAPACITY);
+        tam_sb_appendchars(&a, "short string");
+        assert(a.buf == a_storage);
+        char *taken = tam_sb_take(&a, true);
+        assert(taken != a_storage && strcmp(taken, "short string") == 0);
+        tam_deallocate(taken);
+
+        char storage[8];
+        tam_stringbuilder_t b = tam_sb_new_buffer(storage, sizeof(storage), NULL);
+        tam_sb_appendchars(&b, "1234567");
+        assert(b.buf == storage);
+        tam_sb_appendchars(&b, "89");
+        assert(b.buf != storage && b.len == 9 && strncmp(b.buf, "123456789", 9) == 0);
+        tam_sb_deallocate(&b);
+    }
+
+    // joining builders
+    {
+        tam_stringbuilder_t parts[16];
+        tam_stringbuilder_t expected = tam_sb_new();
+        for (int i = 0; i < 16; i++) {
+            parts[i] = tam_sb_new();
+            // uneven part sizes, some empty, totalling a few MB so that several threads are used
+            for (int j = 0; j < (i % 3) * 20000 * i; j++)
+                tam_sb_appendint(&parts[i], (i + j) % 10);
+            tam_sb_appendslice(&expected, tam_sb_view(&parts[i]));
+        }
+        tam_stringbuilder_t joined = tam_sb_new();
+        tam_sb_appendchars(&joined, "header:");
+        tam_sb_join_parallel(&joined, parts, 16, 4);
+        assert(joined.len == 7 + expected.len);
+        assert(strncmp(joined.buf, "header:", 7) == 0);
+        assert(memcmp(joined.buf + 7, expected.buf, expected.len) == 0);
+        for (int i = 0; i < 16; i++)
+            tam_sb_deallocate(&parts[i]);
+        tam_sb_deallocate(&joined);
+        tam_sb_deallocate(&expected);
+    }
+
+    // clearing and pooling
+    {
+        tam_stringbuilder_t a = tam_sb_acquire();
+        tam_sb_appendchars(&a, "some text to warm up the buffer");
+        isize cap = a.cap;
+        tam_sb_clear(&a);
+        assert(a.len == 0 && a.cap == cap && a.buf != NULL);
+
+        const char *buf = a.buf;
+        tam_sb_release(&a);
+        assert(a.buf == NULL && a.len == 0 && a.cap == 0);
+        tam_stringbuilder_t b = tam_sb_acquire();
+        assert(b.buf == buf && b.len == 0 && b.cap == cap);
+
+        // builders that grew too large are not retained
+        for (int i = 0; i <= TAM_SB_POOL_MAX_CAPACITY / 16; i++)
+            tam_sb_appendchars(&b, "0123456789abcdef");
+        tam_sb_release(&b);
+        b = tam_sb_acquire();
+        assert(b.buf == NULL);
+        tam_sb_release(&b);
+        tam_sb_pool_drain();
+    }
+
     tam_sb_deallocate(&sb);
     assert(sb.buf == NULL);
     assert(sb.len == 0);
@@ -182,6 +1820,49 @@ int tam_test_stringbuilders() {
 //
 #ifdef __cplusplus
 }
+
+// ### Type-generic append overloads for C++ {{{
+
+inline void tam_sb_append(tam_stringbuilder_t *sb, bool x) { tam_sb_appendbool(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, char x) { tam_sb_appendchar(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, signed char x) { tam_sb_appendint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, short x) { tam_sb_appendint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, int x) { tam_sb_appendint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, long x) { tam_sb_appendint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, long long x) { tam_sb_appendint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, unsigned char x) { tam_sb_appenduint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, unsigned short x) { tam_sb_appenduint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, unsigned int x) { tam_sb_appenduint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, unsigned long x) { tam_sb_appenduint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, unsigned long long x) { tam_sb_appenduint(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, float x) { tam_sb_appenddouble(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, double x) { tam_sb_appenddouble(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, const char *x) { tam_sb_appendchars(sb, x); }
+inline void tam_sb_append(tam_stringbuilder_t *sb, tam_slice_t x) { tam_sb_appendslice(sb, x); }
+
+inline tam_sb_arg_t tam_sb_arg(bool x) { return tam_sb_arg_bool(x); }
+inline tam_sb_arg_t tam_sb_arg(char x) { return tam_sb_arg_char(x); }
+inline tam_sb_arg_t tam_sb_arg(signed char x) { return tam_sb_arg_int(x); }
+inline tam_sb_arg_t tam_sb_arg(short x) { return tam_sb_arg_int(x); }
+inline tam_sb_arg_t tam_sb_arg(int x) { return tam_sb_arg_int(x); }
+inline tam_sb_arg_t tam_sb_arg(long x) { return tam_sb_arg_int(x); }
+inline tam_sb_arg_t tam_sb_arg(long long x) { return tam_sb_arg_int(x); }
+inline tam_sb_arg_t tam_sb_arg(unsigned char x) { return tam_sb_arg_uint(x); }
+inline tam_sb_arg_t tam_sb_arg(unsigned short x) { return tam_sb_arg_uint(x); }
+inline tam_sb_arg_t tam_sb_arg(unsigned int x) { return tam_sb_arg_uint(x); }
+inline tam_sb_arg_t tam_sb_arg(unsigned long x) { return tam_sb_arg_uint(x); }
+inline tam_sb_arg_t tam_sb_arg(unsigned long long x) { return tam_sb_arg_uint(x); }
+inline tam_sb_arg_t tam_sb_arg(float x) { return tam_sb_arg_double(x); }
+inline tam_sb_arg_t tam_sb_arg(double x) { return tam_sb_arg_double(x); }
+inline tam_sb_arg_t tam_sb_arg(const char *x) { return tam_sb_arg_chars(x); }
+inline tam_sb_arg_t tam_sb_arg(tam_slice_t x) { return tam_sb_arg_slice(x); }
+
+template <typename... Args> inline void tam_sb_concat(tam_stringbuilder_t *sb, Args... args) {
+    const tam_sb_arg_t list[] = {tam_sb_arg(args)...};
+    tam_sb_concatn(sb, list, sizeof...(Args));
+}
+
+// end type-generic append overloads }}}
 #endif
 
 #endif // TAM_STRINGBUILDER_H
@@ -0,0 +1,526 @@
+#ifndef TAM_SUFFIX_H
+#define TAM_SUFFIX_H
+
+// TAM suffix arrays
+//
+// Suffix arrays index every substring of a static text: the substrings starting with a pattern are the
+// prefixes of one range of sorted suffixes, found by binary search instead of scanning the text.
+
+#include <tam/memory.h>
+#include <tam/simd.h>
+#include <tam/slices.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*** ## Suffix array declarations *** {{{
+
+typedef struct tam_suffix_array_t {
+    // the text, which must outlive the suffix array
+    const char *text;
+    usize len;
+    // whether the indices below are u64s, for texts of 4 GiB or more, instead of u32s
+    bool wide;
+    // the starting positions of the suffixes of the text, in sorted order
+    union {
+        u32 *sa32;
+        u64 *sa64;
+    };
+    // lcp[i] is the length of the common prefix of suffixes i - 1 and i in sorted order, and lcp[0] is 0.
+    // NULL until built by `tam_suffix_array_build_lcp`.
+    union {
+        u32 *lcp32;
+        u64 *lcp64;
+    };
+} tam_suffix_array_t;
+
+/*
+ * Build the suffix array of a text with the linear-time SA-IS algorithm, allocating it in `arena`.
+ * The text is not copied.
+ * SA-IS sorts the suffixes that start a run of smaller suffixes (LMS suffixes) by sorting a string at most half
+ * as long, recursively, and then places all other suffixes in order from them in two passes over the array.
+ * The arena needs room for `tam_suffix_array_arena_bytes(len, false, false)` bytes: the array takes 4 bytes per
+ * byte of text, and building it takes about 2.25 bytes more that are released afterwards.
+ */
+tam_suffix_array_t tam_suffix_array_build(tam_slice_t text, tam_arena_t *arena);
+
+/*
+ * Build the suffix array of a text of any length, with u64 indices, which take 8 bytes per byte of text.
+ */
+tam_suffix_array_t tam_suffix_array_build_wide(const char *text, usize len, tam_arena_t *arena);
+
+/*
+ * Build the LCP array of a suffix array with Kasai's algorithm, in linear time, allocating it in `arena`.
+ * It takes one index per byte of text, and building it takes the same again, which is released afterwards.
+ */
+void tam_suffix_array_build_lcp(tam_suffix_array_t *sa, tam_arena_t *arena);
+
+/*
+ * The arena space in bytes that building a suffix array of a text of `len` bytes, and then its LCP array if
+ * `lcp`, needs.
+ */
+usize tam_suffix_array_arena_bytes(usize len, bool wide, bool lcp);
+
+// The start of the i-th suffix in sorted order
+usize tam_suffix_array_get(const tam_suffix_array_t *sa, usize i);
+
+// The length of the common prefix of the i-th suffix in sorted order and the one before it
+usize tam_suffix_array_lcp(const tam_suffix_array_t *sa, usize i);
+
+/*
+ * Find the occurrences of `pattern` in the text: they start at the suffixes from `*first` to `*first` + count in
+ * sorted order, where count is returned. An empty pattern occurs at every position.
+ * The binary searches skip the bytes of the pattern that both bounds of the range are known to share.
+ */
+usize tam_suffix_array_find(const tam_suffix_array_t *sa, tam_slice_t pattern, usize *first);
+
+// The number of occurrences of `pattern` in the text
+usize tam_suffix_array_count(const tam_suffix_array_t *sa, tam_slice_t pattern);
+
+/*
+ * Write the positions of up to `max` occurrences of `pattern` to `out`, in the order of their suffixes rather
+ * than of their positions, and return the number of occurrences, which may be more than `max`.
+ */
+usize tam_suffix_array_locate(const tam_suffix_array_t *sa, tam_slice_t pattern, usize *out, usize max);
+
+#if defined(USING_NAMESPACE_TAM) || defined(USING_TAM_SUFFIX) ///{{{
+typedef tam_suffix_array_t suffix_array_t;
+#define suffix_array_build tam_suffix_array_build
+#define suffix_array_build_wide tam_suffix_array_build_wide
+#define suffix_array_build_lcp tam_suffix_array_build_lcp
+#define suffix_array_arena_bytes tam_suffix_array_arena_bytes
+#define suffix_array_get tam_suffix_array_get
+#define suffix_array_lcp tam_suffix_array_lcp
+#define suffix_array_find tam_suffix_array_find
+#define suffix_array_count tam_suffix_array_count
+#define suffix_array_locate tam_suffix_array_locate
+#endif // end suffix array namespace }}}
+
+// end suffix array declarations }}}
+
+#if defined(TAM_IMPLEMENTATION) || defined(TAM_SUFFIX_IMPLEMENTATION)
+
+#include <assert.h>
+#include <string.h>
+
+// ### Suffix array construction {{{
+
+// The length of the common prefix of a and b, up to max, compared 8 bytes at a time
+static usize tam_suffix_common(const char *a, const char *b, usize max) {
+    usize i = 0;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= max; i += 8) {
+        u64 x = tam_load_u64(a + i) ^ tam_load_u64(b + i);
+        if (x)
+            return i + tam_ctz64(x) / 8;
+    }
+#endif
+    while (i < max && a[i] == b[i])
+        i++;
+    return i;
+}
+
+// The type bits, characters and LMS positions of the string being sorted by SA-IS, which are `t`, `s` and `n`
+// in scope. The characters of the top level are the bytes of the text plus one, followed by a 0 sentinel, which
+// leaves the text unmodified, and those of the lower levels are indices.
+#define TAM_SAIS_TGET(i) ((t[(i) / 8] >> ((i) % 8)) & 1)
+#define TAM_SAIS_TSET(i, b) (t[(i) / 8] = (u8)((t[(i) / 8] & ~(1u << ((i) % 8))) | ((unsigned)(b) << ((i) % 8))))
+#define TAM_SAIS_IS_LMS(i) ((i) > 0 && TAM_SAIS_TGET(i) && !TAM_SAIS_TGET((i) - 1))
+#define TAM_SAIS_CHR(T, i) (bytes ? ((i) == n - 1 ? 0 : (usize)((const u8 *)s)[i] + 1) : (usize)((const T *)s)[i])
+
+// SA-IS and Kasai's algorithm for indices of type T
+#define TAM_SUFFIX_FUNCS(T)                                                                                            \
+    static void tam_sais_##T##_buckets(const void *s, bool bytes, T *bkt, T n, T K, bool end) {                        \
+        for (T i = 0; i <= K; i++)                                                                                     \
+            bkt[i] = 0;                                                                                                \
+        for (T i = 0; i < n; i++)                                                                                      \
+            bkt[TAM_SAIS_CHR(T, i)]++;                                                                                 \
+        T sum = 0;                                                                                                     \
+        for (T i = 0; i <= K; i++) {                                                                                   \
+            sum += bkt[i];                                                                                             \
+            bkt[i] = end ? sum : sum - bkt[i];                                                                         \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* place the L-type suffixes, from the ones before the suffixes already placed */                                  \
+    static void tam_sais_##T##_induce_l(const u8 *t, T *SA, const void *s, bool bytes, T *bkt, T n, T K) {             \
+        tam_sais_##T##_buckets(s, bytes, bkt, n, K, false);                                                            \
+        for (T i = 0; i < n; i++) {                                                                                    \
+            T j = SA[i];                                                                                               \
+            if (j != (T)-1 && j > 0 && !TAM_SAIS_TGET(j - 1))                                                          \
+                SA[bkt[TAM_SAIS_CHR(T, j - 1)]++] = j - 1;                                                             \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* place the S-type suffixes, from the ends of the buckets backwards */                                            \
+    static void tam_sais_##T##_induce_s(const u8 *t, T *SA, const void *s, bool bytes, T *bkt, T n, T K) {             \
+        tam_sais_##T##_buckets(s, bytes, bkt, n, K, true);                                                             \
+        for (T i = n; i-- > 0;) {                                                                                      \
+            T j = SA[i];                                                                                               \
+            if (j != (T)-1 && j > 0 && TAM_SAIS_TGET(j - 1))                                                           \
+                SA[--bkt[TAM_SAIS_CHR(T, j - 1)]] = j - 1;                                                             \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* the suffix array of `s`, n characters in [0, K] ending with a unique 0 */                                       \
+    static void tam_sais_##T(const void *s, bool bytes, T *SA, T n, T K, tam_arena_t *arena) {                         \
+        /* whether each suffix is S-type (smaller than the next suffix) or L-type, one bit each */                     \
+        isize tlen = n / (8 * sizeof(T)) + 1;                                                                          \
+        u8 *t = (u8 *)tam_arena_alloc(arena, T, tlen);                                                                 \
+        TAM_SAIS_TSET(n - 2, 0);                                                                                       \
+        TAM_SAIS_TSET(n - 1, 1);                                                                                       \
+        for (T i = n - 2; i-- > 0;) {                                                                                  \
+            usize c = TAM_SAIS_CHR(T, i), next = TAM_SAIS_CHR(T, i + 1);                                               \
+            TAM_SAIS_TSET(i, c < next || (c == next && TAM_SAIS_TGET(i + 1)));                                         \
+        }                                                                                                              \
+                                                                                                                       \
+        /* sort the LMS substrings by placing the LMS suffixes at the ends of their buckets and inducing */            \
+        T *bkt = tam_arena_alloc(arena, T, K + 1);                                                                     \
+        tam_sais_##T##_buckets(s, bytes, bkt, n, K, true);                                                             \
+        for (T i = 0; i < n; i++)                                                                                      \
+            SA[i] = (T)-1;                                                                                             \
+        for (T i = 1; i < n; i++) {                                                                                    \
+            if (TAM_SAIS_IS_LMS(i))                                                                                    \
+                SA[--bkt[TAM_SAIS_CHR(T, i)]] = i;                                                                     \
+        }                                                                                                              \
+        tam_sais_##T##_induce_l(t, SA, s, bytes, bkt, n, K);                                                           \
+        tam_sais_##T##_induce_s(t, SA, s, bytes, bkt, n, K);                                                           \
+        tam_arena_release(arena, bkt, (K + 1) * sizeof(T));                                                            \
+                                                                                                                       \
+        /* name the sorted LMS substrings, equal substrings getting equal names. At most every other suffix is */      \
+        /* LMS, so the sorted ones fit in the first half of SA and their names, by position / 2, in the second. */     \
+        T n1 = 0;                                                                                                      \
+        for (T i = 0; i < n; i++) {                                                                                    \
+            if (TAM_SAIS_IS_LMS(SA[i]))                                                                                \
+                SA[n1++] = SA[i];                                                                                      \
+        }                                                                                                              \
+        for (T i = n1; i < n; i++)                                                                                     \
+            SA[i] = (T)-1;                                                                                             \
+        T name = 0, prev = (T)-1;                                                                                      \
+        for (T i = 0; i < n1; i++) {                                                                                   \
+            T pos = SA[i];                                                                                             \
+            bool diff = false;                                                                                         \
+            for (T d = 0; d < n; d++) {                                                                                \
+                if (prev == (T)-1 || TAM_SAIS_CHR(T, pos + d) != TAM_SAIS_CHR(T, prev + d) ||                          \
+                    TAM_SAIS_TGET(pos + d) != TAM_SAIS_TGET(prev + d)) {                                               \
+                    diff = true;                                                                                       \
+                    break;                                                                                             \
+                }                                                                                                      \
+                if (d > 0 && (TAM_SAIS_IS_LMS(pos + d) || TAM_SAIS_IS_LMS(prev + d)))                                  \
+                    break;                                                                                             \
+            }                                                                                                          \
+            if (diff) {                                                                                                \
+                name++;                                                                                                \
+                prev = pos;                                                                                            \
+            }                                                                                                          \
+            SA[n1 + pos / 2] = name - 1;                                                                               \
+        }                                                                                                              \
+        for (T i = n, j = n; i-- > n1;) {                                                                              \
+            if (SA[i] != (T)-1)                                                                                        \
+                SA[--j] = SA[i];                                                                                       \
+        }                                                                                                              \
+                                                                                                                       \
+        /* sort the LMS suffixes by the suffixes of the string of names, recursing if the names are not unique */      \
+        T *SA1 = SA, *s1 = SA + n - n1;                                                                                \
+        if (name < n1) {                                                                                               \
+            tam_sais_##T(s1, false, SA1, n1, name - 1, arena);                                                         \
+        } else {                                                                                                       \
+            for (T i = 0; i < n1; i++)                                                                                 \
+                SA1[s1[i]] = i;                                                                                        \
+        }                                                                                                              \
+                                                                                                                       \
+        /* place the sorted LMS suffixes at the ends of their buckets, and induce the others from them */              \
+        bkt = tam_arena_alloc(arena, T, K + 1);                                                                        \
+        tam_sais_##T##_buckets(s, bytes, bkt, n, K, true);                                                             \
+        for (T i = 1, j = 0; i < n; i++) {                                                                             \
+            if (TAM_SAIS_IS_LMS(i))                                                                                    \
+                s1[j++] = i;                                                                                           \
+        }                                                                                                              \
+        for (T i = 0; i < n1; i++)                                                                                     \
+            SA1[i] = s1[SA1[i]];                                                                                       \
+        for (T i = n1; i < n; i++)                                                                                     \
+            SA[i] = (T)-1;                                                                                             \
+        for (T i = n1; i-- > 0;) {                                                                                     \
+            T j = SA[i];                                                                                               \
+            SA[i] = (T)-1;                                                                                             \
+            SA[--bkt[TAM_SAIS_CHR(T, j)]] = j;                                                                         \
+        }                                                                                                              \
+        tam_sais_##T##_induce_l(t, SA, s, bytes, bkt, n, K);                                                           \
+        tam_sais_##T##_induce_s(t, SA, s, bytes, bkt, n, K);                                                           \
+        tam_arena_release(arena, bkt, (K + 1) * sizeof(T));                                                            \
+        tam_arena_release(arena, t, tlen * sizeof(T));                                                                 \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Kasai's algorithm: the common prefix of a suffix and the one before it in sorted order is at most one */        \
+    /* shorter than that of the suffix one position later in the text, so each comparison resumes from there */        \
+    static void tam_suffix_lcp_##T(const char *text, usize len, const T *SA, T *lcp, T *rank) {                        \
+        for (usize i = 0; i < len; i++)                                                                                \
+            rank[SA[i]] = i;                                                                                           \
+        usize h = 0;                                                                                                   \
+        lcp[0] = 0;                                                                                                    \
+        for (usize i = 0; i < len; i++) {                                                                              \
+            if (rank[i] == 0) {                                                                                        \
+                h = 0;                                                                                                 \
+                continue;                                                                                              \
+            }                                                                                                          \
+            usize j = SA[rank[i] - 1];                                                                                 \
+            usize max = len - (i > j ? i : j);                                                                         \
+            h += tam_suffix_common(text + i + h, text + j + h, max - h);                                               \
+            lcp[rank[i]] = h;                                                                                          \
+            if (h > 0)                                                                                                 \
+                h--;                                                                                                   \
+        }                                                                                                              \
+    }
+
+TAM_SUFFIX_FUNCS(u32)
+TAM_SUFFIX_FUNCS(u64)
+
+usize tam_suffix_array_arena_bytes(usize len, bool wide, bool lcp) {
+    usize size = wide ? sizeof(u64) : sizeof(u32);
+    // the array with the sentinel's suffix, the largest bucket array (of the bytes, or of at most half as many
+    // names as there are characters), the type bits of each level of the recursion and their alignment
+    usize buckets = len / 2 + 2 > 257 ? len / 2 + 2 : 257;
+    usize bytes = (len + 1 + buckets) * size + len / 4 + 64 * size + 64;
+    if (lcp)
+        bytes += 2 * len * size;
+    return bytes;
+}
+
+static tam_suffix_array_t tam_suffix_array_build_n(const char *text, usize len, bool wide, tam_arena_t *arena) {
+    tam_suffix_array_t sa = {.text = text, .len = len, .wide = wide};
+    if (len == 0)
+        return sa;
+    // the first suffix in order is the sentinel's, which is not part of the text
+    if (wide) {
+        u64 *SA = tam_arena_alloc(arena, u64, len + 1);
+        tam_sais_u64(text, true, SA, len + 1, 256, arena);
+        sa.sa64 = SA + 1;
+    } else {
+        assert(len < UINT32_MAX);
+        u32 *SA = tam_arena_alloc(arena, u32, len + 1);
+        tam_sais_u32(text, true, SA, len + 1, 256, arena);
+        sa.sa32 = SA + 1;
+    }
+    return sa;
+}
+
+tam_suffix_array_t tam_suffix_array_build(tam_slice_t text, tam_arena_t *arena) {
+    return tam_suffix_array_build_n(text.buf, text.len, false, arena);
+}
+
+tam_suffix_array_t tam_suffix_array_build_wide(const char *text, usize len, tam_arena_t *arena) {
+    return tam_suffix_array_build_n(text, len, true, arena);
+}
+
+void tam_suffix_array_build_lcp(tam_suffix_array_t *sa, tam_arena_t *arena) {
+    if (sa->len == 0)
+        return;
+    if (sa->wide) {
+        sa->lcp64 = tam_arena_alloc(arena, u64, sa->len);
+        u64 *rank = tam_arena_alloc(arena, u64, sa->len);
+        tam_suffix_lcp_u64(sa->text, sa->len, sa->sa64, sa->lcp64, rank);
+        tam_arena_release(arena, rank, sa->len * sizeof(u64));
+    } else {
+        sa->lcp32 = tam_arena_alloc(arena, u32, sa->len);
+        u32 *rank = tam_arena_alloc(arena, u32, sa->len);
+        tam_suffix_lcp_u32(sa->text, sa->len, sa->sa32, sa->lcp32, rank);
+        tam_arena_release(arena, rank, sa->len * sizeof(u32));
+    }
+}
+
+usize tam_suffix_array_get(const tam_suffix_array_t *sa, usize i) { return sa->wide ? sa->sa64[i] : sa->sa32[i]; }
+
+usize tam_suffix_array_lcp(const tam_suffix_array_t *sa, usize i) { return sa->wide ? sa->lcp64[i] : sa->lcp32[i]; }
+
+// end suffix array construction }}}
+
+// ### Suffix array search {{{
+
+// Compare the suffix at `pos` with the pattern, which share their first `skip` bytes, setting `*common` to the
+// length of their common prefix. Returns 0 if the pattern is a prefix of the suffix.
+static int tam_suffix_cmp(const tam_suffix_array_t *sa, usize pos, tam_slice_t pattern, usize skip, usize *common) {
+    usize rest = sa->len - pos;
+    usize max = rest < (usize)pattern.len ? rest : (usize)pattern.len;
+    usize l = skip + tam_suffix_common(sa->text + pos + skip, pattern.buf + skip, max - skip);
+    *common = l;
+    if (l == (usize)pattern.len)
+        return 0;
+    if (l == rest)
+        return -1;
+    return (u8)sa->text[pos + l] < (u8)pattern.buf[l] ? -1 : 1;
+}
+
+usize tam_suffix_array_find(const tam_suffix_array_t *sa, tam_slice_t pattern, usize *first) {
+    // the suffixes between two bounds share at least as many bytes with the pattern as the bounds both do
+    usize lo = 0, hi = sa->len, lo_common = 0, hi_common = 0, common;
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        usize skip = lo_common < hi_common ? lo_common : hi_common;
+        if (tam_suffix_cmp(sa, tam_suffix_array_get(sa, mid), pattern, skip, &common) < 0) {
+            lo = mid + 1;
+            lo_common = common;
+        } else {
+            hi = mid;
+            hi_common = common;
+        }
+    }
+    *first = lo;
+    // then the end of the suffixes that start with the pattern
+    hi = sa->len;
+    hi_common = 0;
+    lo_common = pattern.len;
+    while (lo < hi) {
+        usize mid = lo + (hi - lo) / 2;
+        usize skip = lo_common < hi_common ? lo_common : hi_common;
+        if (tam_suffix_cmp(sa, tam_suffix_array_get(sa, mid), pattern, skip, &common) <= 0) {
+            lo = mid + 1;
+            lo_common = common;
+        } else {
+            hi = mid;
+            hi_common = common;
+        }
+    }
+    return lo - *first;
+}
+
+usize tam_suffix_array_count(const tam_suffix_array_t *sa, tam_slice_t pattern) {
+    usize first;
+    return tam_suffix_array_find(sa, pattern, &first);
+}
+
+usize tam_suffix_array_locate(const tam_suffix_array_t *sa, tam_slice_t pattern, usize *out, usize max) {
+    usize first;
+    usize count = tam_suffix_array_find(sa, pattern, &first);
+    for (usize i = 0; i < count && i < max; i++)
+        out[i] = tam_suffix_array_get(sa, first + i);
+    return count;
+}
+
+// end suffix array search }}}
+
+#if defined(TAM_TEST)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ### Suffix array tests {{{
+
+// Check a suffix array and its LCP array against comparisons of whole suffixes, and its searches against
+// counting occurrences at every position
+static void tam_test_check_suffix_array(const tam_suffix_array_t *sa) {
+    const char *text = sa->text;
+    usize len = sa->len;
+    bool *seen = tam_allocate(bool, len + 1);
+    memset(seen, 0, len + 1);
+    for (usize i = 0; i < len; i++) {
+        usize p = tam_suffix_array_get(sa, i);
+        assert(p < len && !seen[p]);
+        seen[p] = true;
+        if (i == 0) {
+            assert(tam_suffix_array_lcp(sa, 0) == 0);
+            continue;
+        }
+        usize q = tam_suffix_array_get(sa, i - 1);
+        usize l = 0;
+        while (p + l < len && q + l < len && text[p + l] == text[q + l])
+            l++;
+        assert(tam_suffix_array_lcp(sa, i) == l);
+        // the previous suffix is smaller: it differs with a smaller byte, or ends first
+        assert(q + l == len || (p + l < len && (u8)text[q + l] < (u8)text[p + l]));
+    }
+    tam_deallocate(seen);
+
+    // patterns taken from the text and their variations, which may not occur
+    usize max_len = len < 12 ? len : 12;
+    for (usize start = 0; start < len; start += 1 + len / 50) {
+        for (usize plen = 0; plen <= max_len && start + plen <= len; plen++) {
+            char pat[13];
+            memcpy(pat, text + start, plen);
+            for (int variant = 0; variant < 2; variant++) {
+                if (variant == 1 && plen > 0)
+                    pat[plen - 1] ^= 1;
+                tam_slice_t p = tam_slice_n(pat, plen);
+                usize expected = 0;
+                for (usize i = 0; i + plen <= len; i++)
+                    expected += memcmp(text + i, pat, plen) == 0;
+                if (plen == 0)
+                    expected = len;
+                usize out[4];
+                usize count = tam_suffix_array_locate(sa, p, out, 4);
+                assert(count == expected && tam_suffix_array_count(sa, p) == expected);
+                for (usize i = 0; i < count && i < 4; i++)
+                    assert(out[i] + plen <= len && memcmp(text + out[i], pat, plen) == 0);
+            }
+        }
+    }
+}
+
+int tam_test_suffix_array() {
+    const char *fixed[] = {"", "a", "aa", "ab", "ba", "mississippi", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+                           "abababababababababababababab", "banana\0banana", "\xff\x00\xff\x00\x01\xfe"};
+    int fixed_len[] = {0, 1, 2, 2, 2, 11, 34, 28, 13, 6};
+    for (int i = 0; i < 10; i++) {
+        for (int wide = 0; wide < 2; wide++) {
+            tam_arena_t arena = tam_arena_new(1 << 12);
+            tam_suffix_array_t sa = wide ? tam_suffix_array_build_wide(fixed[i], fixed_len[i], &arena)
+                                         : tam_suffix_array_build(tam_slice_n(fixed[i], fixed_len[i]), &arena);
+            tam_suffix_array_build_lcp(&sa, &arena);
+            tam_test_check_suffix_array(&sa);
+            tam_arena_dealloc(&arena);
+        }
+    }
+    tam_arena_t arena = tam_arena_new(1 << 12);
+    tam_suffix_array_t banana = tam_suffix_array_build(tam_slice("banana"), &arena);
+    tam_suffix_array_build_lcp(&banana, &arena);
+    u32 expected_sa[] = {5, 3, 1, 0, 4, 2}, expected_lcp[] = {0, 1, 3, 0, 0, 2};
+    for (int i = 0; i < 6; i++)
+        assert(banana.sa32[i] == expected_sa[i] && banana.lcp32[i] == expected_lcp[i]);
+    assert(tam_suffix_array_count(&banana, tam_slice("ana")) == 2);
+    assert(tam_suffix_array_count(&banana, tam_slice("nab")) == 0);
+    assert(tam_suffix_array_count(&banana, tam_slice("bananas")) == 0);
+    tam_arena_dealloc(&arena);
+
+    // random texts over small alphabets, which recurse deeply, and large ones
+    u64 r = 88172645463325252ull;
+    usize lens[] = {3, 17, 100, 1000, 20000};
+    const char *alphabets[] = {"ab", "abc\0", "acgt", "\x01\x02\x03\x04\x05\x06\x07\x08\x80\xff"};
+    int alphabet_len[] = {2, 4, 4, 10};
+    for (int k = 0; k < 5; k++) {
+        for (int a = 0; a < 4; a++) {
+            usize len = lens[k];
+            char *text = tam_allocate(char, len);
+            for (usize i = 0; i < len; i++) {
+                r ^= r << 13, r ^= r >> 7, r ^= r << 17;
+                // repeat earlier stretches of the text, as real texts do
+                if (i > 50 && r % 4 == 0)
+                    text[i] = text[i - 1 - (r >> 8) % 50];
+                else
+                    text[i] = alphabets[a][(r >> 16) % alphabet_len[a]];
+            }
+            for (int wide = 0; wide < 2; wide++) {
+                arena = tam_arena_new(tam_suffix_array_arena_bytes(len, wide, true));
+                tam_suffix_array_t sa = wide ? tam_suffix_array_build_wide(text, len, &arena)
+                                             : tam_suffix_array_build(tam_slice_n(text, len), &arena);
+                tam_suffix_array_build_lcp(&sa, &arena);
+                tam_test_check_suffix_array(&sa);
+                tam_arena_dealloc(&arena);
+            }
+            tam_deallocate(text);
+        }
+    }
+
+    printf("\x1b[1;32m" "Tests passed!" "\x1b[0m\n");
+    return 0;
+}
+// end suffix array tests }}}
+
+#endif // TAM_TEST
+
+#endif // TAM_SUFFIX_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TAM_SUFFIX_H